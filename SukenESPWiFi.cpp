@@ -1,10 +1,115 @@
 #include "SukenESPWiFi.h"
+#include <WebServer.h>
+#include "SukenWiFiDns.h"
+#include "SukenWiFiHttp.h"
+#include "esp_heap_caps.h"
+#include "esp_netif.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/dhcp.h"
+#include "lwip/dns.h"
 
 // Define the global instance with a default device name (backward compatibility)
 SukenWiFiLib::SukenESPWiFi SukenWiFi("ESP-WiFi-Manager");
 
 namespace SukenWiFiLib {
 
+namespace {
+
+// RTC メモリに保持する起動プロファイル（ウォームブート/ディープスリープを跨いで残る）
+constexpr uint32_t BOOT_RECORD_MAGIC = 0x53425046; // "SBPF"
+
+struct RtcBootRecord {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint8_t profile[sizeof(BootProfile)];
+    uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR RtcBootRecord rtcBootRecord;
+
+// 前回の DHCP リース（再接続/ディープスリープ復帰時に DHCP を待たずに使う）
+constexpr uint32_t LEASE_RECORD_MAGIC = 0x534C5345; // "SLSE"
+
+struct RtcLeaseRecord {
+    uint32_t magic;
+    uint32_t ssidHash;
+    uint32_t ip;
+    uint32_t subnet;
+    uint32_t gateway;
+    uint32_t dns1;
+    uint32_t dns2;
+    uint32_t obtainedAt;   // time() 基準の秒（RTC タイマーでディープスリープ中も進む）
+    uint32_t leaseSec;
+    uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR RtcLeaseRecord rtcLeaseRecord;
+
+// ディープスリープ復帰時の接続先（SPIFFS を使わずに接続するため）
+constexpr uint32_t CONNECTION_RECORD_MAGIC = 0x53434E52; // "SCNR"
+constexpr uint8_t CONNECTION_FLAG_STATIC_IP = 0x01;
+constexpr uint8_t CONNECTION_FLAG_IPV6 = 0x02;
+constexpr uint8_t CONNECTION_FLAG_PMK = 0x04;
+
+struct RtcConnectionRecord {
+    uint32_t magic;
+    char ssid[33];
+    char key[65];         // パスフレーズまたは PMK（64桁の16進）
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t flags;
+    uint32_t staticIP;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+    uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR RtcConnectionRecord rtcConnectionRecord;
+
+// ポータルの WebServer。SSE の接続を引き取れるようにする
+// ハンドラが応答を返しても接続が開いていると、WebServer は切断を最大 HTTP_MAX_CLOSE_WAIT 待ち、
+// その間ほかのクライアントを処理しない。引き取った後は切断済みに見えるので、すぐ次へ進む
+class PortalServer : public WebServer {
+public:
+    explicit PortalServer(int port) : WebServer(port) {}
+
+    WiFiClient detachClient() {
+        WiFiClient client = _currentClient;
+        _currentClient = WiFiClient();
+        return client;
+    }
+};
+
+// イベントタスクから loop() へ渡すリンクの変化（loop() が呼ばれるまでの間に溜まる分）
+constexpr UBaseType_t LINK_EVENT_QUEUE_LENGTH = 8;
+constexpr uint8_t LINK_EVENT_DOWN = 0;
+constexpr uint8_t LINK_EVENT_UP = 1;
+
+uint32_t fnv1a(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+template <typename Record>
+uint32_t recordChecksum(const Record& record) {
+    // checksum フィールド自体は除外
+    return fnv1a(&record, offsetof(Record, checksum));
+}
+
+bool connectionRecordValid() {
+    return rtcConnectionRecord.magic == CONNECTION_RECORD_MAGIC &&
+           rtcConnectionRecord.checksum == recordChecksum(rtcConnectionRecord) &&
+           rtcConnectionRecord.ssid[0] != 0;
+}
+
+} // namespace
+
 // Singleton accessor
 SukenESPWiFi& getInstance() {
     return SukenWiFi;
@@ -18,6 +123,8 @@ SukenESPWiFi::SukenESPWiFi(const String& deviceName)
       setupMode_(false),
       blockSetup_(false),
       taskHandle_(nullptr) {
+    bootProfileMutex_ = xSemaphoreCreateMutex();
+    linkEvents_ = xQueueCreate(LINK_EVENT_QUEUE_LENGTH, sizeof(uint8_t));
     if (isValidHostname(deviceName)) {
         deviceName_ = deviceName;
         wifiName_ = deviceName;
@@ -26,6 +133,17 @@ SukenESPWiFi::SukenESPWiFi(const String& deviceName)
         deviceName_ = "ESP-WiFi-Manager";
         wifiName_ = "ESP-WiFi-Manager";
     }
+    transports_.emplace_back(new WebPortalTransport(
+        [this]() { startAccessPoint(); },
+        [this]() { stopPortal(); },
+        [this]() { return setupMode_ && server_ != nullptr; }));
+}
+
+// http_（std::unique_ptr<HttpSession>）の破棄には完全型が要るため、デストラクタはこのファイルで定義する。
+// ポータルの WebServer / CaptiveDns はポータルタスクが使っている間は破棄できないので、stopPortal() に任せる
+SukenESPWiFi::~SukenESPWiFi() {
+    if (bootProfileMutex_) vSemaphoreDelete(bootProfileMutex_);
+    if (linkEvents_) vQueueDelete(linkEvents_);
 }
 
 void SukenESPWiFi::onClientConnect(CallbackFunction callback) {
@@ -56,50 +174,207 @@ void SukenESPWiFi::init(const String& deviceName) {
 }
 
 void SukenESPWiFi::init() {
+    beginBootProfile();
+    // レスポンダを開始し直しても同じ内容で登録される
+    mdns_.addService("http", "tcp", DEFAULT_HTTP_PORT);
+    mdns_.setTxt("http", "tcp", "mac", getMACAddress());
     WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info){
         if (event == ARDUINO_EVENT_WIFI_AP_STACONNECTED) {
             Serial.println("Client connected to AP");
+            recordAPClient(info.wifi_ap_staconnected.mac, true);
             if (clientConnectedCallback_) clientConnectedCallback_();
-        } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
-            Serial.println("WiFi connected (GOT_IP)");
-            if (!wasEverConnected_) wasEverConnected_ = true;
-            if (connectedCallback_) connectedCallback_();
-            if (disconnectedSinceLastConnect_) {
-                disconnectedSinceLastConnect_ = false;
-                if (reconnectedCallback_) reconnectedCallback_();
+        } else if (event == ARDUINO_EVENT_WIFI_AP_STADISCONNECTED) {
+            recordAPClient(info.wifi_ap_stadisconnected.mac, false);
+        } else if (event == ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED) {
+            recordAPClientIP(IPAddress(info.wifi_ap_staipassigned.ip.addr));
+        } else if (event == ARDUINO_EVENT_WIFI_AP_START) {
+            apStarted_ = true;
+        } else if (event == ARDUINO_EVENT_WIFI_AP_STOP) {
+            apStarted_ = false;
+            apStats_.clients = 0;
+            for (size_t i = 0; i < MAX_AP_CLIENT_RECORDS; ++i) {
+                if (!apClients_[i].connected) continue;
+                apClients_[i].connected = false;
+                apClients_[i].associatedMs = millis() - apClients_[i].associatedAtMs;
+            }
+        } else if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+            const wifi_event_sta_connected_t& connected = info.wifi_sta_connected;
+            snapshot_.update([&connected](NetworkSnapshot& snap) {
+                snap = NetworkSnapshot();
+                snap.associated = true;
+                size_t length = connected.ssid_len < sizeof(snap.ssid) ? connected.ssid_len : sizeof(snap.ssid) - 1;
+                memcpy(snap.ssid, connected.ssid, length);
+                snap.ssid[length] = '\0';
+                memcpy(snap.bssid, connected.bssid, sizeof(snap.bssid));
+                snap.channel = connected.channel;
+            });
+            startRssiSampler();
+            markPhaseEnd(BootPhase::Associate);
+            markPhaseStart(BootPhase::Dhcp);
+            if (connectStartUs_ >= 0) associatedUs_ = esp_timer_get_time();
+            // リンクローカルアドレスを作成すると、RA を受けて SLAAC でグローバルアドレスも設定される
+            if (networkConfig_.enableIPv6) WiFi.enableIpV6();
+        } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP6) {
+            const uint8_t* addr = reinterpret_cast<const uint8_t*>(info.got_ip6.ip6_info.ip.addr);
+            bool linkLocal = addr[0] == 0xFE && (addr[1] & 0xC0) == 0x80;
+            Serial.println(String("WiFi got IPv6 ") + (linkLocal ? "link-local" : "global") + ": " + IPv6Address(addr).toString());
+            if (!linkLocal) {
+                ipv6Global_ = true;
+                mdns_.announce();
+                if (connectOnIPv6_ && !stationUp_) onStationUp();
             }
-            // 接続回復時にAPが残っていれば停止する
-            if (setupMode_) {
-                Serial.println("Exiting setup mode due to successful connection.");
-                exitSetupMode();
-                WiFi.mode(WIFI_STA);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            const esp_netif_ip_info_t& ipInfo = info.got_ip.ip_info;
+            // DNS は lwIP の設定を読むだけ（ドライバは呼ばない）
+            uint32_t dns1 = static_cast<uint32_t>(WiFi.dnsIP(0));
+            uint32_t dns2 = static_cast<uint32_t>(WiFi.dnsIP(1));
+            snapshot_.update([&ipInfo, dns1, dns2](NetworkSnapshot& snap) {
+                snap.hasIPv4 = true;
+                snap.ip = ipInfo.ip.addr;
+                snap.gateway = ipInfo.gw.addr;
+                snap.subnet = ipInfo.netmask.addr;
+                snap.dns1 = dns1;
+                snap.dns2 = dns2;
+            });
+            if (leaseRenewing_) {
+                // T1 で暫定設定から DHCP に切り替えた結果。リンクは繋がったままなので再接続としては扱わない
+                leaseRenewing_ = false;
+                storeLease();
+                Serial.println("DHCP lease renewed: " + WiFi.localIP().toString());
+                if (info.got_ip.ip_changed) {
+                    mdns_.announce();
+                    if (connectedCallback_) connectedCallback_();
+                }
+                return;
             }
+            Serial.println("WiFi connected (GOT_IP)");
+            markGotIp();
+            recordConnectTiming();
+            if (deepSleepFastPath_) storeConnectionRecord();
+            // 次回の高速再接続用の接続先の記録。フラッシュへの追記はイベントタスクを止めるので、
+            // 印だけ付けて loop() / 疎通確認タスクで書く（BSSID とチャネルはスナップショットにある）
+            __atomic_store_n(&linkRecordPending_, true, __ATOMIC_RELEASE);
+            // 疎通確認はゲートウェイ（IPv4）を使うので GOT_IP で始める
+            healthMonitor_.onLinkUp(millis());
+            startHealthTask();
+            // 初回は開始、再接続では再告知（どのモードでも GOT_IP で行う）
+            startStationMdns();
+            if (!stationUp_) onStationUp();
+        } else if (event == ARDUINO_EVENT_WIFI_STA_LOST_IP) {
+            snapshot_.update([](NetworkSnapshot& snap) {
+                snap.hasIPv4 = false;
+                snap.ip = 0;
+                snap.gateway = 0;
+                snap.subnet = 0;
+                snap.dns1 = 0;
+                snap.dns2 = 0;
+            });
         } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            stopRssiSampler();
+            snapshot_.update([](NetworkSnapshot& snap) { snap = NetworkSnapshot(); });
             Serial.println("WiFi disconnected");
+            stationUp_ = false;
+            // 設定の再適用や T1 の更新中に切れた場合、次の GOT_IP は通常の接続として扱う
+            leaseRenewing_ = false;
+            ipv6Global_ = false;
+            // Arduino コアの自動再接続は prepareStationConnect() を通らないので、ここから計測する
+            if (connectStartUs_ < 0) {
+                connectStartUs_ = esp_timer_get_time();
+                associatedUs_ = -1;
+            }
+#if SUKEN_WIFI_HTTP_CLIENT
+            // 死んだソケットで待たないよう、keep-alive 接続は次回作り直す
+            httpResetPending_ = true;
+#endif
+            healthMonitor_.onLinkDown();
             if (disconnectedCallback_) disconnectedCallback_();
             if (wasEverConnected_) disconnectedSinceLastConnect_ = true;
-            if (autoSetupOnDisconnect_) {
-                if (reconnectTaskHandle_ == nullptr) {
-                    xTaskCreatePinnedToCore(SukenESPWiFi::reconnectTask, "SukenWiFi_Reconnect", 4096, this, 1, &reconnectTaskHandle_, TASK_CORE);
-                }
+            if (taskTopology_.cooperative) {
+                // 自動セットアップが無効でも状態機械には知らせる（Connected のまま残さない）
+                postLinkEvent(false);
+            } else if (autoSetupOnDisconnect_) {
+                scheduleReconnect();
             }
         }
     });
-    secureClient_.setInsecure();
+    initComplete_ = false;
+    
+    if (taskTopology_.cooperative) {
+        initCooperative();
+        return;
+    }
+    
+    if (initMode_ == InitMode::Deferred) {
+        // キャッシュ済み設定で先に接続を開始し、ストレージ確認などは並行して行う
+        if (!beginFromRtcRecord()) beginFromCachedConfig();
+        spawnTask(LibraryTask::Init, SukenESPWiFi::deferredInitTask, "SukenWiFi_Init");
+        if (blockSetup_) {
+            waitUntilConnected(0);
+        }
+        return;
+    }
+    
+    if (beginFromRtcRecord()) {
+        if (waitForStation(MAX_WIFI_RETRY * WIFI_RETRY_DELAY)) {
+            finishInit();
+            return;
+        }
+        // 記録が古い（パスワード変更、AP の移動など）。通常の起動手順でやり直す
+        Serial.println("Fast path failed, falling back to full init");
+        rtcConnectionRecord.magic = 0;
+        fastPathActive_ = false;
+        setBootFastPath(false);
+    }
+    
+    mountStorage();
+    
+    Serial.println("起動しました");
+    scanWiFiNetworks();
+    Serial.println("WiFiコンフィグ探知");
+    
+    // ネットワーク設定を読み込み
+    markPhaseStart(BootPhase::SettingsLoad);
+    readNetworkSettings();
+    markPhaseEnd(BootPhase::SettingsLoad);
+    importProvisioningFile();
+    
+    if (SPIFFS.exists("/wifi_credentials.txt")) {
+        Serial.println("wifi_credentials.txtが存在します");
+        connectToWiFi();
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("WiFi接続失敗");
+        enterSetupMode();
+        finishInit();
+        if (blockSetup_) {
+            // 接続完了まで無期限で待機
+            waitUntilConnected(0);
+        }
+        return;
+    }
+    finishInit();
+}
+
+void SukenESPWiFi::mountStorage() {
+    markPhaseStart(BootPhase::Mount);
     if (!SPIFFS.begin(false)) {
         Serial.println("SPIFFS mount failed, attempting to format...");
         if (SPIFFS.format() && SPIFFS.begin(false)) {
             Serial.println("SPIFFS formatted and mounted successfully");
+            storageMounted_ = true;
         } else {
             Serial.println("SPIFFS format failed");
         }
     } else {
         Serial.println("SPIFFS mounted successfully");
+        storageMounted_ = true;
     }
     
     // SPIFFSファイルの存在確認
     Serial.println("=== SPIFFS File Check ===");
-    if (SPIFFS.exists("/wifi_credentials.txt")) {
+    credentialsStored_ = SPIFFS.exists("/wifi_credentials.txt");
+    if (credentialsStored_) {
         Serial.println("wifi_credentials.txt exists");
         File file = SPIFFS.open("/wifi_credentials.txt", "r");
         Serial.println("File size: " + String(file.size()) + " bytes");
@@ -117,60 +392,240 @@ void SukenESPWiFi::init() {
         Serial.println("network_settings.txt does not exist");
     }
     Serial.println("========================");
+    if (storageMounted_ && queueSender_) offlineQueue_.loadFlash();
+    if (storageMounted_ && pmkStorage_ && credentialsStored_) migrateCredentialsToPmk();
+    markPhaseEnd(BootPhase::Mount);
+}
+
+void SukenESPWiFi::onStationUp() {
+    // IPv4 の GOT_IP、または（setConnectOnIPv6 有効時）IPv6 グローバルアドレスの取得のうち先に来た方で1回だけ実行
+    stationUp_ = true;
+    if (!wasEverConnected_) wasEverConnected_ = true;
+    if (taskTopology_.cooperative) postLinkEvent(true);
+    if (connectedCallback_) connectedCallback_();
+    startQueueDrain();
+    if (disconnectedSinceLastConnect_) {
+        disconnectedSinceLastConnect_ = false;
+        if (reconnectedCallback_) reconnectedCallback_();
+    }
+    // 接続回復時にAPが残っていれば停止する（協調モードでは loop() で行う）
+    if (setupMode_ && !taskTopology_.cooperative) {
+        Serial.println("Exiting setup mode due to successful connection.");
+        leaveSetupModeToStation();
+    }
+}
+
+bool SukenESPWiFi::beginFromRtcRecord() {
+    // 間欠動作のディープスリープ復帰時のみ。コールドブートや記録の破損時は通常の手順
+    if (!deepSleepFastPath_ || taskTopology_.cooperative || bootProfile_.kind != BootKind::DeepSleepWake) return false;
+    if (!connectionRecordValid()) return false;
+    const RtcConnectionRecord& record = rtcConnectionRecord;
+    networkConfig_.useStaticIP = (record.flags & CONNECTION_FLAG_STATIC_IP) != 0;
+    networkConfig_.enableIPv6 = (record.flags & CONNECTION_FLAG_IPV6) != 0;
+    if (networkConfig_.useStaticIP) {
+        networkConfig_.staticIP = IPAddress(record.staticIP);
+        networkConfig_.gateway = IPAddress(record.gateway);
+        networkConfig_.subnet = IPAddress(record.subnet);
+        networkConfig_.primaryDNS = IPAddress(record.dns1);
+        networkConfig_.secondaryDNS = IPAddress(record.dns2);
+    }
+    Serial.println(String("Connecting from RTC record: ") + record.ssid + " (ch " + String(record.channel) + ")");
+    fastPathActive_ = true;
+    setBootFastPath(true);
+    credentialsStored_ = true;
+    setRadioMode(WIFI_STA);
+    WiFi.setHostname(deviceName_.c_str());
+    prepareStationConnect(String(record.ssid));
+    markPhaseStart(BootPhase::Associate);
+    // BSSID とチャネルを指定してスキャンを省く
+    WiFi.begin(record.ssid, record.key, record.channel, record.bssid);
+    return true;
+}
+
+bool SukenESPWiFi::waitForStation(uint32_t timeoutMs) {
+    uint32_t waited = 0;
+    while (WiFi.status() != WL_CONNECTED && waited < timeoutMs) {
+        taskDelay(WIFI_RETRY_DELAY);
+        waited += WIFI_RETRY_DELAY;
+    }
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void SukenESPWiFi::storeConnectionRecord() {
+    // WiFi.begin() に渡した値はドライバの設定から取れるので、SPIFFS は読まない
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) != ESP_OK || config.sta.ssid[0] == 0) return;
+    RtcConnectionRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = CONNECTION_RECORD_MAGIC;
+    memcpy(record.ssid, config.sta.ssid, sizeof(record.ssid) - 1);
+    memcpy(record.key, config.sta.password, sizeof(record.key) - 1);
+    uint8_t* bssid = WiFi.BSSID();
+    if (bssid) memcpy(record.bssid, bssid, sizeof(record.bssid));
+    record.channel = static_cast<uint8_t>(WiFi.channel());
+    if (networkConfig_.useStaticIP) record.flags |= CONNECTION_FLAG_STATIC_IP;
+    if (networkConfig_.enableIPv6) record.flags |= CONNECTION_FLAG_IPV6;
+    if (isHexPmk(String(record.key))) record.flags |= CONNECTION_FLAG_PMK;
+    record.staticIP = static_cast<uint32_t>(networkConfig_.staticIP);
+    record.gateway = static_cast<uint32_t>(networkConfig_.gateway);
+    record.subnet = static_cast<uint32_t>(networkConfig_.subnet);
+    record.dns1 = static_cast<uint32_t>(networkConfig_.primaryDNS);
+    record.dns2 = static_cast<uint32_t>(networkConfig_.secondaryDNS);
+    record.checksum = recordChecksum(record);
+    rtcConnectionRecord = record;
+}
+
+void SukenESPWiFi::enableDeepSleepFastPath(bool enable) {
+    deepSleepFastPath_ = enable;
+    if (!enable) rtcConnectionRecord.magic = 0;
+}
+bool SukenESPWiFi::isDeepSleepFastPathEnabled() const { return deepSleepFastPath_; }
+
+void SukenESPWiFi::deepSleep(uint64_t durationUs) {
+    if (deepSleepFastPath_ && WiFi.status() == WL_CONNECTED) storeConnectionRecord();
+    persistLinkRecord();
+    if (storageMounted_) offlineQueue_.persistPending(millis(), true);
+    Serial.println("Entering deep sleep for " + String(static_cast<uint32_t>(durationUs / 1000)) + " ms");
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup(durationUs);
+    esp_deep_sleep_start();
+}
+
+bool SukenESPWiFi::beginFromCachedConfig() {
+    // WiFi ドライバが NVS に保持している前回の STA 設定を使う（SPIFFS 不要）
+    // ドライバは WiFi.mode() で初期化されるまで設定を返さない（ESP_ERR_WIFI_NOT_INIT）ので先に STA にする。
+    // キャッシュがなくても後の接続は STA を使うため、モードはそのままでよい
+    setRadioMode(WIFI_STA);
+    wifi_config_t cached = {};
+    esp_err_t err = esp_wifi_get_config(WIFI_IF_STA, &cached);
+    if (err != ESP_OK) {
+        Serial.println(String("Failed to read cached WiFi config: ") + esp_err_to_name(err));
+        return false;
+    }
+    if (cached.sta.ssid[0] == 0) {
+        Serial.println("No cached WiFi config, waiting for storage");
+        return false;
+    }
+    Serial.println("Connecting with cached WiFi config...");
+    WiFi.setHostname(deviceName_.c_str());
+    prepareStationConnect(String(reinterpret_cast<const char*>(cached.sta.ssid)));
+    markPhaseStart(BootPhase::Associate);
+    WiFi.begin();
+    return true;
+}
+
+void SukenESPWiFi::deferredInitTask(void* parameter) {
+    SukenESPWiFi* self = static_cast<SukenESPWiFi*>(parameter);
+    self->runDeferredInit();
+    self->finishTask(LibraryTask::Init);
+    vTaskDelete(nullptr);
+}
+
+void SukenESPWiFi::runDeferredInit() {
+    SukenESPWiFi* self = this;
     
-    Serial.println("起動しました");
-    scanWiFiNetworks();
-    Serial.println("WiFiコンフィグ探知");
+    if (fastPathActive_) {
+        if (waitForStation(MAX_WIFI_RETRY * WIFI_RETRY_DELAY)) {
+            finishInit();
+            return;
+        }
+        Serial.println("Fast path failed, falling back to full init");
+        rtcConnectionRecord.magic = 0;
+        fastPathActive_ = false;
+        setBootFastPath(false);
+        // 記録の設定で接続を続けないよう、保存済み設定での接続に切り替える
+        self->mountStorage();
+        self->readNetworkSettings();
+        if (SPIFFS.exists("/wifi_credentials.txt")) self->connectToWiFi();
+        if (WiFi.status() != WL_CONNECTED) self->enterSetupMode();
+        self->finishInit();
+        return;
+    }
     
-    // ネットワーク設定を読み込み
-    readNetworkSettings();
+    self->mountStorage();
+    self->markPhaseStart(BootPhase::SettingsLoad);
+    self->readNetworkSettings();
+    self->markPhaseEnd(BootPhase::SettingsLoad);
     
-    if (SPIFFS.exists("/wifi_credentials.txt")) {
-        Serial.println("wifi_credentials.txtが存在します");
-        connectToWiFi();
+    bool hasCredentials = SPIFFS.exists("/wifi_credentials.txt");
+    if (self->importProvisioningFile()) {
+        // キャッシュ設定は古いので取り込んだ設定で接続し直す
+        self->connectToWiFi();
+    } else if (WiFi.status() != WL_CONNECTED && hasCredentials) {
+        if (self->networkConfig_.useStaticIP || WiFi.getMode() != WIFI_STA) {
+            // 静的IP設定やキャッシュ無しの場合は保存済み設定で接続し直す
+            self->connectToWiFi();
+        } else {
+            // キャッシュ設定で接続中。通常の接続と同じ時間だけ待つ
+            uint8_t attempts = 0;
+            while (WiFi.status() != WL_CONNECTED && attempts < MAX_WIFI_RETRY) {
+                self->taskDelay(WIFI_RETRY_DELAY);
+                attempts++;
+            }
+            if (WiFi.status() != WL_CONNECTED) self->connectToWiFi();
+        }
+    } else if (self->networkConfig_.useStaticIP) {
+        // キャッシュで接続済みでも静的IP設定は反映する
+        WiFi.config(self->networkConfig_.staticIP, self->networkConfig_.gateway, self->networkConfig_.subnet, self->networkConfig_.primaryDNS, self->networkConfig_.secondaryDNS);
     }
     
     if (WiFi.status() != WL_CONNECTED) {
         Serial.println("WiFi接続失敗");
-        enterSetupMode();
-        if (blockSetup_) {
-            // 接続完了まで無期限で待機
-            waitUntilConnected(0);
-        }
+        self->enterSetupMode();
     }
+    self->finishInit();
+}
+
+void SukenESPWiFi::finishInit() {
+    initComplete_ = true;
+    if (initCompleteCallback_) initCompleteCallback_();
 }
 
+void SukenESPWiFi::setInitMode(InitMode mode) { initMode_ = mode; }
+InitMode SukenESPWiFi::getInitMode() const { return initMode_; }
+void SukenESPWiFi::onInitComplete(CallbackFunction callback) { initCompleteCallback_ = std::move(callback); }
+bool SukenESPWiFi::isInitComplete() const { return initComplete_; }
+
 void SukenESPWiFi::reconnectTask(void* parameter) {
     SukenESPWiFi* self = static_cast<SukenESPWiFi*>(parameter);
-    if (self->setupMode_) {
-        self->reconnectTaskHandle_ = nullptr;
-        vTaskDelete(nullptr);
+    // 初期化中の切断は init 側の接続処理に任せる
+    while (!self->initComplete_) {
+        self->taskDelay(100);
+    }
+    self->runReconnect();
+    self->finishTask(LibraryTask::Reconnect);
+    vTaskDelete(nullptr);
+}
+
+void SukenESPWiFi::scheduleReconnect() {
+    if (reconnectTaskHandle_ == nullptr) {
+        spawnTask(LibraryTask::Reconnect, SukenESPWiFi::reconnectTask, "SukenWiFi_Reconnect");
     }
+}
+
+void SukenESPWiFi::runReconnect() {
+    if (WiFi.status() == WL_CONNECTED || setupMode_) return;
     WiFiCredentials creds;
-    self->readWiFiCredentials(creds);
+    readWiFiCredentials(creds);
     if (creds.ssid.length() == 0) {
-        self->enterSetupMode();
-        self->reconnectTaskHandle_ = nullptr;
-        vTaskDelete(nullptr);
+        enterSetupMode();
+        return;
     }
     // まずは STA で一定回数だけ再接続を試行
-    WiFi.mode(WIFI_STA);
-    if (self->networkConfig_.useStaticIP) {
-        WiFi.config(self->networkConfig_.staticIP, self->networkConfig_.gateway, self->networkConfig_.subnet, self->networkConfig_.primaryDNS, self->networkConfig_.secondaryDNS);
-    }
+    setRadioMode(WIFI_STA);
+    prepareStationConnect(creds.ssid);
     WiFi.begin(creds.ssid.c_str(), creds.password.c_str());
     uint8_t attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < self->disconnectRetryAttemptsBeforeAP_) {
-        delay(self->disconnectRetryDelayMs_);
+    while (WiFi.status() != WL_CONNECTED && attempts < disconnectRetryAttemptsBeforeAP_) {
+        taskDelay(disconnectRetryDelayMs_);
         attempts++;
     }
     if (WiFi.status() != WL_CONNECTED) {
         // APへ移行
-        self->enterSetupMode();
+        enterSetupMode();
     }
-    self->reconnectTaskHandle_ = nullptr;
-    vTaskDelete(nullptr);
 }
+
 void SukenESPWiFi::setDisconnectRetryPolicy(uint8_t attempts, uint32_t delayMs) {
     disconnectRetryAttemptsBeforeAP_ = attempts;
     disconnectRetryDelayMs_ = delayMs;
@@ -192,16 +647,203 @@ void SukenESPWiFi::enterSetupMode() {
     // 既にセットアップモードなら何もしない
     if (setupMode_) return;
     if (setupModeCallback_) setupModeCallback_();
-    startAccessPoint();
+    // ディープスリープの高速パスではマウントしていない。ポータルからの保存に必要
+    if (!storageMounted_ && fastPathActive_) mountStorage();
+    if (taskTopology_.cooperative) {
+        // 協調モードではスキャンも非同期で行う（AP 開始後に loop() で回収）
+        fsm_.enterPortal(millis());
+        startProvisioningTransports();
+        if (!networksScanned_) startAsyncScan();
+        return;
+    }
+    // Deferred モードではスキャンをポータルが必要になるまで遅延している
+    if (!networksScanned_) scanWiFiNetworks();
+    startProvisioningTransports();
 }
 
 void SukenESPWiFi::exitSetupMode() {
     if (!setupMode_) return;
+    stopProvisioningTransports();
+    setupMode_ = false;
+}
+
+void SukenESPWiFi::stopPortal() {
+    // リクエストのハンドラ内（接続成功後の移行など）や別タスクから WebServer を破棄すると、
+    // handleClient() が解放済みのメモリに戻る。ポータルタスクの次の周回で停止する
+    bool otherTask = taskHandle_ != nullptr && xTaskGetCurrentTaskHandle() != taskHandle_;
+    if (server_ && (servingRequest_ || otherTask)) {
+        portalTeardownPending_ = true;
+        return;
+    }
+    portalTeardownPending_ = false;
+    for (size_t i = 0; i < MAX_SSE_CLIENTS; ++i) {
+        sseClients_[i].stop();
+    }
     if (server_) server_->stop();
-    dnsServer_.stop();
-    serverPtr_.reset();
+    if (dnsServer_) dnsServer_->stop();
+    if (server_) {
+        if (serverInArena_) {
+            server_->~HttpServer();
+        } else {
+            delete server_;
+        }
+    }
+    if (dnsServer_) {
+        if (dnsInArena_) {
+            dnsServer_->~CaptiveDns();
+        } else {
+            delete dnsServer_;
+        }
+    }
     server_ = nullptr;
-    setupMode_ = false;
+    serverInArena_ = false;
+    dnsServer_ = nullptr;
+    dnsInArena_ = false;
+    releasePortalArena();
+}
+
+void SukenESPWiFi::acquirePortalArena() {
+    portalMemory_.sessions++;
+    portalMemory_.largestFreeBefore = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    portalMemory_.freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    // WebServer 本体、キャプティブDNS、応答バッファを1ブロックにまとめる
+    size_t capacity = sizeof(PortalServer) + alignof(PortalServer) +
+                      sizeof(CaptiveDns) + alignof(CaptiveDns) +
+                      PORTAL_RESPONSE_BUFFER_SIZE * PORTAL_RESPONSE_BUFFERS;
+    if (!portalArena_.begin(capacity)) {
+        Serial.println("Portal arena allocation failed. Using heap.");
+        return;
+    }
+    portalMemory_.arenaBytes = portalArena_.capacity();
+    void* slot = portalArena_.allocate(sizeof(PortalServer), alignof(PortalServer));
+    if (slot) {
+        server_ = new (slot) PortalServer(DEFAULT_HTTP_PORT);
+        serverInArena_ = true;
+    }
+    slot = portalArena_.allocate(sizeof(CaptiveDns), alignof(CaptiveDns));
+    if (slot) {
+        dnsServer_ = new (slot) CaptiveDns();
+        dnsInArena_ = true;
+    }
+    responsePool_.begin(portalArena_, PORTAL_RESPONSE_BUFFER_SIZE, PORTAL_RESPONSE_BUFFERS);
+}
+
+void SukenESPWiFi::releasePortalArena() {
+    if (!portalArena_.active()) return;
+    portalMemory_.arenaUsed = portalArena_.used();
+    portalMemory_.poolExhausted = responsePool_.exhausted();
+    responsePool_.reset();
+    portalArena_.release();
+    portalMemory_.largestFreeAfter = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    portalMemory_.freeAfter = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    Serial.printf("Portal memory: largest free block %u -> %u, free %u -> %u (arena %u/%u)\n",
+                  static_cast<unsigned>(portalMemory_.largestFreeBefore),
+                  static_cast<unsigned>(portalMemory_.largestFreeAfter),
+                  static_cast<unsigned>(portalMemory_.freeBefore),
+                  static_cast<unsigned>(portalMemory_.freeAfter),
+                  static_cast<unsigned>(portalMemory_.arenaUsed),
+                  static_cast<unsigned>(portalMemory_.arenaBytes));
+}
+
+PortalMemoryStats SukenESPWiFi::getPortalMemoryStats() const { return portalMemory_; }
+
+void SukenESPWiFi::setPortalRateLimit(const RateLimitConfig& config) { rateLimiter_.configure(config); }
+RateLimitConfig SukenESPWiFi::getPortalRateLimit() const { return rateLimiter_.config(); }
+RateLimitStats SukenESPWiFi::getPortalRateLimitStats() const { return rateLimiter_.stats(); }
+
+bool SukenESPWiFi::admitPortalRequest(RouteClass route) {
+    if (!server_) return false;
+    uint32_t retryAfterSec = 0;
+    uint32_t ip = static_cast<uint32_t>(server_->client().remoteIP());
+    if (rateLimiter_.allow(ip, route, millis(), retryAfterSec)) return true;
+    sendTooManyRequests(route, retryAfterSec, "リクエストが多すぎます。しばらく待ってから再試行してください");
+    return false;
+}
+
+void SukenESPWiFi::sendTooManyRequests(RouteClass route, uint32_t retryAfterSec, const char* message) {
+    if (!server_) return;
+    server_->sendHeader("Retry-After", String(retryAfterSec));
+    if (route == RouteClass::Page) {
+        server_->send(429, "text/plain", message);
+        return;
+    }
+    JsonDocument doc;
+    doc["message"] = message;
+    doc["status"] = "error";
+    doc["retry"] = true;
+    doc["retryAfter"] = retryAfterSec;
+    String payload;
+    serializeJson(doc, payload);
+    server_->send(429, "application/json", payload);
+}
+
+void SukenESPWiFi::addProvisioningTransport(std::unique_ptr<ProvisioningTransport> transport) {
+    if (!transport) return;
+    ProvisioningTransport* added = transport.get();
+    transports_.push_back(std::move(transport));
+    // セットアップモード中なら追加した方式もすぐに開始する
+    if (setupMode_) {
+        added->setHandler([this](ProvisioningTransport& source, const String& ssid, const String& password) {
+            onTransportCredentials(source, ssid, password);
+        });
+        added->start();
+    }
+}
+
+String SukenESPWiFi::getLastProvisioningTransport() const { return lastProvisioningTransport_; }
+
+void SukenESPWiFi::startProvisioningTransports() {
+    for (auto& transport : transports_) {
+        transport->setHandler([this](ProvisioningTransport& source, const String& ssid, const String& password) {
+            onTransportCredentials(source, ssid, password);
+        });
+        if (!transport->start()) {
+            Serial.println(String("Provisioning transport failed to start: ") + transport->name());
+        }
+    }
+    // BLE プロビジョニングは開始時に STA のみへ切り替えるため、APを戻す
+    if (transports_.size() > 1) setRadioMode(WIFI_AP_STA);
+}
+
+void SukenESPWiFi::stopProvisioningTransports() {
+    for (auto& transport : transports_) {
+        transport->stop();
+    }
+}
+
+void SukenESPWiFi::pollProvisioningTransports() {
+    for (size_t i = 0; i < transports_.size() && setupMode_; ++i) {
+        transports_[i]->poll();
+    }
+}
+
+void SukenESPWiFi::onTransportCredentials(ProvisioningTransport& source, const String& ssid, const String& password) {
+    if (ssid.length() == 0) return;
+    lastProvisioningTransport_ = source.name();
+    Serial.println(String("Provisioned via ") + source.name() + ": " + ssid);
+    WiFiCredentials credentials;
+    credentials.ssid = ssid;
+    credentials.password = password;
+    // SmartConfig/BLE ではコアやプロビジョニングマネージャが受信時に接続を始めている。
+    // 固定IPや保存済みリースを経ない接続なので止め、ポータルと同じ applyConfig() で接続し直す
+    WiFi.disconnect();
+    
+    if (taskTopology_.cooperative) {
+        // 保存だけを行い、接続は loop() で進める（接続時に prepareStationConnect() を通る）
+        ProvisionResult result = applyConfig(credentials, networkConfig_, false);
+        if (result != ProvisionResult::Ok) {
+            Serial.println(String("Provisioning failed: ") + provisionResultName(result));
+            return;
+        }
+        fsm_.requestConnect(millis(), MAX_WIFI_RETRY * WIFI_RETRY_DELAY);
+        return;
+    }
+    ProvisionResult result = applyConfig(credentials, networkConfig_);
+    if (result == ProvisionResult::Ok) {
+        Serial.println("Connected. AP/portal has been shut down.");
+    } else {
+        Serial.println(String("Provisioning failed: ") + provisionResultName(result) + ". Staying in setup mode.");
+    }
 }
 
 bool SukenESPWiFi::isInSetupMode() const { return setupMode_; }
@@ -209,16 +851,17 @@ bool SukenESPWiFi::isInSetupMode() const { return setupMode_; }
 bool SukenESPWiFi::waitUntilConnected(uint32_t timeoutMs) {
     uint32_t start = millis();
     // セットアップモード中はAPを維持しつつ、接続を待つ
-    while (WiFi.status() != WL_CONNECTED) {
+    while (!isConnected()) {
         if (timeoutMs > 0 && (millis() - start) >= timeoutMs) {
             return false;
         }
-        delay(100);
+        // 協調モードではここでポータルなどを進める
+        if (taskTopology_.cooperative) loop();
+        delay(taskTopology_.cooperative ? 1 : 100);
     }
     // 接続できたらポータルを閉じてSTAに移行
     if (setupMode_) {
-        exitSetupMode();
-        WiFi.mode(WIFI_STA);
+        leaveSetupModeToStation();
     }
     return true;
 }
@@ -235,28 +878,85 @@ void SukenESPWiFi::setDeviceName(const String& name) {
 void SukenESPWiFi::setAPConfig(const IPAddress& ip, const IPAddress& gateway, const IPAddress& subnet) {
     apIP_ = ip;
     apIPString_ = ip.toString();
-    if (WiFi.getMode() == WIFI_AP) {
+    if (WiFi.getMode() & WIFI_AP) {
         WiFi.softAPConfig(apIP_, apIP_, subnet);
     }
 }
 
 void SukenESPWiFi::startAccessPoint() {
     Serial.println("APスタート");
+    markPhaseStart(BootPhase::PortalStart);
     setupMode_ = true;
+    // 停止待ちのポータルが残っていれば、そのまま使い続ける
+    portalTeardownPending_ = false;
     if (!server_) {
-        serverPtr_.reset(new HttpServer(DEFAULT_HTTP_PORT));
-        server_ = serverPtr_.get();
+        rateLimiter_.resetClients();
+        acquirePortalArena();
+        if (!server_) server_ = new PortalServer(DEFAULT_HTTP_PORT);
+        if (!dnsServer_) dnsServer_ = new CaptiveDns();
+    }
+    // 保存済みWiFiへ再接続を試行する場合は最初から AP_STA にしておき、
+    // 後からのモード切替（無線の再起動）を避ける
+    // （スキャン未実施の協調モードや、一覧を定期的に再スキャンする場合も STA 側が必要）
+    // （ポータル以外のプロビジョニング方式も STA 側を使う）
+    bool willRetryStation = autoReconnectDuringSetup_ && SPIFFS.exists("/wifi_credentials.txt");
+    bool needStation = willRetryStation || !networksScanned_ || scanRefreshIntervalMs_ > 0 || transports_.size() > 1;
+    setRadioMode(needStation ? WIFI_AP_STA : WIFI_AP);
+    apStats_.channel = selectAPChannel();
+    const char* password = softAPConfig_.password.length() >= 8 ? softAPConfig_.password.c_str() : nullptr;
+    WiFi.softAP(wifiName_.c_str(), password, apStats_.channel, 0, softAPConfig_.maxClients);
+    applyAPBeaconInterval();
+    Serial.println("AP channel: " + String(apStats_.channel));
+    if (taskTopology_.cooperative && !apStarted_) {
+        // 協調モードでは待たずに、AP_START 後の loop() で設定する
+        apConfigPending_ = true;
+    } else {
+        // 固定待ちではなく AP_START イベントを待つ（上限あり）
+        uint32_t waitStart = millis();
+        while (!apStarted_ && millis() - waitStart < AP_START_TIMEOUT_MS) {
+            delay(10);
+        }
+        WiFi.softAPConfig(apIP_, apIP_, IPAddress(255, 255, 255, 0));
+    }
+    if (taskTopology_.cooperative) {
+        startPortalServices();
+    } else {
+        spawnTask(LibraryTask::Portal, SukenESPWiFi::taskMain, "SukenESPWiFi_TaskMain");
     }
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(wifiName_.c_str());
-    delay(200);
-    WiFi.softAPConfig(apIP_, apIP_, IPAddress(255, 255, 255, 0));
-    xTaskCreatePinnedToCore(SukenESPWiFi::taskMain, "SukenESPWiFi_TaskMain", TASK_STACK_SIZE, this, TASK_PRIORITY, &taskHandle_, TASK_CORE);
 }
 
 void SukenESPWiFi::scanWiFiNetworks() {
-    wifiList_.clear();
+    markPhaseStart(BootPhase::Scan);
     int numNetworks = WiFi.scanNetworks();
+    markPhaseEnd(BootPhase::Scan);
+    fillWiFiList(numNetworks);
+}
+
+void SukenESPWiFi::startAsyncScan() {
+    markPhaseStart(BootPhase::Scan);
+    WiFi.scanNetworks(true);
+    scanInProgress_ = true;
+}
+
+void SukenESPWiFi::pollAsyncScan() {
+    int16_t result = WiFi.scanComplete();
+    if (result == WIFI_SCAN_RUNNING) return;
+    scanInProgress_ = false;
+    markPhaseEnd(BootPhase::Scan);
+    if (result < 0) {
+        // 失敗したスキャンで一覧を空にしない
+        networksScanned_ = true;
+        lastScanMs_ = millis();
+        Serial.println("Scan failed");
+        return;
+    }
+    fillWiFiList(result);
+    WiFi.scanDelete();
+}
+
+void SukenESPWiFi::fillWiFiList(int numNetworks) {
+    networksScanned_ = true;
+    lastScanMs_ = millis();
     Serial.println("Scan done");
 
     if (numNetworks == 0) {
@@ -264,18 +964,17 @@ void SukenESPWiFi::scanWiFiNetworks() {
     } else {
         Serial.print(numNetworks);
         Serial.println(" networks found");
-
-        JsonArray networkList = wifiList_.createNestedArray("networks");
-        for (int i = 0; i < numNetworks; ++i) {
-            networkList.add(WiFi.SSID(i));
-        }
     }
 
-    serializeJsonPretty(wifiList_, Serial);
+    // 内容が変わったときだけバージョンが進む（ポータルは差分だけを取得する）
+    bool changed = scanTable_.update(numNetworks);
+    Serial.println("WiFi list version: " + String(scanTable_.version()) + (changed ? " (changed)" : ""));
+    broadcastScanEvents(changed);
 }
 
 void SukenESPWiFi::handleWiFiSettingPage() {
-    String html = R"=====(
+    // 固定の内容なのでフラッシュから直接送る（ヒープに約15KBの String を作らない）
+    static const char PORTAL_HTML[] PROGMEM = R"=====(
 <!DOCTYPE html>
 <html lang="ja">
 <head>
@@ -374,18 +1073,6 @@ void SukenESPWiFi::handleWiFiSettingPage() {
             color: #333;
             text-align: center;
         }
-        .ip-input-group {
-            display: flex;
-            gap: 5px;
-            margin-bottom: 10px;
-        }
-        .ip-input-group input {
-            flex: 1;
-            text-align: center;
-            padding: 8px;
-            border: 1px solid #ccc;
-            border-radius: 4px;
-        }
         .button-group {
             margin-top: 20px;
         }
@@ -409,64 +1096,18 @@ void SukenESPWiFi::handleWiFiSettingPage() {
     <div id="warningMessage" class="hidden warning-message">WiFiが5GHz帯を利用している可能性があります。2.4GHz帯を利用してください。</div>
     <div>
         <label for="wifi_password">パスワード:</label>
-        <input type="password" id="wifi_password" name="wifi_password" required>
+        <input type="password" id="wifi_password" name="wifi_password">
     </div>
     
+    <!-- 詳細設定の項目は ./api/schema から作る -->
+    <div id="networkFields"></div>
+    
     <div class="static-ip-form" id="staticIPForm" style="display: none;">
         <h3>静的IP設定</h3>
-        <div>
-            <label for="staticIP">IPアドレス:</label>
-            <div class="ip-input-group">
-                <input type="number" id="staticIP1" min="0" max="255" value="192" required>
-                <input type="number" id="staticIP2" min="0" max="255" value="168" required>
-                <input type="number" id="staticIP3" min="0" max="255" value="1" required>
-                <input type="number" id="staticIP4" min="0" max="255" value="200" required>
-            </div>
-        </div>
-        
-        <div>
-            <label for="gateway">ゲートウェイ:</label>
-            <div class="ip-input-group">
-                <input type="number" id="gateway1" min="0" max="255" value="192" required>
-                <input type="number" id="gateway2" min="0" max="255" value="168" required>
-                <input type="number" id="gateway3" min="0" max="255" value="1" required>
-                <input type="number" id="gateway4" min="0" max="255" value="1" required>
-            </div>
-        </div>
-        
-        <div>
-            <label for="subnet">サブネットマスク:</label>
-            <div class="ip-input-group">
-                <input type="number" id="subnet1" min="0" max="255" value="255" required>
-                <input type="number" id="subnet2" min="0" max="255" value="255" required>
-                <input type="number" id="subnet3" min="0" max="255" value="255" required>
-                <input type="number" id="subnet4" min="0" max="255" value="0" required>
-            </div>
-        </div>
-        
-        <div>
-            <label for="primaryDNS">優先DNS:</label>
-            <div class="ip-input-group">
-                <input type="number" id="primaryDNS1" min="0" max="255" value="8" required>
-                <input type="number" id="primaryDNS2" min="0" max="255" value="8" required>
-                <input type="number" id="primaryDNS3" min="0" max="255" value="8" required>
-                <input type="number" id="primaryDNS4" min="0" max="255" value="8" required>
-            </div>
-        </div>
-        
-        <div>
-            <label for="secondaryDNS">代替DNS:</label>
-            <div class="ip-input-group">
-                <input type="number" id="secondaryDNS1" min="0" max="255" value="8" required>
-                <input type="number" id="secondaryDNS2" min="0" max="255" value="8" required>
-                <input type="number" id="secondaryDNS3" min="0" max="255" value="4" required>
-                <input type="number" id="secondaryDNS4" min="0" max="255" value="4" required>
-            </div>
-        </div>
+        <div id="staticIPFields"></div>
     </div>
     
     <div class="button-group">
-        <button type="button" class="btn-secondary" onclick="toggleStaticIP()">StaticIP</button>
         <button type="submit" class="btn-primary">設定を保存</button>
     </div>
 </form>
@@ -478,13 +1119,91 @@ void SukenESPWiFi::handleWiFiSettingPage() {
 <div id="macAddress" style="text-align: center; margin-top: 20px;"></div>
 
 <script>
-    var useStaticIP = false;
-    
     document.getElementById('wifiForm').addEventListener('submit', function(event) {
         event.preventDefault();
         submitWiFiSettings();
     });
 
+    // 詳細設定の項目（SukenWiFiConfigFields.h の項目表と同じ並び）
+    var schemaFields = [];
+
+    function loadSchema() {
+        fetch('./api/schema')
+            .then(response => response.json())
+            .then(data => {
+                schemaFields = data.fields || [];
+                buildFields();
+            })
+            .catch(error => console.error('Error:', error));
+    }
+
+    function isNetworkField(field) {
+        return field.staticOnly !== undefined;
+    }
+
+    function fieldValue(field) {
+        return (field.value !== undefined) ? field.value : field.default;
+    }
+
+    function buildFields() {
+        var general = document.getElementById('networkFields');
+        var staticFields = document.getElementById('staticIPFields');
+        general.innerHTML = '';
+        staticFields.innerHTML = '';
+        schemaFields.forEach(function (field) {
+            if (!isNetworkField(field)) {
+                // SSID とパスワードは一覧付きの欄を使い、長さの制限だけ反映する
+                var textInput = document.getElementById(field.key === 'ssid' ? 'other_ssid' : 'wifi_password');
+                if (!textInput) return;
+                textInput.maxLength = field.maxLength;
+                if (field.key === 'password') textInput.required = field.minLength > 0;
+                return;
+            }
+            var row = document.createElement('div');
+            var label = document.createElement('label');
+            var input = document.createElement('input');
+            input.id = 'field_' + field.key;
+            if (field.type === 'bool') {
+                input.type = 'checkbox';
+                input.checked = !!fieldValue(field);
+                label.appendChild(input);
+                label.appendChild(document.createTextNode(' ' + field.label));
+                row.appendChild(label);
+            } else {
+                input.type = 'text';
+                input.value = fieldValue(field);
+                input.placeholder = field.default;
+                if (field.type === 'ipv4') {
+                    input.required = true;
+                    input.pattern = '((25[0-5]|2[0-4]\\d|1?\\d?\\d)\\.){3}(25[0-5]|2[0-4]\\d|1?\\d?\\d)';
+                    input.title = '例: ' + field.default;
+                }
+                label.htmlFor = input.id;
+                label.textContent = field.label + ':';
+                row.appendChild(label);
+                row.appendChild(input);
+            }
+            (field.staticOnly ? staticFields : general).appendChild(row);
+        });
+        var toggle = document.getElementById('field_useStaticIP');
+        if (toggle) toggle.addEventListener('change', updateStaticIPForm);
+        updateStaticIPForm();
+    }
+
+    // 固定IPの項目は useStaticIP が有効なときだけ表示して送る（サーバーも同じ条件で読む）
+    function staticIPEnabled() {
+        var toggle = document.getElementById('field_useStaticIP');
+        return !!(toggle && toggle.checked);
+    }
+
+    function updateStaticIPForm() {
+        var enabled = staticIPEnabled();
+        var form = document.getElementById('staticIPForm');
+        form.style.display = enabled ? 'block' : 'none';
+        // 無効な入力欄は検証の対象外になる
+        form.querySelectorAll('input').forEach(function (input) { input.disabled = !enabled; });
+    }
+
     function submitWiFiSettings() {
         var wifi_ssid = document.getElementById('wifi_ssid').value;
         if (wifi_ssid === 'その他') {
@@ -494,41 +1213,15 @@ void SukenESPWiFi::handleWiFiSettingPage() {
 
         var data = {
             ssid: wifi_ssid,
-            password: wifi_password,
-            useStaticIP: useStaticIP
+            password: wifi_password
         };
-
-        console.log("useStaticIP value:", useStaticIP);
-        console.log("useStaticIP type:", typeof useStaticIP);
-
-        if (useStaticIP) {
-            data.staticIP = document.getElementById('staticIP1').value + '.' + 
-                           document.getElementById('staticIP2').value + '.' + 
-                           document.getElementById('staticIP3').value + '.' + 
-                           document.getElementById('staticIP4').value;
-            
-            data.gateway = document.getElementById('gateway1').value + '.' + 
-                          document.getElementById('gateway2').value + '.' + 
-                          document.getElementById('gateway3').value + '.' + 
-                          document.getElementById('gateway4').value;
-            
-            data.subnet = document.getElementById('subnet1').value + '.' + 
-                         document.getElementById('subnet2').value + '.' + 
-                         document.getElementById('subnet3').value + '.' + 
-                         document.getElementById('subnet4').value;
-            
-            data.primaryDNS = document.getElementById('primaryDNS1').value + '.' + 
-                             document.getElementById('primaryDNS2').value + '.' + 
-                             document.getElementById('primaryDNS3').value + '.' + 
-                             document.getElementById('primaryDNS4').value;
-            
-            data.secondaryDNS = document.getElementById('secondaryDNS1').value + '.' + 
-                               document.getElementById('secondaryDNS2').value + '.' + 
-                               document.getElementById('secondaryDNS3').value + '.' + 
-                               document.getElementById('secondaryDNS4').value;
-            
-            console.log("Static IP settings:", data);
-        }
+        var useStatic = staticIPEnabled();
+        schemaFields.forEach(function (field) {
+            if (!isNetworkField(field) || (field.staticOnly && !useStatic)) return;
+            var input = document.getElementById('field_' + field.key);
+            if (!input) return;
+            data[field.key] = (field.type === 'bool') ? input.checked : input.value.trim();
+        });
 
         var jsonData = JSON.stringify(data);
         console.log("Sending JSON data:", jsonData);
@@ -560,7 +1253,9 @@ void SukenESPWiFi::handleWiFiSettingPage() {
             }
             statusEl.textContent = text;
             statusEl.style.color = isError ? '#d32f2f' : '';
-            if (xhr.status == 200) {
+            if (res && res.status === 'pending') {
+                pollConnection(20);
+            } else if (xhr.status == 200) {
                 fetchDeviceInfo();
             } else {
                 console.error('Error:', xhr.statusText);
@@ -570,6 +1265,27 @@ void SukenESPWiFi::handleWiFiSettingPage() {
         xhr.send(jsonData);
     }
 
+    // 接続結果を待たずに応答された場合（協調モード）は ./api/info で確認する
+    function pollConnection(remaining) {
+        var statusEl = document.getElementById('statusLine');
+        fetch('./api/info')
+            .then(response => response.json())
+            .then(data => {
+                if (data.Connected) {
+                    statusEl.textContent = '接続しました: ' + (data.IP || '') + (data.IPv6 ? ' / ' + data.IPv6 : '');
+                } else if (remaining > 0) {
+                    setTimeout(function () { pollConnection(remaining - 1); }, 1000);
+                } else {
+                    statusEl.textContent = '接続に失敗しました。再試行してください';
+                    statusEl.style.color = '#d32f2f';
+                }
+            })
+            .catch(function () {
+                // 接続に成功するとAPが停止するため応答が返らない
+                statusEl.textContent = '接続した可能性があります（APが停止しました）';
+            });
+    }
+
     function fetchDeviceInfo() {
         fetch('./api/info')
             .then(response => response.json())
@@ -585,28 +1301,103 @@ void SukenESPWiFi::handleWiFiSettingPage() {
             .catch(error => console.error('Error:', error));
     }
 
-    function populateSSIDList() {
-        fetch('./api/WiFiList')
-            .then(response => response.json())
-            .then(data => {
-                var wifi_ssidSelect = document.getElementById('wifi_ssid');
-                data.networks.forEach(network => {
-                    var option = document.createElement('option');
-                    option.textContent = network;
-                    option.value = network;
-                    wifi_ssidSelect.appendChild(option);
-                });
-                var otherOption = document.createElement('option');
-                otherOption.textContent = 'その他';
-                otherOption.value = 'その他';
-                wifi_ssidSelect.appendChild(otherOption);
-            })
-            .catch(error => console.error('Error:', error));
+    // WiFi一覧は差分で更新する（scanVersion は最後に取得したバージョン）
+    var scanVersion = 0;
+    var networks = {};
+
+    function signalBars(rssi) {
+        if (rssi >= -55) return '▂▄▆█';
+        if (rssi >= -67) return '▂▄▆';
+        if (rssi >= -78) return '▂▄';
+        return '▂';
     }
 
-    function toggleOtherSSIDInput() {
-        var wifi_ssid = document.getElementById('wifi_ssid').value;
-        var otherSSIDInput = document.getElementById('other_ssid');
+    function findOption(ssid) {
+        var options = document.getElementById('wifi_ssid').options;
+        for (var i = 0; i < options.length; i++) {
+            if (options[i].value === ssid) return options[i];
+        }
+        return null;
+    }
+
+    function renderNetwork(ssid) {
+        var net = networks[ssid];
+        var option = findOption(ssid);
+        if (!option) {
+            option = document.createElement('option');
+            option.value = ssid;
+            // 「その他」は常に末尾
+            var select = document.getElementById('wifi_ssid');
+            select.insertBefore(option, findOption('その他'));
+        }
+        option.textContent = ssid + ' ' + signalBars(net.rssi) + (net.secure ? '' : ' (open)');
+    }
+
+    function applyEntry(entry) {
+        networks[entry.ssid] = entry;
+        renderNetwork(entry.ssid);
+    }
+
+    function populateSSIDList() {
+        fetch('./api/WiFiList?since=' + scanVersion)
+            .then(response => response.status === 304 ? null : response.json())
+            .then(data => {
+                if (!data) return;
+                var select = document.getElementById('wifi_ssid');
+                if (!findOption('その他')) {
+                    var otherOption = document.createElement('option');
+                    otherOption.textContent = 'その他';
+                    otherOption.value = 'その他';
+                    select.appendChild(otherOption);
+                }
+                if (data.full) {
+                    Object.keys(networks).forEach(function (ssid) {
+                        if (!data.networks.includes(ssid)) {
+                            var option = findOption(ssid);
+                            if (option) select.removeChild(option);
+                        }
+                    });
+                    networks = {};
+                    data.entries.forEach(applyEntry);
+                } else {
+                    data.added.forEach(applyEntry);
+                    data.changed.forEach(applyEntry);
+                    data.removed.forEach(function (ssid) {
+                        delete networks[ssid];
+                        var option = findOption(ssid);
+                        if (option) select.removeChild(option);
+                    });
+                }
+                scanVersion = data.version;
+            })
+            .catch(error => console.error('Error:', error));
+    }
+
+    // 電波強度はSSEで受け取り、一覧が変わったときだけ差分を取得する
+    function subscribeEvents() {
+        if (!window.EventSource) {
+            setInterval(populateSSIDList, 15000);
+            return;
+        }
+        var source = new EventSource('./api/events');
+        source.addEventListener('scan', function (e) {
+            var data = JSON.parse(e.data);
+            if (data.v !== scanVersion) populateSSIDList();
+        });
+        source.addEventListener('rssi', function (e) {
+            var data = JSON.parse(e.data);
+            Object.keys(data.rssi).forEach(function (ssid) {
+                if (!networks[ssid]) return;
+                networks[ssid].rssi = data.rssi[ssid];
+                renderNetwork(ssid);
+            });
+            if (data.v !== scanVersion) populateSSIDList();
+        });
+    }
+
+    function toggleOtherSSIDInput() {
+        var wifi_ssid = document.getElementById('wifi_ssid').value;
+        var otherSSIDInput = document.getElementById('other_ssid');
         if (wifi_ssid === 'その他') {
             otherSSIDInput.classList.remove('hidden');
         } else {
@@ -615,33 +1406,10 @@ void SukenESPWiFi::handleWiFiSettingPage() {
         }
     }
 
-    function toggleStaticIP() {
-        var staticIPForm = document.getElementById('staticIPForm');
-        var staticIPButton = event.target;
-        
-        console.log("toggleStaticIP called, current useStaticIP:", useStaticIP);
-        
-        if (useStaticIP) {
-            // StaticIPを無効にする
-            useStaticIP = false;
-            staticIPForm.style.display = 'none';
-            staticIPButton.textContent = 'StaticIP';
-            staticIPButton.classList.remove('btn-primary');
-            staticIPButton.classList.add('btn-secondary');
-            console.log("StaticIP disabled, useStaticIP:", useStaticIP);
-        } else {
-            // StaticIPを有効にする
-            useStaticIP = true;
-            staticIPForm.style.display = 'block';
-            staticIPButton.textContent = 'StaticIP (ON)';
-            staticIPButton.classList.remove('btn-secondary');
-            staticIPButton.classList.add('btn-primary');
-            console.log("StaticIP enabled, useStaticIP:", useStaticIP);
-        }
-    }
-
     window.onload = function () {
+        loadSchema();
         populateSSIDList();
+        subscribeEvents();
         fetchDeviceInfo();
     };
 
@@ -675,7 +1443,7 @@ void SukenESPWiFi::handleWiFiSettingPage() {
 </body>
 </html>
 )=====";
-    if (server_) server_->send(200, "text/html", html);
+    if (server_) server_->send_P(200, "text/html", PORTAL_HTML, sizeof(PORTAL_HTML) - 1);
 }
 
 void SukenESPWiFi::handleNotFound() {
@@ -685,15 +1453,74 @@ void SukenESPWiFi::handleNotFound() {
 }
 
 void SukenESPWiFi::handleInfoAPI() {
-    StaticJsonDocument<200> doc;
+    StaticJsonDocument<256> doc;
     doc["MAC"] = getMAC();
     doc["DeviceName"] = deviceName_;
+    doc["Connected"] = isConnected();
+    if (WiFi.status() == WL_CONNECTED) {
+        doc["IP"] = WiFi.localIP().toString();
+    }
+    if (networkConfig_.enableIPv6) {
+        String global = getGlobalIPv6();
+        String linkLocal = getLinkLocalIPv6();
+        if (global.length() > 0) doc["IPv6"] = global;
+        if (linkLocal.length() > 0) doc["IPv6LinkLocal"] = linkLocal;
+    }
+    // 応答はポータル用プールのバッファで組み立てる（足りなければ String）
+    PooledBuffer buffer(responsePool_);
+    size_t length = buffer ? serializeJson(doc, buffer.data(), buffer.size()) : 0;
+    if (length > 0 && length < buffer.size()) {
+        sendJsonWithETag(buffer.data(), length);
+        return;
+    }
     String jsonPayload;
     serializeJson(doc, jsonPayload);
-    if (server_) server_->send(200, "application/json", jsonPayload);
+    sendJsonWithETag(jsonPayload.c_str(), jsonPayload.length());
+}
+
+void SukenESPWiFi::handleSchemaAPI() {
+    // フォームの項目（キー、型、長さ、既定値、現在値）を項目表から生成する
+    WiFiCredentials credentials;
+    readWiFiCredentials(credentials);
+    JsonDoc doc;
+    configSchemaToJson(credentials, networkConfig_, doc);
+    PooledBuffer buffer(responsePool_);
+    size_t length = buffer ? serializeJson(doc, buffer.data(), buffer.size()) : 0;
+    if (length > 0 && length < buffer.size()) {
+        sendJsonWithETag(buffer.data(), length);
+        return;
+    }
+    String json;
+    serializeJson(doc, json);
+    sendJsonWithETag(json.c_str(), json.length());
+}
+
+void SukenESPWiFi::sendJsonWithETag(const char* json, size_t length) {
+    if (!server_) return;
+    // 内容のハッシュ（FNV-1a）を ETag にし、変化がなければ本文を送らない
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<uint8_t>(json[i]);
+        hash *= 16777619u;
+    }
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08lx\"", static_cast<unsigned long>(hash));
+    server_->sendHeader("ETag", etag);
+    server_->sendHeader("Cache-Control", "no-cache");
+    if (server_->header("If-None-Match") == etag) {
+        server_->send(304);
+        return;
+    }
+    server_->send_P(200, "application/json", json, length);
 }
 
 void SukenESPWiFi::handleWiFiSettingAPI() {
+    // 接続の試行中は数秒このハンドラから戻らない。同時に来た適用は待たせずに断る
+    ApplySlot slot(rateLimiter_);
+    if (!slot.acquired()) {
+        sendTooManyRequests(RouteClass::Apply, APPLY_BUSY_RETRY_SEC, "別の設定を適用中です");
+        return;
+    }
     delay(250);
     String body = server_ ? server_->arg("plain") : String();
 
@@ -712,112 +1539,70 @@ void SukenESPWiFi::handleWiFiSettingAPI() {
 
     Serial.println("JSON parsing successful");
 
+    // 項目表（SukenWiFiConfigFields.h）に従って読む。固定IPが無効なら IP 関連は既定値になる
     WiFiCredentials credentials;
-    credentials.ssid = doc["ssid"].as<String>();
-    credentials.password = doc["password"].as<String>();
+    NetworkConfig config;
+    if (!parseConfigJson(doc, credentials, config)) {
+        Serial.println("Invalid settings in JSON");
+        if (server_) server_->send(400, "application/json", "{\"message\":\"設定の値が正しくありません\",\"status\":\"error\"}");
+        return;
+    }
     
     Serial.println("Parsed SSID: " + credentials.ssid);
     Serial.println("Parsed Password: " + credentials.password);
     
-    // StaticIP設定の処理
-    Serial.println("Checking for useStaticIP key...");
-    if (doc.containsKey("useStaticIP")) {
-        Serial.println("useStaticIP key found");
-        networkConfig_.useStaticIP = doc["useStaticIP"].as<bool>();
-        Serial.println("Parsed useStaticIP: " + String(networkConfig_.useStaticIP ? "true" : "false"));
-    } else {
-        Serial.println("useStaticIP key not found in JSON");
-        networkConfig_.useStaticIP = false;
+    // 変わった項目だけを保存・反映する
+    ConfigActions actions = planConfigChange(credentials, config);
+    // saveNetworkSettings() は networkConfig_ を書き出すので先に差し替え、失敗したら戻す（applyConfig() と同じ）
+    NetworkConfig previous = networkConfig_;
+    networkConfig_ = config;
+    Serial.println("About to save settings...");
+    if (!saveConfigChanges(actions, credentials)) {
+        networkConfig_ = previous;
+        if (server_) server_->send(500, "application/json", "{\"message\":\"設定を保存できませんでした\",\"status\":\"error\",\"retry\":true}");
+        return;
     }
+    lastProvisioningTransport_ = "WebPortal";
     
-    Serial.println("Current useStaticIP value: " + String(networkConfig_.useStaticIP ? "true" : "false"));
-    
-    if (networkConfig_.useStaticIP) {
-        Serial.println("Processing static IP settings...");
-        
-        if (doc.containsKey("staticIP")) {
-            String staticIPStr = doc["staticIP"].as<String>();
-            Serial.println("Raw staticIP string: " + staticIPStr);
-            networkConfig_.staticIP.fromString(staticIPStr);
-            Serial.println("Parsed Static IP: " + networkConfig_.staticIP.toString());
-        } else {
-            Serial.println("staticIP key not found in JSON");
-        }
-        
-        if (doc.containsKey("gateway")) {
-            String gatewayStr = doc["gateway"].as<String>();
-            Serial.println("Raw gateway string: " + gatewayStr);
-            networkConfig_.gateway.fromString(gatewayStr);
-            Serial.println("Parsed Gateway: " + networkConfig_.gateway.toString());
-        } else {
-            Serial.println("gateway key not found in JSON");
-        }
-        
-        if (doc.containsKey("subnet")) {
-            String subnetStr = doc["subnet"].as<String>();
-            Serial.println("Raw subnet string: " + subnetStr);
-            networkConfig_.subnet.fromString(subnetStr);
-            Serial.println("Parsed Subnet: " + networkConfig_.subnet.toString());
-        } else {
-            Serial.println("subnet key not found in JSON");
-        }
-        
-        if (doc.containsKey("primaryDNS")) {
-            String primaryDNSStr = doc["primaryDNS"].as<String>();
-            Serial.println("Raw primaryDNS string: " + primaryDNSStr);
-            networkConfig_.primaryDNS.fromString(primaryDNSStr);
-            Serial.println("Parsed Primary DNS: " + networkConfig_.primaryDNS.toString());
-        } else {
-            Serial.println("primaryDNS key not found in JSON");
-        }
-        
-        if (doc.containsKey("secondaryDNS")) {
-            String secondaryDNSStr = doc["secondaryDNS"].as<String>();
-            Serial.println("Raw secondaryDNS string: " + secondaryDNSStr);
-            networkConfig_.secondaryDNS.fromString(secondaryDNSStr);
-            Serial.println("Parsed Secondary DNS: " + networkConfig_.secondaryDNS.toString());
-        } else {
-            Serial.println("secondaryDNS key not found in JSON");
-        }
-    } else {
-        // StaticIPが無効な場合、デフォルト値にリセット
-        Serial.println("StaticIP is false, resetting to defaults");
-        networkConfig_.useStaticIP = false;
-        networkConfig_.staticIP = IPAddress(192, 168, 1, 200);
-        networkConfig_.gateway = IPAddress(192, 168, 1, 1);
-        networkConfig_.subnet = IPAddress(255, 255, 255, 0);
-        networkConfig_.primaryDNS = IPAddress(8, 8, 8, 8);
-        networkConfig_.secondaryDNS = IPAddress(8, 8, 4, 4);
-        Serial.println("Static IP disabled, using DHCP");
+    if (!hasConfigAction(actions, ConfigAction::Reconnect)) {
+        // 接続中で SSID/パスワードが同じ。アソシエーションを保ったまま反映する
+        applyLiveConfigChanges(actions);
+        JsonDocument response;
+        response["message"] = "設定を反映しました";
+        // 固定IPへの切り替えは GOT_IP より先に応答するので、新しいアドレスを返す
+        response["ip"] = networkConfig_.useStaticIP ? networkConfig_.staticIP.toString() : WiFi.localIP().toString();
+        response["ssid"] = WiFi.SSID();
+        configActionsToJson(actions, response.createNestedArray("actions"));
+        String payload;
+        serializeJson(response, payload);
+        if (server_) server_->send(200, "application/json", payload);
+        if (setupMode_) leaveSetupModeToStation();
+        return;
     }
     
-    Serial.println("=== Final Settings ===");
-    Serial.println("useStaticIP: " + String(networkConfig_.useStaticIP ? "true" : "false"));
-    Serial.println("staticIP: " + networkConfig_.staticIP.toString());
-    Serial.println("gateway: " + networkConfig_.gateway.toString());
-    Serial.println("subnet: " + networkConfig_.subnet.toString());
-    Serial.println("primaryDNS: " + networkConfig_.primaryDNS.toString());
-    Serial.println("secondaryDNS: " + networkConfig_.secondaryDNS.toString());
-    Serial.println("=====================");
-    
-    Serial.println("About to save settings...");
-    saveWiFiCredentials(credentials);
-    saveNetworkSettings();
+    if (taskTopology_.cooperative) {
+        // 協調モードでは接続完了を待たずに応答し、接続は loop() で進める
+        fsm_.requestConnect(millis(), MAX_WIFI_RETRY * WIFI_RETRY_DELAY);
+        if (server_) server_->send(200, "application/json", "{\"message\":\"設定を保存しました。接続中...\",\"status\":\"pending\"}");
+        return;
+    }
     Serial.println("Settings saved. Trying live connection without reboot...");
 
-    // ライブ接続: セットアップモード中は AP を維持したまま接続試行
-    if (setupMode_) {
-        WiFi.mode(WIFI_AP_STA);
-    }
+    // ライブ接続: セットアップモード中は AP を維持したまま接続試行（モード切替は connectToWiFi 内）
     connectToWiFi();
 
     if (WiFi.status() == WL_CONNECTED) {
-        String payload = String("{\"message\":\"接続に成功しました\",\"ip\":\"") + WiFi.localIP().toString() + "\",\"ssid\":\"" + WiFi.SSID() + "\"}";
+        JsonDocument response;
+        response["message"] = "接続に成功しました";
+        response["ip"] = WiFi.localIP().toString();
+        response["ssid"] = WiFi.SSID();
+        configActionsToJson(actions, response.createNestedArray("actions"));
+        String payload;
+        serializeJson(response, payload);
         if (server_) server_->send(200, "application/json", payload);
         Serial.println("Connected. Shutting down AP/portal...");
         // ポータルを終了して STA のみに移行
-        exitSetupMode();
-        WiFi.mode(WIFI_STA);
+        leaveSetupModeToStation();
         return;
     } else {
         if (server_) server_->send(200, "application/json", "{\"message\":\"接続に失敗しました。再試行してください\",\"status\":\"error\",\"retry\":true}" );
@@ -827,46 +1612,374 @@ void SukenESPWiFi::handleWiFiSettingAPI() {
 }
 
 void SukenESPWiFi::handleWiFiListAPI() {
+    if (!server_) return;
+    // ?since=<最後に見たバージョン> なら差分、同じバージョンなら 304
+    uint32_t since = 0;
+    if (server_->hasArg("since")) {
+        since = strtoul(server_->arg("since").c_str(), nullptr, 10);
+    }
+    JsonDoc doc;
+    server_->sendHeader("Cache-Control", "no-cache");
+    if (!scanTable_.toJson(since, doc)) {
+        server_->send(304);
+        return;
+    }
+    PooledBuffer buffer(responsePool_);
+    size_t length = buffer ? serializeJson(doc, buffer.data(), buffer.size()) : 0;
+    if (length > 0 && length < buffer.size()) {
+        server_->send_P(200, "application/json", buffer.data(), length);
+        return;
+    }
     String json;
-    serializeJsonPretty(wifiList_, json);
-    if (server_) server_->send(200, "application/json", json);
+    serializeJson(doc, json);
+    server_->send(200, "application/json", json);
+}
+
+void SukenESPWiFi::handleEventsAPI() {
+    if (!server_) return;
+    for (size_t i = 0; i < MAX_SSE_CLIENTS; ++i) {
+        if (sseClients_[i].connected()) continue;
+        // 接続を WebServer から引き取り、以降のイベントはこのクライアントに直接書き込む
+        sseClients_[i] = static_cast<PortalServer*>(server_)->detachClient();
+        sseClients_[i].print("HTTP/1.1 200 OK\r\n"
+                             "Content-Type: text/event-stream\r\n"
+                             "Cache-Control: no-cache\r\n"
+                             "Connection: keep-alive\r\n\r\n"
+                             "retry: 10000\n\n");
+        JsonDoc doc;
+        scanTable_.rssiToJson(doc);
+        String data;
+        serializeJson(doc, data);
+        sseClients_[i].print("event: rssi\ndata: " + data + "\n\n");
+        return;
+    }
+    server_->send(503, "text/plain", "Too many event clients");
+}
+
+void SukenESPWiFi::broadcastScanEvents(bool listChanged) {
+    String message;
+    if (listChanged) {
+        // 一覧の変化はバージョンだけ通知し、クライアントが差分を取得する
+        message += "event: scan\ndata: {\"v\":" + String(scanTable_.version()) + "}\n\n";
+    }
+    JsonDoc doc;
+    scanTable_.rssiToJson(doc);
+    String data;
+    serializeJson(doc, data);
+    message += "event: rssi\ndata: " + data + "\n\n";
+    for (size_t i = 0; i < MAX_SSE_CLIENTS; ++i) {
+        if (sseClients_[i].connected()) sseClients_[i].print(message);
+    }
+    lastSseKeepaliveMs_ = millis();
+}
+
+void SukenESPWiFi::serviceSse(uint32_t now) {
+    if (now - lastSseKeepaliveMs_ < SSE_KEEPALIVE_MS) return;
+    lastSseKeepaliveMs_ = now;
+    for (size_t i = 0; i < MAX_SSE_CLIENTS; ++i) {
+        if (sseClients_[i].connected()) {
+            sseClients_[i].print(": keepalive\n\n");
+        } else {
+            sseClients_[i].stop();
+        }
+    }
 }
 
 void SukenESPWiFi::taskMain(void* args) {
     SukenESPWiFi* instance = static_cast<SukenESPWiFi*>(args);
+    instance->startPortalServices();
     
-    Serial.print("mDNS server instancing");
-    if (!MDNS.begin(instance->wifiName_.c_str())) {
-        Serial.println("Error setting up MDNS responder!");
-        while (1) {
-            delay(100);
+    while (1) {
+        if (instance->portalTeardownPending_) instance->stopPortal();
+        if (!instance->setupMode_ || instance->server_ == nullptr) {
+            Serial.println("Setup mode ended. Stopping portal task.");
+            instance->finishTask(LibraryTask::Portal);
+            vTaskDelete(nullptr);
         }
+        instance->servicePortal();
+        instance->taskDelay(1);
     }
-    Serial.println("mDNSを開始しました");
-    MDNS.addService("http", "tcp", 80);
-    instance->dnsServer_.setErrorReplyCode(DNSReplyCode::NoError);
-    instance->dnsServer_.setTTL(300);
-    instance->dnsServer_.start(DEFAULT_DNS_PORT, "*", instance->apIP_);
+}
+
+void SukenESPWiFi::startPortalServices() {
+#if SUKEN_WIFI_MDNS
+    Serial.print("mDNS server instancing");
+    markPhaseStart(BootPhase::Mdns);
+    // 失敗してもポータル自体は IP で使えるので止めない（servicePortal() で再試行する）
+    if (mdns_.begin(wifiName_)) {
+        Serial.println("mDNSを開始しました");
+        markPhaseEnd(BootPhase::Mdns);
+    } else {
+        Serial.println("Error setting up MDNS responder! Retrying later.");
+    }
+#endif
+    dnsServer_->start(DEFAULT_DNS_PORT, apIP_);
     Serial.println("DNSサーバーを開始しました");
-    instance->setupWebServer();
+    setupWebServer();
+    markPhaseEnd(BootPhase::PortalStart);
     Serial.println("Webサーバー開始");
+}
+
+void SukenESPWiFi::servicePortal() {
+    if (dnsServer_) dnsServer_->processNextRequest();
+    if (server_) {
+        servingRequest_ = true;
+        server_->handleClient();
+        servingRequest_ = false;
+    }
+    // ハンドラ内で停止が要求された（接続に成功してポータルを閉じる場合など）
+    if (portalTeardownPending_) {
+        stopPortal();
+        return;
+    }
+    uint32_t now = millis();
+    // WiFi一覧の定期再スキャン（非同期。接続試行中は行わない）
+    if (scanInProgress_) {
+        pollAsyncScan();
+    } else if (scanRefreshIntervalMs_ > 0 && now - lastScanMs_ >= scanRefreshIntervalMs_ &&
+               fsm_.state() != LinkState::PortalConnecting) {
+        startAsyncScan();
+    }
+    serviceSse(now);
+    mdns_.poll(now);
+    pollProvisioningTransports();
+    // 定期的に既存WiFiへの再接続を試みる（成功したらポータル終了）
+    // （協調モードでは ConnectionFsm が同じ周期で行う。スキャン中は待つ）
+    if (!taskTopology_.cooperative && !scanInProgress_ && autoReconnectDuringSetup_ && (now - lastSetupReconnectMs_ >= SETUP_RECONNECT_INTERVAL_MS)) {
+        lastSetupReconnectMs_ = now;
+        attemptReconnectNonBlocking();
+    }
+}
+
+void SukenESPWiFi::loop() {
+    if (!taskTopology_.cooperative) return;
+    int64_t start = esp_timer_get_time();
+    uint32_t now = millis();
     
-    while (1) {
-        if (!instance->setupMode_ || instance->server_ == nullptr) {
-            Serial.println("Setup mode ended. Stopping portal task.");
-            vTaskDelete(nullptr);
+    if (apConfigPending_ && apStarted_) {
+        apConfigPending_ = false;
+        WiFi.softAPConfig(apIP_, apIP_, IPAddress(255, 255, 255, 0));
+    }
+    if (scanInProgress_) {
+        pollAsyncScan();
+    }
+    
+    // 接続状態機械を1ステップ進める（各操作はブロックしない）
+    syncFsmPolicy();
+    applyLinkEvents(now);
+    switch (fsm_.tick(now)) {
+        case FsmAction::BeginConnect:
+            beginStationConnect();
+            break;
+        case FsmAction::EnterPortal:
+            Serial.println("WiFi接続失敗");
+            enterSetupMode();
+            break;
+        case FsmAction::ExitPortal:
+            Serial.println("Exiting setup mode due to successful connection.");
+            leaveSetupModeToStation();
+            break;
+        default:
+            break;
+    }
+    if (!initComplete_ && (fsm_.state() == LinkState::Connected || fsm_.inPortal())) {
+        finishInit();
+    }
+    
+    if (setupMode_ && server_) {
+        servicePortal();
+    }
+    if (!setupMode_) mdns_.poll(now);
+    // 協調モードではブロッキングの HTTP プローブは行わない
+    if (healthMonitor_.tick(now, false)) {
+        softReconnect();
+    }
+    offlineQueue_.persistPending(now, false);
+    persistLinkRecord();
+    if (queueDrainPending_ && WiFi.status() == WL_CONNECTED &&
+        now - lastQueueBatchMs_ >= offlineQueue_.config().batchIntervalMs) {
+        lastQueueBatchMs_ = now;
+        if (!drainQueueBatch()) {
+            queueDrainPending_ = false;
+            offlineQueue_.syncFlash();
         }
-        instance->dnsServer_.processNextRequest();
-        if (instance->server_) instance->server_->handleClient();
-        // 定期的に既存WiFiへの再接続を試みる（成功したらポータル終了）
-        uint32_t now = millis();
-        if (instance->autoReconnectDuringSetup_ && (now - instance->lastSetupReconnectMs_ >= SETUP_RECONNECT_INTERVAL_MS)) {
-            instance->lastSetupReconnectMs_ = now;
-            instance->attemptReconnectNonBlocking();
+    }
+    
+    uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+    loopStats_.calls++;
+    loopStats_.lastUs = elapsed;
+    if (elapsed > loopStats_.maxUs) loopStats_.maxUs = elapsed;
+    loopTotalUs_ += elapsed;
+    loopStats_.avgUs = static_cast<uint32_t>(loopTotalUs_ / loopStats_.calls);
+}
+
+LoopStats SukenESPWiFi::getLoopStats() const { return loopStats_; }
+
+void SukenESPWiFi::resetLoopStats() {
+    loopStats_ = LoopStats();
+    loopTotalUs_ = 0;
+}
+
+void SukenESPWiFi::initCooperative() {
+    // ブロックする処理（スキャン、接続待ち）は行わず、loop() の状態機械に任せる
+    bool cachedBegin = (initMode_ == InitMode::Deferred) && beginFromCachedConfig();
+    mountStorage();
+    markPhaseStart(BootPhase::SettingsLoad);
+    readNetworkSettings();
+    markPhaseEnd(BootPhase::SettingsLoad);
+    bool imported = importProvisioningFile();
+    
+    syncFsmPolicy();
+    if (credentialsStored_) {
+        // キャッシュ設定で接続中なら待つだけ。取り込みや静的IPがあれば接続し直す
+        bool beginNow = !cachedBegin || imported || networkConfig_.useStaticIP;
+        fsm_.requestConnect(millis(), MAX_WIFI_RETRY * WIFI_RETRY_DELAY, beginNow);
+    } else {
+        Serial.println("WiFi接続失敗");
+        enterSetupMode();
+    }
+    if (blockSetup_) {
+        waitUntilConnected(0);
+    }
+}
+
+void SukenESPWiFi::syncFsmPolicy() {
+    FsmPolicy policy;
+    policy.attemptsBeforePortal = disconnectRetryAttemptsBeforeAP_;
+    policy.retryDelayMs = disconnectRetryDelayMs_;
+    policy.portalRetryIntervalMs = SETUP_RECONNECT_INTERVAL_MS;
+    policy.portalAttemptMs = SETUP_RECONNECT_ATTEMPT_MS;
+    policy.autoPortal = autoSetupOnDisconnect_;
+    policy.retryInPortal = autoReconnectDuringSetup_;
+    fsm_.setPolicy(policy);
+    fsm_.setHasCredentials(credentialsStored_);
+}
+
+void SukenESPWiFi::postLinkEvent(bool up) {
+    uint8_t event = up ? LINK_EVENT_UP : LINK_EVENT_DOWN;
+    if (!linkEvents_ || xQueueSend(linkEvents_, &event, 0) != pdTRUE) {
+        Serial.println("Link event dropped (loop() not called?)");
+    }
+}
+
+void SukenESPWiFi::applyLinkEvents(uint32_t now) {
+    if (!linkEvents_) return;
+    uint8_t event;
+    // 起きた順に適用する（切断→再接続が1回の loop() の間に起きても最後は Connected）
+    while (xQueueReceive(linkEvents_, &event, 0) == pdTRUE) {
+        if (event == LINK_EVENT_UP) {
+            fsm_.onLinkUp(now);
+        } else {
+            fsm_.onLinkDown(now);
         }
-        delay(1);
     }
 }
+
+void SukenESPWiFi::beginStationConnect() {
+    WiFiCredentials creds;
+    readWiFiCredentials(creds);
+    if (creds.ssid.length() == 0) return;
+    if (scanInProgress_) {
+        // 接続を優先し、一覧の再スキャンは次の周期に回す
+        esp_wifi_scan_stop();
+        scanInProgress_ = false;
+        markPhaseEnd(BootPhase::Scan);
+        lastScanMs_ = millis();
+    }
+    setRadioMode(setupMode_ ? WIFI_AP_STA : WIFI_STA);
+    prepareStationConnect(creds.ssid);
+    WiFi.setHostname(deviceName_.c_str());
+    markPhaseStart(BootPhase::Associate);
+    WiFi.begin(creds.ssid.c_str(), creds.password.c_str());
+}
+
+void SukenESPWiFi::setTaskTopology(const TaskTopology& topology) { taskTopology_ = topology; }
+TaskTopology SukenESPWiFi::getTaskTopology() const { return taskTopology_; }
+
+const TaskConfig& SukenESPWiFi::taskConfig(LibraryTask task) const {
+    switch (task) {
+        case LibraryTask::Reconnect: return taskTopology_.reconnect;
+        case LibraryTask::Dispatcher: return taskTopology_.dispatcher;
+        case LibraryTask::Init: return taskTopology_.init;
+        case LibraryTask::Health: return taskTopology_.health;
+        default: return taskTopology_.portal;
+    }
+}
+
+TaskHandle_t* SukenESPWiFi::taskHandleSlot(LibraryTask task) {
+    switch (task) {
+        case LibraryTask::Reconnect: return &reconnectTaskHandle_;
+        case LibraryTask::Dispatcher: return &queueTaskHandle_;
+        case LibraryTask::Init: return &initTaskHandle_;
+        case LibraryTask::Health: return &healthTaskHandle_;
+        default: return &taskHandle_;
+    }
+}
+
+bool SukenESPWiFi::spawnTask(LibraryTask task, TaskFunction_t entry, const char* name) {
+    size_t i = static_cast<size_t>(task);
+    const TaskConfig& config = taskConfig(task);
+    taskStartUs_[i] = esp_timer_get_time();
+    taskSleptUs_[i] = 0;
+    taskStats_[i].running = true;
+    taskStats_[i].runs++;
+    if (xTaskCreatePinnedToCore(entry, name, config.stackSize, this, config.priority, taskHandleSlot(task), config.core) != pdPASS) {
+        Serial.println(String("Failed to create task: ") + name);
+        taskStats_[i].running = false;
+        *taskHandleSlot(task) = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SukenESPWiFi::finishTask(LibraryTask task) {
+    size_t i = static_cast<size_t>(task);
+    TaskStats& stats = taskStats_[i];
+    int64_t elapsed = esp_timer_get_time() - taskStartUs_[i];
+    if (elapsed > static_cast<int64_t>(taskSleptUs_[i])) {
+        stats.busyUs += elapsed - taskSleptUs_[i];
+    }
+    // ESP-IDF ではスタックの単位はバイト
+    uint32_t highWaterMark = uxTaskGetStackHighWaterMark(nullptr);
+    if (stats.stackHighWaterMark == 0 || highWaterMark < stats.stackHighWaterMark) {
+        stats.stackHighWaterMark = highWaterMark;
+    }
+    stats.running = false;
+    *taskHandleSlot(task) = nullptr;
+}
+
+void SukenESPWiFi::taskDelay(uint32_t ms) {
+    int64_t start = esp_timer_get_time();
+    delay(ms);
+    // 呼び出し元がライブラリのタスクなら待機時間として記録する
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < static_cast<size_t>(LibraryTask::Count); ++i) {
+        if (*taskHandleSlot(static_cast<LibraryTask>(i)) == current) {
+            taskSleptUs_[i] += esp_timer_get_time() - start;
+            break;
+        }
+    }
+}
+
+TaskStats SukenESPWiFi::getTaskStats(LibraryTask task) const {
+    size_t i = static_cast<size_t>(task);
+    TaskStats stats = taskStats_[i];
+    if (!stats.running) return stats;
+    // 実行中のタスクは現在値を反映
+    TaskHandle_t handle = *const_cast<SukenESPWiFi*>(this)->taskHandleSlot(task);
+    if (handle) {
+        uint32_t highWaterMark = uxTaskGetStackHighWaterMark(handle);
+        if (stats.stackHighWaterMark == 0 || highWaterMark < stats.stackHighWaterMark) {
+            stats.stackHighWaterMark = highWaterMark;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - taskStartUs_[i];
+    if (elapsed > static_cast<int64_t>(taskSleptUs_[i])) {
+        stats.busyUs += elapsed - taskSleptUs_[i];
+    }
+    return stats;
+}
+
 void SukenESPWiFi::attemptReconnectNonBlocking() {
     if (!setupMode_) return;
     if (WiFi.status() == WL_CONNECTED) return;
@@ -874,38 +1987,192 @@ void SukenESPWiFi::attemptReconnectNonBlocking() {
     readWiFiCredentials(creds);
     if (creds.ssid.length() == 0) return;
     Serial.println("[SetupMode] Trying to reconnect to stored WiFi...");
-    WiFi.mode(WIFI_AP_STA);
-    if (networkConfig_.useStaticIP) {
-        WiFi.config(networkConfig_.staticIP, networkConfig_.gateway, networkConfig_.subnet, networkConfig_.primaryDNS, networkConfig_.secondaryDNS);
-    }
+    setRadioMode(WIFI_AP_STA);
+    prepareStationConnect(creds.ssid);
     WiFi.begin(creds.ssid.c_str(), creds.password.c_str());
     // 短時間だけポーリング
     uint8_t attempts = 0;
     while (WiFi.status() != WL_CONNECTED && attempts < 6) { // 約3秒
-        delay(500);
+        taskDelay(500);
         attempts++;
     }
     if (WiFi.status() == WL_CONNECTED) {
         Serial.println("[SetupMode] Reconnected successfully. Exiting setup mode.");
-        exitSetupMode();
-        WiFi.mode(WIFI_STA);
+        leaveSetupModeToStation();
     }
 }
 
 void SukenESPWiFi::setupWebServer() {
     if (!server_) return;
-    server_->on("/", [this]() { this->handleWiFiSettingPage(); });
-    server_->on("/api/info", [this]() { this->handleInfoAPI(); });
-    server_->onNotFound([this]() { this->handleNotFound(); });
-    server_->on("/WiFiSetting", [this]() { this->handleWiFiSettingPage(); });
+    // 各ハンドラの前にクライアントIPごとの受付制限を確認する
+    server_->on("/", [this]() { if (this->admitPortalRequest(RouteClass::Page)) this->handleWiFiSettingPage(); });
+    server_->on("/api/info", [this]() { if (this->admitPortalRequest(RouteClass::Api)) this->handleInfoAPI(); });
+    server_->on("/api/schema", [this]() { if (this->admitPortalRequest(RouteClass::Api)) this->handleSchemaAPI(); });
+    server_->onNotFound([this]() { if (this->admitPortalRequest(RouteClass::Page)) this->handleNotFound(); });
+    server_->on("/WiFiSetting", [this]() { if (this->admitPortalRequest(RouteClass::Page)) this->handleWiFiSettingPage(); });
     server_->sendHeader("Access-Control-Allow-Origin", "*");
     server_->sendHeader("Access-Control-Max-Age", "10000");
     server_->sendHeader("Content-Length", "0");
-    server_->on("/api/WiFiSetting", HTTP_POST, [this]() { this->handleWiFiSettingAPI(); });
-    server_->on("/api/WiFiList", [this]() { this->handleWiFiListAPI(); });
+    server_->on("/api/WiFiSetting", HTTP_POST, [this]() { if (this->admitPortalRequest(RouteClass::Apply)) this->handleWiFiSettingAPI(); });
+    server_->on("/api/WiFiList", [this]() { if (this->admitPortalRequest(RouteClass::Api)) this->handleWiFiListAPI(); });
+    server_->on("/api/events", [this]() { if (this->admitPortalRequest(RouteClass::Api)) this->handleEventsAPI(); });
+    // ETag 検証用に If-None-Match を受け取る
+    const char* headerKeys[] = {"If-None-Match"};
+    server_->collectHeaders(headerKeys, 1);
     server_->begin();
 }
 
+void SukenESPWiFi::setRadioMode(wifi_mode_t mode) {
+    if (radioBatchDepth_ > 0) {
+        // バッチ中は最後に要求されたモードだけを覚えておく
+        pendingRadioMode_ = mode;
+        radioModePending_ = true;
+        return;
+    }
+    if (WiFi.getMode() == mode) return;
+    WiFi.mode(mode);
+    radioModeTransitions_++;
+}
+
+void SukenESPWiFi::beginRadioBatch() {
+    radioBatchDepth_++;
+}
+
+void SukenESPWiFi::endRadioBatch() {
+    if (radioBatchDepth_ == 0) return;
+    if (--radioBatchDepth_ > 0 || !radioModePending_) return;
+    radioModePending_ = false;
+    setRadioMode(pendingRadioMode_);
+}
+
+void SukenESPWiFi::leaveSetupModeToStation() {
+    beginRadioBatch();
+    exitSetupMode();
+    setRadioMode(WIFI_STA);
+    endRadioBatch();
+}
+
+uint32_t SukenESPWiFi::getRadioModeTransitionCount() const { return radioModeTransitions_; }
+
+void SukenESPWiFi::setSoftAPConfig(const SoftAPConfig& config) {
+    softAPConfig_ = config;
+    if (softAPConfig_.channel > 13) softAPConfig_.channel = 0;
+    if (softAPConfig_.maxClients < 1) softAPConfig_.maxClients = 1;
+    if (softAPConfig_.maxClients > 10) softAPConfig_.maxClients = 10;
+    if (softAPConfig_.beaconIntervalTu < 100) softAPConfig_.beaconIntervalTu = 100;
+    if (softAPConfig_.beaconIntervalTu > 60000) softAPConfig_.beaconIntervalTu = 60000;
+    if (softAPConfig_.password.length() > 0 && softAPConfig_.password.length() < 8) {
+        Serial.println("AP password must be at least 8 characters. Using open AP.");
+        softAPConfig_.password = "";
+    }
+}
+
+SoftAPConfig SukenESPWiFi::getSoftAPConfig() const { return softAPConfig_; }
+
+APStats SukenESPWiFi::getAPStats() const { return apStats_; }
+
+std::vector<APClientInfo> SukenESPWiFi::getAPClients() const {
+    std::vector<APClientInfo> clients;
+    uint32_t now = millis();
+    for (size_t i = 0; i < MAX_AP_CLIENT_RECORDS; ++i) {
+        if (apClients_[i].associations == 0) continue;
+        APClientInfo info = apClients_[i];
+        if (info.connected) info.associatedMs = now - info.associatedAtMs;
+        clients.push_back(info);
+    }
+    return clients;
+}
+
+uint8_t SukenESPWiFi::selectAPChannel() {
+    if (softAPConfig_.channel != 0) return softAPConfig_.channel;
+    if (softAPConfig_.alignToStoredNetwork) {
+        // AP_STA では STA のチャネルに AP が引きずられるため、最初から合わせておく
+        if (WiFi.status() == WL_CONNECTED) return static_cast<uint8_t>(WiFi.channel());
+        WiFiCredentials creds;
+        readWiFiCredentials(creds);
+        if (creds.ssid.length() > 0) {
+            const ScanEntry* entry = scanTable_.lookup(creds.ssid);
+            if (entry && entry->channel != 0) return entry->channel;
+            // スキャンに見えなければ前回接続時のチャネル
+            persistLinkRecord();
+            String channel;
+            if (storageMounted_ && store_.readLog("/wifi_state.log", "channel", channel) && channel.toInt() > 0) {
+                return static_cast<uint8_t>(channel.toInt());
+            }
+        }
+    }
+    // スキャン結果がなければ 1ch
+    return scanTable_.leastCongestedChannel();
+}
+
+void SukenESPWiFi::applyAPBeaconInterval() {
+    if (softAPConfig_.beaconIntervalTu == 100) return; // 既定値
+    wifi_config_t conf;
+    if (esp_wifi_get_config(WIFI_IF_AP, &conf) != ESP_OK) return;
+    conf.ap.beacon_interval = softAPConfig_.beaconIntervalTu;
+    esp_wifi_set_config(WIFI_IF_AP, &conf);
+}
+
+void SukenESPWiFi::recordAPClient(const uint8_t* mac, bool connected) {
+    uint32_t now = millis();
+    APClientInfo* slot = nullptr;
+    APClientInfo* empty = nullptr;
+    APClientInfo* oldest = nullptr;
+    for (size_t i = 0; i < MAX_AP_CLIENT_RECORDS; ++i) {
+        APClientInfo& c = apClients_[i];
+        if (c.associations == 0) {
+            if (!empty) empty = &c;
+        } else if (memcmp(c.mac, mac, 6) == 0) {
+            slot = &c;
+            break;
+        } else if (!c.connected && (!oldest || c.associatedAtMs < oldest->associatedAtMs)) {
+            oldest = &c;
+        }
+    }
+    if (connected) {
+        apStats_.associations++;
+        apStats_.clients++;
+        if (!slot) {
+            // 空きがなければ最も古い切断済みの記録を再利用する
+            slot = empty ? empty : oldest;
+            if (!slot) return;
+            *slot = APClientInfo();
+            memcpy(slot->mac, mac, 6);
+        }
+        slot->connected = true;
+        slot->associations++;
+        slot->associatedAtMs = now;
+        slot->ipAssignMs = 0;
+    } else {
+        apStats_.disassociations++;
+        if (apStats_.clients > 0) apStats_.clients--;
+        if (slot && slot->connected) {
+            slot->connected = false;
+            slot->associatedMs = now - slot->associatedAtMs;
+        }
+    }
+}
+
+void SukenESPWiFi::recordAPClientIP(const IPAddress& ip) {
+    // イベントに MAC が含まれないため、IP 未割り当ての最新の接続に対応付ける
+    APClientInfo* latest = nullptr;
+    for (size_t i = 0; i < MAX_AP_CLIENT_RECORDS; ++i) {
+        APClientInfo& c = apClients_[i];
+        if (!c.connected || c.ipAssignMs != 0) continue;
+        if (!latest || c.associatedAtMs > latest->associatedAtMs) latest = &c;
+    }
+    if (!latest) return;
+    latest->ip = ip;
+    latest->ipAssignMs = millis() - latest->associatedAtMs;
+    if (latest->ipAssignMs == 0) latest->ipAssignMs = 1;
+}
+
+void SukenESPWiFi::setScanRefreshInterval(uint32_t intervalMs) {
+    // スキャンのたびに STA が全チャネルを巡回し、その間 AP のクライアントとの通信が止まる
+    if (intervalMs > 0 && intervalMs < MIN_SCAN_REFRESH_INTERVAL_MS) intervalMs = MIN_SCAN_REFRESH_INTERVAL_MS;
+    scanRefreshIntervalMs_ = intervalMs;
+}
+
 bool SukenESPWiFi::isValidHostname(const String& hostname) const {
     if (hostname.length() < 1 || hostname.length() > 63) {
         return false;
@@ -921,30 +2188,17 @@ bool SukenESPWiFi::isValidHostname(const String& hostname) const {
 void SukenESPWiFi::connectToWiFi() {
     WiFiCredentials credentials;
     // セットアップモード中は AP を維持したまま接続を試行
-    wifi_mode_t currentMode = WiFi.getMode();
-    if (setupMode_) {
-        if (currentMode != WIFI_AP_STA) {
-            WiFi.mode(WIFI_AP_STA);
-        }
-    } else {
-        if (currentMode != WIFI_STA) {
-            WiFi.mode(WIFI_STA);
-        }
-    }
+    setRadioMode(setupMode_ ? WIFI_AP_STA : WIFI_STA);
     readWiFiCredentials(credentials);
+    prepareStationConnect(credentials.ssid);
     
-    if (networkConfig_.useStaticIP) {
-        if (!WiFi.config(networkConfig_.staticIP, networkConfig_.gateway, networkConfig_.subnet, networkConfig_.primaryDNS, networkConfig_.secondaryDNS)) {
-            Serial.println("Static IP configuration failed");
-        }
-    }
-    
+    markPhaseStart(BootPhase::Associate);
     WiFi.begin(credentials.ssid.c_str(), credentials.password.c_str());
     WiFi.setHostname(deviceName_.c_str());
     
     int attempts = 0;
     while (WiFi.status() != WL_CONNECTED && attempts < MAX_WIFI_RETRY) {
-        delay(WIFI_RETRY_DELAY);
+        taskDelay(WIFI_RETRY_DELAY);
         Serial.print(".");
         attempts++;
     }
@@ -953,18 +2207,50 @@ void SukenESPWiFi::connectToWiFi() {
     if (WiFi.status() == WL_CONNECTED) {
         Serial.println("Connected to WiFi");
         Serial.println("IP Address: " + WiFi.localIP().toString());
-        if (!MDNS.begin(deviceName_.c_str())) {
-            Serial.println("Error setting up MDNS responder!");
-        } else {
-            Serial.println("mDNS responder started. You can now access the device at http://" + deviceName_ + ".local");
-            MDNS.addService("http", "tcp", 80);
-        }
     } else {
         Serial.println("Failed to connect to WiFi");
     }
 }
 
+void SukenESPWiFi::startStationMdns() {
+#if SUKEN_WIFI_MDNS
+    // 開始済みなら再告知だけを行い、再接続後に名前が引けるまでの時間を縮める
+    if (mdns_.running()) {
+        mdns_.begin(deviceName_);
+        return;
+    }
+    markPhaseStart(BootPhase::Mdns);
+    if (!mdns_.begin(deviceName_)) {
+        Serial.println("Error setting up MDNS responder! Retrying later.");
+        return;
+    }
+    Serial.println("mDNS responder started. You can now access the device at http://" + deviceName_ + ".local");
+    markPhaseEnd(BootPhase::Mdns);
+#endif
+}
+
+void SukenESPWiFi::addMdnsService(const String& service, const String& proto, uint16_t port) {
+    mdns_.addService(service, proto, port);
+}
+
+void SukenESPWiFi::removeMdnsService(const String& service, const String& proto) {
+    mdns_.removeService(service, proto);
+}
+
+void SukenESPWiFi::setMdnsTxt(const String& service, const String& proto, const String& key, const String& value) {
+    mdns_.setTxt(service, proto, key, value);
+}
+
+MdnsStats SukenESPWiFi::getMdnsStats() const { return mdns_.stats(); }
+
 void SukenESPWiFi::readWiFiCredentials(WiFiCredentials& credentials) const {
+    if (fastPathActive_ && !storageMounted_ && connectionRecordValid()) {
+        // 高速パスでは SPIFFS をマウントしていないので RTC の記録を使う（再接続時など）
+        credentials.ssid = rtcConnectionRecord.ssid;
+        credentials.password = rtcConnectionRecord.key;
+        credentials.isPmk = (rtcConnectionRecord.flags & CONNECTION_FLAG_PMK) != 0;
+        return;
+    }
     File file = SPIFFS.open("/wifi_credentials.txt", "r");
     if (file) {
         while (file.available()) {
@@ -978,6 +2264,10 @@ void SukenESPWiFi::readWiFiCredentials(WiFiCredentials& credentials) const {
                     credentials.ssid = value;
                 } else if (key.equals("Password")) {
                     credentials.password = value;
+                    credentials.isPmk = false;
+                } else if (key.equals("PMK")) {
+                    credentials.password = value;
+                    credentials.isPmk = true;
                 }
             }
         }
@@ -991,24 +2281,215 @@ void SukenESPWiFi::readWiFiCredentials(WiFiCredentials& credentials) const {
 void SukenESPWiFi::saveWiFiCredentials(const WiFiCredentials& credentials) {
     Serial.println("Saving WiFi credentials...");
     
-    // ファイルが存在する場合は削除
-    if (SPIFFS.exists("/wifi_credentials.txt")) {
-        SPIFFS.remove("/wifi_credentials.txt");
-        Serial.println("Removed existing wifi_credentials.txt");
+    String content = "SSID=" + credentials.ssid + "\r\n";
+    uint8_t pmk[PMK_LENGTH];
+    if (credentials.isPmk || isHexPmk(credentials.password)) {
+        content += "PMK=" + credentials.password + "\r\n";
+    } else if (pmkStorage_ && derivePmk(credentials.ssid, credentials.password, pmk)) {
+        // パスフレーズは保存しない
+        content += "PMK=" + pmkToHex(pmk) + "\r\n";
+    } else {
+        // オープンネットワーク（空）や PMK を使わない設定
+        content += "Password=" + credentials.password + "\r\n";
     }
-    
-    File file = SPIFFS.open("/wifi_credentials.txt", "w");
-    if (file) {
-        file.println("SSID=" + credentials.ssid);
-        file.println("Password=" + credentials.password);
-        file.close();
-        Serial.println("WiFi credentials saved successfully.");
-        Serial.println("File size: " + String(SPIFFS.open("/wifi_credentials.txt", "r").size()) + " bytes");
+    // 内容が変わっていなければ書き込まない
+    if (store_.write("/wifi_credentials.txt", content)) {
+        credentialsStored_ = true;
+        // 次の GOT_IP で新しい接続先を記録し直す
+        rtcConnectionRecord.magic = 0;
+        // トランザクション中は commit() の結果を saveConfigChanges() が表示する
+        if (!store_.inTransaction()) Serial.println("WiFi credentials saved successfully.");
     } else {
         Serial.println("Error saving WiFi credentials to SPIFFS");
     }
 }
 
+bool SukenESPWiFi::parseConfigJson(const JsonDoc& doc, WiFiCredentials& credentials, NetworkConfig& config) const {
+    return parseConfigFields(doc, credentials, config);
+}
+
+ProvisionResult SukenESPWiFi::applyConfig(const WiFiCredentials& credentials, const NetworkConfig& config, bool verify) {
+    if (credentials.ssid.length() == 0 || credentials.ssid.length() > 32 || credentials.password.length() > 64) {
+        lastConfigActions_ = 0;
+        return ProvisionResult::InvalidInput;
+    }
+    // Busy のときは実行中の適用の結果なので lastConfigActions_ を触らない
+    ApplySlot slot(rateLimiter_);
+    if (!slot.acquired()) return ProvisionResult::Busy;
+    lastConfigActions_ = 0;
+    if (!storageMounted_) mountStorage();
+    if (!storageMounted_) return ProvisionResult::SaveFailed;
+    
+    ConfigActions actions = planConfigChange(credentials, config);
+    // saveNetworkSettings() は networkConfig_ を書き出すので先に差し替え、失敗したら戻す
+    NetworkConfig previous = networkConfig_;
+    networkConfig_ = config;
+    if (!verify) {
+        // 保存だけ行う（起動時の取り込みなど）。反映は次の接続で行われる
+        actions &= static_cast<uint8_t>(ConfigAction::SaveCredentials) | static_cast<uint8_t>(ConfigAction::SaveNetwork);
+        lastConfigActions_ = actions;
+    }
+    if (!saveConfigChanges(actions, credentials)) {
+        networkConfig_ = previous;
+        return ProvisionResult::SaveFailed;
+    }
+    if (!verify) return ProvisionResult::Ok;
+    
+    if (hasConfigAction(actions, ConfigAction::Reconnect)) {
+        connectToWiFi();
+        if (WiFi.status() != WL_CONNECTED) return ProvisionResult::ConnectFailed;
+    } else {
+        applyLiveConfigChanges(actions);
+    }
+    if (setupMode_) leaveSetupModeToStation();
+    return ProvisionResult::Ok;
+}
+
+ConfigActions SukenESPWiFi::getLastConfigActions() const { return lastConfigActions_; }
+
+ConfigActions SukenESPWiFi::planConfigChange(const WiFiCredentials& credentials, const NetworkConfig& config) {
+    WiFiCredentials stored;
+    if (credentialsStored_) readWiFiCredentials(stored);
+    WiFiCredentials candidate = credentials;
+    // PMK で保存している場合は、新しいパスフレーズも PMK にして比べる
+    if (stored.isPmk && candidate.ssid == stored.ssid && !isHexPmk(candidate.password)) {
+        uint8_t pmk[PMK_LENGTH];
+        if (derivePmk(candidate.ssid, candidate.password, pmk)) candidate.password = pmkToHex(pmk);
+    }
+    ConfigActions actions = diffConfig(stored, networkConfig_, candidate, config, isConnected());
+    // PMK 保存を後から有効にした場合は、接続し直さずに保存形式だけ切り替える
+    if (pmkStorage_ && !stored.isPmk && stored.password.length() > 0) {
+        actions |= static_cast<uint8_t>(ConfigAction::SaveCredentials);
+    }
+    lastConfigActions_ = actions;
+    return actions;
+}
+
+bool SukenESPWiFi::saveConfigChanges(ConfigActions actions, const WiFiCredentials& credentials) {
+    bool saveCredentials = hasConfigAction(actions, ConfigAction::SaveCredentials);
+    bool saveNetwork = hasConfigAction(actions, ConfigAction::SaveNetwork);
+    if (!saveCredentials && !saveNetwork) return true;
+    store_.beginTransaction();
+    if (saveCredentials) saveWiFiCredentials(credentials);
+    if (saveNetwork) saveNetworkSettings();
+    if (!store_.commit()) {
+        Serial.println("Error saving settings to SPIFFS");
+        // 書けなかった場合、保存済みの認証情報があるかはファイルで判断し直す
+        credentialsStored_ = store_.exists("/wifi_credentials.txt");
+        return false;
+    }
+    Serial.println("Settings saved successfully.");
+    return true;
+}
+
+void SukenESPWiFi::applyLiveConfigChanges(ConfigActions actions) {
+    if (hasConfigAction(actions, ConfigAction::ReapplyIP)) {
+        // 保存済みリースは古い設定のものなので使わない
+        invalidateLease();
+        leaseConfigured_ = false;
+        leaseInUse_ = false;
+        // 次の GOT_IP はリース更新と同じ扱い（再接続としては数えない）
+        leaseRenewing_ = true;
+        if (networkConfig_.useStaticIP) {
+            Serial.println("Applying static IP without reconnecting: " + networkConfig_.staticIP.toString());
+            if (!WiFi.config(networkConfig_.staticIP, networkConfig_.gateway, networkConfig_.subnet, networkConfig_.primaryDNS, networkConfig_.secondaryDNS)) {
+                Serial.println("Static IP configuration failed");
+                leaseRenewing_ = false;
+            }
+        } else {
+            Serial.println("Switching to DHCP without reconnecting");
+            WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        }
+    }
+    if (hasConfigAction(actions, ConfigAction::EnableIPv6)) {
+        WiFi.enableIpV6();
+    }
+}
+
+ProvisionResult SukenESPWiFi::applyConfigJson(const String& json, bool verify) {
+    JsonDocument doc;
+    if (deserializeJson(doc, json)) return ProvisionResult::InvalidInput;
+    WiFiCredentials credentials;
+    NetworkConfig config;
+    if (!parseConfigJson(doc, credentials, config)) return ProvisionResult::InvalidInput;
+    return applyConfig(credentials, config, verify);
+}
+
+String SukenESPWiFi::handleProvisioningCommand(const String& line) {
+    uint32_t start = millis();
+    JsonDocument request;
+    JsonDocument response;
+    String cmd;
+    if (deserializeJson(request, line)) {
+        response["result"] = provisionResultName(ProvisionResult::InvalidInput);
+        response["code"] = static_cast<uint8_t>(ProvisionResult::InvalidInput);
+    } else {
+        cmd = request["cmd"] | "apply";
+        response["cmd"] = cmd;
+        if (cmd == "apply") {
+            WiFiCredentials credentials;
+            NetworkConfig config;
+            ProvisionResult result = ProvisionResult::InvalidInput;
+            if (parseConfigJson(request, credentials, config)) {
+                result = applyConfig(credentials, config, request["verify"] | true);
+                // Busy のときの値は別の要求のもの
+                if (result != ProvisionResult::Busy) {
+                    configActionsToJson(lastConfigActions_, response.createNestedArray("actions"));
+                }
+            }
+            response["result"] = provisionResultName(result);
+            response["code"] = static_cast<uint8_t>(result);
+        } else if (cmd == "status") {
+            response["result"] = provisionResultName(ProvisionResult::Ok);
+            response["code"] = static_cast<uint8_t>(ProvisionResult::Ok);
+        } else if (cmd == "clear") {
+            clearAllSettings();
+            response["result"] = provisionResultName(ProvisionResult::Ok);
+            response["code"] = static_cast<uint8_t>(ProvisionResult::Ok);
+        } else {
+            response["result"] = provisionResultName(ProvisionResult::InvalidInput);
+            response["code"] = static_cast<uint8_t>(ProvisionResult::InvalidInput);
+        }
+    }
+    response["connected"] = WiFi.status() == WL_CONNECTED;
+    if (WiFi.status() == WL_CONNECTED) {
+        response["ssid"] = WiFi.SSID();
+        response["ip"] = WiFi.localIP().toString();
+    }
+    response["mac"] = WiFi.macAddress();
+    response["ms"] = millis() - start;
+    String json;
+    serializeJson(response, json);
+    return json;
+}
+
+const char* SukenESPWiFi::provisionResultName(ProvisionResult result) {
+    switch (result) {
+        case ProvisionResult::Ok: return "ok";
+        case ProvisionResult::InvalidInput: return "invalid_input";
+        case ProvisionResult::SaveFailed: return "save_failed";
+        case ProvisionResult::ConnectFailed: return "connect_failed";
+        case ProvisionResult::Busy: return "busy";
+        default: return "unknown";
+    }
+}
+
+bool SukenESPWiFi::importProvisioningFile() {
+    // 製造ラインなどで書き込まれた /provision.json があれば取り込んで削除する
+    String json;
+    if (!SPIFFS.exists("/provision.json") || !store_.read("/provision.json", json)) return false;
+    Serial.println("Importing /provision.json...");
+    ProvisionResult result = applyConfigJson(json, false);
+    Serial.println(String("Provisioning import: ") + provisionResultName(result));
+    if (result != ProvisionResult::Ok) {
+        // 保存できなかった場合は次の起動でやり直す（内容の誤りも確認できるよう残しておく）
+        Serial.println("Keeping /provision.json");
+        return false;
+    }
+    store_.remove("/provision.json");
+    return true;
+}
+
 void SukenESPWiFi::readNetworkSettings() {
     if (SPIFFS.exists("/network_settings.txt")) {
         File file = SPIFFS.open("/network_settings.txt", "r");
@@ -1022,24 +2503,8 @@ void SukenESPWiFi::readNetworkSettings() {
                     String key = line.substring(0, separatorIndex);
                     String value = line.substring(separatorIndex + 1);
                     
-                    if (key.equals("useStaticIP")) {
-                        networkConfig_.useStaticIP = (value == "true");
-                        Serial.println("useStaticIP: " + String(networkConfig_.useStaticIP ? "true" : "false"));
-                    } else if (key.equals("staticIP")) {
-                        networkConfig_.staticIP.fromString(value);
-                        Serial.println("staticIP: " + networkConfig_.staticIP.toString());
-                    } else if (key.equals("gateway")) {
-                        networkConfig_.gateway.fromString(value);
-                        Serial.println("gateway: " + networkConfig_.gateway.toString());
-                    } else if (key.equals("subnet")) {
-                        networkConfig_.subnet.fromString(value);
-                        Serial.println("subnet: " + networkConfig_.subnet.toString());
-                    } else if (key.equals("primaryDNS")) {
-                        networkConfig_.primaryDNS.fromString(value);
-                        Serial.println("primaryDNS: " + networkConfig_.primaryDNS.toString());
-                    } else if (key.equals("secondaryDNS")) {
-                        networkConfig_.secondaryDNS.fromString(value);
-                        Serial.println("secondaryDNS: " + networkConfig_.secondaryDNS.toString());
+                    if (decodeNetworkLine(key, value, networkConfig_)) {
+                        Serial.println(key + ": " + value);
                     }
                 }
             }
@@ -1054,46 +2519,14 @@ void SukenESPWiFi::readNetworkSettings() {
     }
 }
 
-void SukenESPWiFi::saveNetworkSettings() const {
+void SukenESPWiFi::saveNetworkSettings() {
     Serial.println("Saving network settings...");
     
-    // ファイルが存在する場合は削除
-    if (SPIFFS.exists("/network_settings.txt")) {
-        SPIFFS.remove("/network_settings.txt");
-        Serial.println("Removed existing network_settings.txt");
-    }
+    String content = encodeNetworkConfig(networkConfig_);
+    Serial.print(content);
     
-    File file = SPIFFS.open("/network_settings.txt", "w");
-    if (file) {
-        Serial.println("Saving network settings to SPIFFS...");
-        
-        String useStaticIPStr = String(networkConfig_.useStaticIP ? "true" : "false");
-        file.println("useStaticIP=" + useStaticIPStr);
-        Serial.println("Saving useStaticIP: " + useStaticIPStr);
-        
-        String staticIPStr = networkConfig_.staticIP.toString();
-        file.println("staticIP=" + staticIPStr);
-        Serial.println("Saving staticIP: " + staticIPStr);
-        
-        String gatewayStr = networkConfig_.gateway.toString();
-        file.println("gateway=" + gatewayStr);
-        Serial.println("Saving gateway: " + gatewayStr);
-        
-        String subnetStr = networkConfig_.subnet.toString();
-        file.println("subnet=" + subnetStr);
-        Serial.println("Saving subnet: " + subnetStr);
-        
-        String primaryDNSStr = networkConfig_.primaryDNS.toString();
-        file.println("primaryDNS=" + primaryDNSStr);
-        Serial.println("Saving primaryDNS: " + primaryDNSStr);
-        
-        String secondaryDNSStr = networkConfig_.secondaryDNS.toString();
-        file.println("secondaryDNS=" + secondaryDNSStr);
-        Serial.println("Saving secondaryDNS: " + secondaryDNSStr);
-        
-        file.close();
-        Serial.println("Network settings saved successfully.");
-        Serial.println("File size: " + String(SPIFFS.open("/network_settings.txt", "r").size()) + " bytes");
+    if (store_.write("/network_settings.txt", content)) {
+        if (!store_.inTransaction()) Serial.println("Network settings saved successfully.");
     } else {
         Serial.println("Error saving network settings to SPIFFS");
     }
@@ -1116,11 +2549,118 @@ char* SukenESPWiFi::getMAC() const {
 }
 
 bool SukenESPWiFi::isConnected() const {
-    return WiFi.status() == WL_CONNECTED;
+    if (connectOnIPv6_ && stationUp_) return true;
+    return snapshot_.read().hasIPv4;
+}
+
+NetworkSnapshot SukenESPWiFi::getNetworkSnapshot() const { return snapshot_.read(); }
+
+void SukenESPWiFi::startRssiSampler() {
+    if (!rssiTimer_) {
+        esp_timer_create_args_t args = {};
+        args.callback = &SukenESPWiFi::rssiTimerCallback;
+        args.arg = this;
+        args.name = "SukenWiFi_Rssi";
+        if (esp_timer_create(&args, &rssiTimer_) != ESP_OK) {
+            rssiTimer_ = nullptr;
+            return;
+        }
+    }
+    esp_timer_stop(rssiTimer_);
+    esp_timer_start_periodic(rssiTimer_, static_cast<uint64_t>(RSSI_SAMPLE_INTERVAL_MS) * 1000ULL);
+    sampleRssi();
+}
+
+void SukenESPWiFi::stopRssiSampler() {
+    if (rssiTimer_) esp_timer_stop(rssiTimer_);
+}
+
+void SukenESPWiFi::sampleRssi() {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+    int8_t rssi = ap.rssi;
+    // 変化がなければ sequence を進めない
+    if (snapshot_.read().rssi == rssi) return;
+    snapshot_.update([rssi](NetworkSnapshot& snap) {
+        if (snap.associated) snap.rssi = rssi;
+    });
+}
+
+void SukenESPWiFi::rssiTimerCallback(void* arg) {
+    static_cast<SukenESPWiFi*>(arg)->sampleRssi();
+}
+
+void SukenESPWiFi::setConnectOnIPv6(bool enable) { connectOnIPv6_ = enable; }
+bool SukenESPWiFi::getConnectOnIPv6() const { return connectOnIPv6_; }
+
+String SukenESPWiFi::getGlobalIPv6() const {
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    esp_ip6_addr_t addr;
+    if (!ipv6Global_ || !netif || esp_netif_get_ip6_global(netif, &addr) != ESP_OK) return "";
+    return IPv6Address(reinterpret_cast<const uint8_t*>(addr.addr)).toString();
+}
+
+String SukenESPWiFi::getLinkLocalIPv6() const {
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    esp_ip6_addr_t addr;
+    if (!networkConfig_.enableIPv6 || !netif || esp_netif_get_ip6_linklocal(netif, &addr) != ESP_OK) return "";
+    return IPv6Address(reinterpret_cast<const uint8_t*>(addr.addr)).toString();
+}
+
+bool SukenESPWiFi::isOnline() const {
+    return isConnected() && healthMonitor_.health() != LinkHealth::Unhealthy;
+}
+
+void SukenESPWiFi::setHealthConfig(const HealthConfig& config) {
+    healthMonitor_.configure(config);
+    if (WiFi.status() == WL_CONNECTED) {
+        healthMonitor_.onLinkUp(millis());
+        startHealthTask();
+    }
+}
+
+HealthConfig SukenESPWiFi::getHealthConfig() const { return healthMonitor_.config(); }
+
+LinkHealth SukenESPWiFi::getLinkHealth() const { return healthMonitor_.health(); }
+
+HealthStats SukenESPWiFi::getHealthStats() const { return healthMonitor_.stats(); }
+
+void SukenESPWiFi::startHealthTask() {
+    if (!healthMonitor_.enabled() || taskTopology_.cooperative || healthTaskHandle_ != nullptr) return;
+    spawnTask(LibraryTask::Health, SukenESPWiFi::healthTask, "SukenWiFi_Health");
+}
+
+void SukenESPWiFi::healthTask(void* args) {
+    SukenESPWiFi* self = static_cast<SukenESPWiFi*>(args);
+    // 無効化されるまで常駐する（切断中は tick() がすぐ戻る）
+    while (self->healthMonitor_.enabled()) {
+        if (self->healthMonitor_.tick(millis(), true)) {
+            self->softReconnect();
+        }
+        if (!self->setupMode_) self->mdns_.poll(millis());
+        self->persistLinkRecord();
+        self->taskDelay(self->healthMonitor_.probing() ? 10 : 200);
+    }
+    self->finishTask(LibraryTask::Health);
+    vTaskDelete(nullptr);
+}
+
+void SukenESPWiFi::softReconnect() {
+    // アソシエーションは残っているが上流に届かない。切断→再接続で DHCP からやり直す
+    HealthStats stats = healthMonitor_.stats();
+    Serial.println("[Health] Link unhealthy. Soft reconnect (#" + String(stats.softReconnects) + ")");
+    if (leaseConfigured_) {
+        // 保存済みリースが原因かもしれない（ルーター交換など）。破棄して DHCP で取り直す
+        invalidateLease();
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        leaseConfigured_ = false;
+        leaseInUse_ = false;
+    }
+    WiFi.reconnect();
 }
 
 String SukenESPWiFi::getLocalIP() const {
-    return WiFi.localIP().toString();
+    return IPAddress(snapshot_.read().ip).toString();
 }
 
 String SukenESPWiFi::getMACAddress() const {
@@ -1128,8 +2668,9 @@ String SukenESPWiFi::getMACAddress() const {
 }
 
 String SukenESPWiFi::getConnectedSSID() const {
-    if (WiFi.status() == WL_CONNECTED) {
-        return WiFi.SSID();
+    NetworkSnapshot snap = snapshot_.read();
+    if (snap.hasIPv4) {
+        return String(snap.ssid);
     } else {
         return "未接続";
     }
@@ -1146,8 +2687,10 @@ void SukenESPWiFi::clearAllSettings() {
 }
 
 void SukenESPWiFi::clearWiFiSettings() {
-    if (SPIFFS.exists("/wifi_credentials.txt")) {
-        SPIFFS.remove("/wifi_credentials.txt");
+    credentialsStored_ = false;
+    invalidateLease();
+    rtcConnectionRecord.magic = 0;
+    if (store_.remove("/wifi_credentials.txt")) {
         Serial.println("WiFi settings cleared.");
     } else {
         Serial.println("No WiFi settings to clear.");
@@ -1155,20 +2698,26 @@ void SukenESPWiFi::clearWiFiSettings() {
 }
 
 void SukenESPWiFi::clearNetworkSettings() {
-    if (SPIFFS.exists("/network_settings.txt")) {
-        SPIFFS.remove("/network_settings.txt");
+    if (store_.remove("/network_settings.txt")) {
         Serial.println("Network settings cleared.");
     } else {
         Serial.println("No network settings to clear.");
     }
     
     // デフォルト値にリセット
-    networkConfig_.useStaticIP = false;
-    networkConfig_.staticIP = IPAddress(192, 168, 1, 200);
-    networkConfig_.gateway = IPAddress(192, 168, 1, 1);
-    networkConfig_.subnet = IPAddress(255, 255, 255, 0);
-    networkConfig_.primaryDNS = IPAddress(8, 8, 8, 8);
-    networkConfig_.secondaryDNS = IPAddress(8, 8, 4, 4);
+    networkConfig_ = NetworkConfig();
+}
+
+void SukenESPWiFi::enablePmkStorage(bool enable) { pmkStorage_ = enable; }
+bool SukenESPWiFi::isPmkStorageEnabled() const { return pmkStorage_; }
+
+void SukenESPWiFi::migrateCredentialsToPmk() {
+    WiFiCredentials credentials;
+    readWiFiCredentials(credentials);
+    if (credentials.isPmk || credentials.password.length() == 0) return;
+    // 以前に平文で保存したパスフレーズを PMK に置き換える（一度だけ）
+    Serial.println("Converting stored passphrase to PMK...");
+    saveWiFiCredentials(credentials);
 }
 
 WiFiCredentials SukenESPWiFi::getStoredCredentials() const {
@@ -1177,32 +2726,123 @@ WiFiCredentials SukenESPWiFi::getStoredCredentials() const {
     return credentials;
 }
 
+StoreStats SukenESPWiFi::getStoreStats() {
+    return store_.stats();
+}
+
+void SukenESPWiFi::setOfflineQueue(const OfflineQueueConfig& config, QueueSender sender) {
+    queueSender_ = std::move(sender);
+    offlineQueue_.configure(config, &store_);
+    // init() 前なら mountStorage() 時に読み込む
+    if (storageMounted_) offlineQueue_.loadFlash();
+}
+
+bool SukenESPWiFi::enqueue(const String& payload) {
+    bool connected = WiFi.status() == WL_CONNECTED;
+    // 切断中に積んだものだけフラッシュに追記する
+    bool accepted = offlineQueue_.push(payload, !connected && storageMounted_);
+    if (connected) startQueueDrain();
+    return accepted;
+}
+
+void SukenESPWiFi::flushOfflineQueue() {
+    startQueueDrain();
+}
+
+void SukenESPWiFi::saveOfflineQueue() {
+    if (storageMounted_) offlineQueue_.persistPending(millis(), true);
+}
+
+OfflineQueueStats SukenESPWiFi::getOfflineQueueStats() {
+    return offlineQueue_.stats();
+}
+
+void SukenESPWiFi::startQueueDrain() {
+    if (!queueSender_ || offlineQueue_.size() == 0) return;
+    if (taskTopology_.cooperative) {
+        queueDrainPending_ = true;
+        return;
+    }
+    if (queueTaskHandle_ != nullptr) return;
+    spawnTask(LibraryTask::Dispatcher, SukenESPWiFi::queueDrainTask, "SukenWiFi_Queue");
+}
+
+bool SukenESPWiFi::drainQueueBatch() {
+    const OfflineQueueConfig& config = offlineQueue_.config();
+    uint8_t sent = 0;
+    String payload;
+    while (sent < config.batchSize && offlineQueue_.peek(payload)) {
+        if (!queueSender_(payload)) {
+            // 失敗したデータは残し、次の接続/enqueue で再送する
+            offlineQueue_.countSendFailure();
+            return false;
+        }
+        offlineQueue_.pop();
+        offlineQueue_.countFlushed();
+        sent++;
+    }
+    return offlineQueue_.size() > 0;
+}
+
+void SukenESPWiFi::queueDrainTask(void* parameter) {
+    SukenESPWiFi* self = static_cast<SukenESPWiFi*>(parameter);
+    while (WiFi.status() == WL_CONNECTED && self->drainQueueBatch()) {
+        self->taskDelay(self->offlineQueue_.config().batchIntervalMs);
+    }
+    self->offlineQueue_.syncFlash();
+    self->finishTask(LibraryTask::Dispatcher);
+    vTaskDelete(nullptr);
+}
+
 NetworkConfig SukenESPWiFi::getNetworkConfig() const {
     return networkConfig_;
 }
 
 String SukenESPWiFi::getCurrentDNS() const {
-    if (WiFi.status() == WL_CONNECTED) {
-        IPAddress dns1 = WiFi.dnsIP(0);
-        IPAddress dns2 = WiFi.dnsIP(1);
-        return dns1.toString() + ", " + dns2.toString();
-    } else {
-        return "Not connected";
+    if (!isConnected()) return "Not connected";
+    if (!networkConfig_.enableIPv6) {
+        NetworkSnapshot snap = snapshot_.read();
+        String result;
+        if (snap.dns1) result += IPAddress(snap.dns1).toString();
+        if (snap.dns2) {
+            if (result.length() > 0) result += ", ";
+            result += IPAddress(snap.dns2).toString();
+        }
+        return result.length() > 0 ? result : String("None");
+    }
+    // IPv6 のサーバー（RDNSS/DHCPv6）は GOT_IP の後から追加されるので lwIP のサーバー一覧を直接読む
+    String result;
+    for (uint8_t i = 0; i < DNS_MAX_SERVERS; ++i) {
+        const ip_addr_t* server = dns_getserver(i);
+        if (!server || ip_addr_isany(server)) continue;
+        if (result.length() > 0) result += ", ";
+        result += ipaddr_ntoa(server);
     }
+    return result.length() > 0 ? result : String("None");
 }
 
 String SukenESPWiFi::getNetworkInfo() const {
     String info = "=== Network Information ===\n";
     
-    // WiFi接続情報
-    if (WiFi.status() == WL_CONNECTED) {
+    // WiFi接続情報（1つのスナップショットから作るので、項目どうしが食い違わない）
+    NetworkSnapshot snap = snapshot_.read();
+    if (snap.hasIPv4 || (connectOnIPv6_ && stationUp_)) {
         info += "Status: Connected\n";
-        info += "SSID: " + WiFi.SSID() + "\n";
-        info += "IP Address: " + WiFi.localIP().toString() + "\n";
-        info += "Gateway: " + WiFi.gatewayIP().toString() + "\n";
-        info += "Subnet Mask: " + WiFi.subnetMask().toString() + "\n";
+        info += "SSID: " + String(snap.ssid) + "\n";
+        if (snap.hasIPv4) {
+            info += "IP Address: " + IPAddress(snap.ip).toString() + "\n";
+            info += "Gateway: " + IPAddress(snap.gateway).toString() + "\n";
+            info += "Subnet Mask: " + IPAddress(snap.subnet).toString() + "\n";
+        } else {
+            info += "IP Address: (waiting for IPv4)\n";
+        }
+        if (networkConfig_.enableIPv6) {
+            String global = getGlobalIPv6();
+            info += "IPv6 Global: " + (global.length() > 0 ? global : String("None")) + "\n";
+            info += "IPv6 Link-Local: " + getLinkLocalIPv6() + "\n";
+        }
         info += "DNS: " + getCurrentDNS() + "\n";
-        info += "Signal Strength: " + String(WiFi.RSSI()) + " dBm\n";
+        info += "Signal Strength: " + String(snap.rssi) + " dBm\n";
     } else {
         info += "Status: Not connected\n";
     }
@@ -1212,6 +2852,7 @@ String SukenESPWiFi::getNetworkInfo() const {
     WiFiCredentials stored = getStoredCredentials();
     info += "Stored SSID: " + stored.ssid + "\n";
     info += "Use Static IP: " + String(networkConfig_.useStaticIP ? "Yes" : "No") + "\n";
+    info += "IPv6: " + String(networkConfig_.enableIPv6 ? "Enabled" : "Disabled") + "\n";
     if (networkConfig_.useStaticIP) {
         info += "Static IP: " + networkConfig_.staticIP.toString() + "\n";
         info += "Gateway: " + networkConfig_.gateway.toString() + "\n";
@@ -1228,6 +2869,283 @@ String SukenESPWiFi::getNetworkInfo() const {
     return info;
 } 
 
+void SukenESPWiFi::enableBootProfilePersistence(bool enable) { persistBootProfile_ = enable; }
+
+void SukenESPWiFi::beginBootProfile() {
+    BootProfile profile;
+    profile.initStartUs = esp_timer_get_time();
+
+    switch (esp_reset_reason()) {
+        case ESP_RST_POWERON:
+        case ESP_RST_BROWNOUT:
+            profile.kind = BootKind::ColdBoot;
+            break;
+        case ESP_RST_DEEPSLEEP:
+            profile.kind = BootKind::DeepSleepWake;
+            break;
+        case ESP_RST_UNKNOWN:
+            profile.kind = BootKind::Unknown;
+            break;
+        default:
+            profile.kind = BootKind::WarmBoot;
+            break;
+    }
+
+    lockBootProfile();
+    bootProfile_ = profile;
+    if (persistBootProfile_) {
+        // 電源投入時は RTC メモリが不定なので checksum で判定する
+        if (rtcBootRecord.magic == BOOT_RECORD_MAGIC && rtcBootRecord.checksum == recordChecksum(rtcBootRecord)) {
+            memcpy(&previousBootProfile_, rtcBootRecord.profile, sizeof(BootProfile));
+            bootProfile_.bootCount = rtcBootRecord.bootCount + 1;
+        } else {
+            previousBootProfile_ = BootProfile();
+            bootProfile_.bootCount = 1;
+        }
+        rtcBootRecord.magic = BOOT_RECORD_MAGIC;
+        rtcBootRecord.bootCount = bootProfile_.bootCount;
+        persistBootProfileLocked();
+    }
+    unlockBootProfile();
+}
+
+void SukenESPWiFi::lockBootProfile() const {
+    xSemaphoreTake(bootProfileMutex_, portMAX_DELAY);
+}
+
+void SukenESPWiFi::unlockBootProfile() const {
+    xSemaphoreGive(bootProfileMutex_);
+}
+
+void SukenESPWiFi::persistBootProfileLocked() {
+    memcpy(rtcBootRecord.profile, &bootProfile_, sizeof(BootProfile));
+    rtcBootRecord.checksum = recordChecksum(rtcBootRecord);
+}
+
+void SukenESPWiFi::markPhaseStart(BootPhase phase) {
+    int64_t now = esp_timer_get_time();
+    lockBootProfile();
+    bootProfile_.markStart(phase, now);
+    unlockBootProfile();
+}
+
+void SukenESPWiFi::markPhaseEnd(BootPhase phase) {
+    int64_t now = esp_timer_get_time();
+    lockBootProfile();
+    if (bootProfile_.markEnd(phase, now) && persistBootProfile_) persistBootProfileLocked();
+    unlockBootProfile();
+}
+
+void SukenESPWiFi::markGotIp() {
+    int64_t now = esp_timer_get_time();
+    lockBootProfile();
+    if (bootProfile_.markGotIp(now) && persistBootProfile_) persistBootProfileLocked();
+    unlockBootProfile();
+}
+
+void SukenESPWiFi::setBootFastPath(bool fastPath) {
+    lockBootProfile();
+    bootProfile_.fastPath = fastPath;
+    unlockBootProfile();
+}
+
+const char* SukenESPWiFi::bootPhaseName(BootPhase phase) {
+    switch (phase) {
+        case BootPhase::Mount: return "mount";
+        case BootPhase::SettingsLoad: return "settingsLoad";
+        case BootPhase::Scan: return "scan";
+        case BootPhase::Associate: return "associate";
+        case BootPhase::Dhcp: return "dhcp";
+        case BootPhase::Mdns: return "mdns";
+        case BootPhase::PortalStart: return "portalStart";
+        default: return "unknown";
+    }
+}
+
+const char* SukenESPWiFi::bootKindName(BootKind kind) {
+    switch (kind) {
+        case BootKind::ColdBoot: return "cold";
+        case BootKind::WarmBoot: return "warm";
+        case BootKind::DeepSleepWake: return "deepSleepWake";
+        default: return "unknown";
+    }
+}
+
+void SukenESPWiFi::enableLeaseReuse(bool enable) {
+    leaseReuse_ = enable;
+    if (!enable) invalidateLease();
+}
+bool SukenESPWiFi::isLeaseReuseEnabled() const { return leaseReuse_; }
+ConnectTimingStats SukenESPWiFi::getConnectTimingStats() const { return connectTiming_; }
+
+void SukenESPWiFi::prepareStationConnect(const String& ssid) {
+    connectStartUs_ = esp_timer_get_time();
+    associatedUs_ = -1;
+    if (networkConfig_.useStaticIP) {
+        leaseConfigured_ = false;
+        leaseInUse_ = false;
+        if (!WiFi.config(networkConfig_.staticIP, networkConfig_.gateway, networkConfig_.subnet, networkConfig_.primaryDNS, networkConfig_.secondaryDNS)) {
+            Serial.println("Static IP configuration failed");
+        }
+        return;
+    }
+    if (leaseReuse_ && applyStoredLease(ssid)) return;
+    if (leaseConfigured_) {
+        // 前回はリースの値を静的に設定していたので DHCP に戻す
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+        leaseConfigured_ = false;
+        leaseInUse_ = false;
+    }
+}
+
+bool SukenESPWiFi::applyStoredLease(const String& ssid) {
+    const RtcLeaseRecord& lease = rtcLeaseRecord;
+    if (lease.magic != LEASE_RECORD_MAGIC || lease.checksum != recordChecksum(lease)) return false;
+    if (lease.ssidHash != fnv1a(ssid.c_str(), ssid.length())) return false;
+    // T1（リース期間の半分）を過ぎていれば DHCP で更新すべき時期なので使わない
+    uint32_t now = static_cast<uint32_t>(time(nullptr));
+    uint32_t t1 = lease.obtainedAt + lease.leaseSec / 2;
+    if (now < lease.obtainedAt || now >= t1) return false;
+
+    // ESP-IDF の DHCP クライアントは INIT-REBOOT（前回IPの直接要求）を API で公開していないため、
+    // サーバーがまだ割り当てを保持している期間内は前回の値をそのまま使い、DHCP の往復を省く
+    if (!WiFi.config(IPAddress(lease.ip), IPAddress(lease.gateway), IPAddress(lease.subnet), IPAddress(lease.dns1), IPAddress(lease.dns2))) {
+        Serial.println("Lease reuse: configuration failed, falling back to DHCP");
+        return false;
+    }
+    leaseConfigured_ = true;
+    leaseInUse_ = true;
+    scheduleLeaseRenewal(t1 - now);
+    Serial.println("Reusing DHCP lease: " + IPAddress(lease.ip).toString() + " (renew in " + String(t1 - now) + "s)");
+    return true;
+}
+
+void SukenESPWiFi::scheduleLeaseRenewal(uint32_t delaySec) {
+    if (!leaseTimer_) {
+        esp_timer_create_args_t args = {};
+        args.callback = &SukenESPWiFi::leaseTimerCallback;
+        args.arg = this;
+        args.name = "SukenWiFi_Lease";
+        if (esp_timer_create(&args, &leaseTimer_) != ESP_OK) {
+            leaseTimer_ = nullptr;
+            return;
+        }
+    }
+    esp_timer_stop(leaseTimer_);
+    esp_timer_start_once(leaseTimer_, static_cast<uint64_t>(delaySec) * 1000000ULL);
+}
+
+void SukenESPWiFi::leaseTimerCallback(void* arg) {
+    SukenESPWiFi* self = static_cast<SukenESPWiFi*>(arg);
+    if (!self->leaseInUse_) return;
+    // T1: DHCP クライアントを開始して正式にリースを取り直す
+    // esp_netif は開始時にアドレスを一度外すため、GOT_IP までの短時間は通信できない
+    self->leaseInUse_ = false;
+    self->leaseRenewing_ = WiFi.status() == WL_CONNECTED;
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif) esp_netif_dhcpc_start(netif);
+}
+
+void SukenESPWiFi::storeLease() {
+    if (!leaseReuse_ || leaseInUse_ || networkConfig_.useStaticIP) return;
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    struct netif* lwipNetif = netif ? static_cast<struct netif*>(esp_netif_get_netif_impl(netif)) : nullptr;
+    struct dhcp* dhcp = lwipNetif ? netif_dhcp_data(lwipNetif) : nullptr;
+    if (!dhcp || dhcp->offered_t0_lease == 0) return;
+
+    String ssid = WiFi.SSID();
+    RtcLeaseRecord& lease = rtcLeaseRecord;
+    lease.magic = LEASE_RECORD_MAGIC;
+    lease.ssidHash = fnv1a(ssid.c_str(), ssid.length());
+    lease.ip = static_cast<uint32_t>(WiFi.localIP());
+    lease.subnet = static_cast<uint32_t>(WiFi.subnetMask());
+    lease.gateway = static_cast<uint32_t>(WiFi.gatewayIP());
+    lease.dns1 = static_cast<uint32_t>(WiFi.dnsIP(0));
+    lease.dns2 = static_cast<uint32_t>(WiFi.dnsIP(1));
+    lease.obtainedAt = static_cast<uint32_t>(time(nullptr));
+    lease.leaseSec = dhcp->offered_t0_lease;
+    lease.checksum = recordChecksum(lease);
+}
+
+void SukenESPWiFi::invalidateLease() {
+    rtcLeaseRecord.magic = 0;
+    if (leaseTimer_) esp_timer_stop(leaseTimer_);
+}
+
+void SukenESPWiFi::recordConnectTiming() {
+    if (connectStartUs_ < 0) return;
+    int64_t now = esp_timer_get_time();
+    ConnectTiming timing;
+    timing.leaseReused = leaseInUse_;
+    timing.totalMs = static_cast<uint32_t>((now - connectStartUs_) / 1000);
+    if (associatedUs_ >= connectStartUs_) {
+        timing.associateMs = static_cast<uint32_t>((associatedUs_ - connectStartUs_) / 1000);
+        timing.ipMs = static_cast<uint32_t>((now - associatedUs_) / 1000);
+    }
+    connectStartUs_ = -1;
+    associatedUs_ = -1;
+
+    connectTiming_.last = timing;
+    connectTiming_.connects++;
+    if (timing.leaseReused) {
+        connectTiming_.leaseConnects++;
+        leaseIpTotalMs_ += timing.ipMs;
+        connectTiming_.avgLeaseIpMs = static_cast<uint32_t>(leaseIpTotalMs_ / connectTiming_.leaseConnects);
+    } else if (!networkConfig_.useStaticIP) {
+        connectTiming_.dhcpConnects++;
+        dhcpIpTotalMs_ += timing.ipMs;
+        connectTiming_.avgDhcpIpMs = static_cast<uint32_t>(dhcpIpTotalMs_ / connectTiming_.dhcpConnects);
+        storeLease();
+    }
+    Serial.println("Time to IP: " + String(timing.totalMs) + "ms (associate " + String(timing.associateMs) +
+                   "ms, " + (timing.leaseReused ? "lease " : "dhcp ") + String(timing.ipMs) + "ms)");
+}
+
+void SukenESPWiFi::persistLinkRecord() {
+    if (!__atomic_exchange_n(&linkRecordPending_, false, __ATOMIC_ACQUIRE)) return;
+    NetworkSnapshot snap = snapshot_.read();
+    if (!storageMounted_ || !snap.associated || snap.channel == 0) return;
+    char bssid[18];
+    snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+             snap.bssid[0], snap.bssid[1], snap.bssid[2], snap.bssid[3], snap.bssid[4], snap.bssid[5]);
+    // 値が変わった時だけ追記される
+    store_.append("/wifi_state.log", "bssid", String(bssid));
+    store_.append("/wifi_state.log", "channel", String(snap.channel));
+}
+
+BootProfile SukenESPWiFi::getBootProfile() const {
+    lockBootProfile();
+    BootProfile profile = bootProfile_;
+    unlockBootProfile();
+    return profile;
+}
+
+BootProfile SukenESPWiFi::getPreviousBootProfile() const { return previousBootProfile_; }
+
+String SukenESPWiFi::getBootProfileJson() const {
+    BootProfile profile = getBootProfile();
+    JsonDocument doc;
+    doc["kind"] = bootKindName(profile.kind);
+    doc["bootCount"] = profile.bootCount;
+    doc["initStartUs"] = profile.initStartUs;
+    doc["wakeToIpUs"] = profile.gotIpUs;
+    doc["fastPath"] = profile.fastPath;
+    JsonArray phases = doc.createNestedArray("phases");
+    for (size_t i = 0; i < static_cast<size_t>(BootPhase::Count); ++i) {
+        BootPhase phase = static_cast<BootPhase>(i);
+        const BootPhaseTiming& t = profile.phase(phase);
+        if (t.startUs < 0) continue;
+        JsonObject entry = phases.createNestedObject();
+        entry["name"] = bootPhaseName(phase);
+        entry["startUs"] = t.startUs;
+        entry["endUs"] = t.endUs;
+        entry["durationUs"] = profile.durationUs(phase);
+    }
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
 void SukenESPWiFi::enableAutoSetupOnDisconnect(bool enable) { autoSetupOnDisconnect_ = enable; }
 bool SukenESPWiFi::isAutoSetupOnDisconnectEnabled() const { return autoSetupOnDisconnect_; }
 void SukenESPWiFi::enableAutoReconnectDuringSetup(bool enable) { autoReconnectDuringSetup_ = enable; }
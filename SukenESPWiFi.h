@@ -4,35 +4,179 @@
 #include <FS.h>
 #include <SPIFFS.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
-#include <ESPmDNS.h>
-#include <WiFiClientSecure.h>
-#include <WebServer.h>
-#include <DNSServer.h>
 #include <ArduinoJson.h>
 #include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_sleep.h"
+#include "esp_wifi.h"
 #include <functional>
 #include <memory>
+#include <vector>
+#include "SukenWiFiConfig.h"
+#include "SukenWiFiConfigFields.h"
+#include "SukenWiFiStore.h"
+#include "SukenWiFiQueue.h"
+#include "SukenWiFiFsm.h"
+#include "SukenWiFiBootProfile.h"
+#include "SukenWiFiScan.h"
+#include "SukenWiFiProvisioning.h"
+#include "SukenWiFiHealth.h"
+#include "SukenWiFiMdns.h"
+#include "SukenWiFiPmk.h"
+#include "SukenWiFiArena.h"
+#include "SukenWiFiSnapshot.h"
+#include "SukenWiFiRateLimit.h"
+
+// ポータルと HTTP クライアントの実装はヘッダーに出さない（.cpp でだけ include する）
+class WebServer;
 
 namespace SukenWiFiLib {
 
+class CaptiveDns;
+struct HttpSession;
+
 // 型エイリアス - 外部依存を明確化
 using HttpServer = ::WebServer;
 using JsonDoc = JsonDocument;
 
-// 設定構造体 - 設定を構造化
-struct NetworkConfig {
-    bool useStaticIP = false;
-    IPAddress staticIP = IPAddress(192, 168, 1, 200);
-    IPAddress gateway = IPAddress(192, 168, 1, 1);
-    IPAddress subnet = IPAddress(255, 255, 255, 0);
-    IPAddress primaryDNS = IPAddress(8, 8, 8, 8);
-    IPAddress secondaryDNS = IPAddress(8, 8, 4, 4);
+// NetworkConfig / WiFiCredentials は SukenWiFiConfigFields.h（項目表と一緒に定義）
+
+// BootPhase / BootProfile は SukenWiFiBootProfile.h
+
+// init() の実行方式
+enum class InitMode : uint8_t {
+    Sequential = 0,  // マウント→スキャン→設定読込→接続を呼び出し元で順に実行（従来動作）
+    Deferred         // キャッシュ済み設定で即座に接続開始し、残りはバックグラウンドで実行
+};
+
+// 設定適用（プロビジョニング）の結果
+enum class ProvisionResult : uint8_t {
+    Ok = 0,
+    InvalidInput,    // SSID 未指定、JSON 不正など
+    SaveFailed,      // フラッシュへの保存に失敗
+    ConnectFailed,   // 保存は成功したが接続を確認できなかった
+    Busy             // 別の設定を適用中（ポータルやシリアルから同時に適用しようとした）
+};
+
+// HTTP(S) ヘルパーの応答
+constexpr int HTTP_ERROR_LINK_DOWN = -100;   // 待機時間内に WiFi が接続されなかった
+
+struct HttpResponse {
+    int status = 0;                 // HTTP ステータス。負値はエラー（HTTPClient のエラーコード / HTTP_ERROR_LINK_DOWN）
+    String body;
+    uint32_t latencyMs = 0;         // リクエスト開始から応答受信まで（リンク待ちは含まない）
+    bool reusedConnection = false;  // keep-alive 接続を再利用したか
+};
+
+struct HttpStats {
+    uint32_t requests = 0;
+    uint32_t failures = 0;
+    uint32_t linkDownRejects = 0;   // リンク断で送信しなかった数
+    uint32_t reusedConnections = 0;
+    uint32_t newConnections = 0;    // 新規接続（HTTPS ならハンドシェイク）の数
+    uint32_t lastLatencyMs = 0;
+    uint32_t avgLatencyMs = 0;      // 送信まで進んだ要求の平均（接続を始められなかった要求は含めない）
+    uint32_t maxLatencyMs = 0;
+};
+
+// ライブラリが生成するタスク
+enum class LibraryTask : uint8_t {
+    Portal = 0,   // セットアップポータル（DNS/HTTP）
+    Reconnect,    // 切断時の再接続
+    Dispatcher,   // オフライン送信キューの送信
+    Init,         // Deferred モードの初期化
+    Health,       // リンクの疎通確認
+    Count
+};
+
+struct TaskConfig {
+    uint32_t stackSize;
+    UBaseType_t priority;
+    BaseType_t core;      // tskNO_AFFINITY も指定可
+    TaskConfig(uint32_t stack = 4096, UBaseType_t prio = 1, BaseType_t coreId = 1)
+        : stackSize(stack), priority(prio), core(coreId) {}
+};
+
+// タスク構成（コア、優先度、スタックサイズ）
+struct TaskTopology {
+    TaskConfig portal = TaskConfig(8192, 2, 1);
+    TaskConfig reconnect = TaskConfig(4096, 1, 1);
+    TaskConfig dispatcher = TaskConfig(8192, 1, 1);
+    TaskConfig init = TaskConfig(8192, 2, 1);
+    TaskConfig health = TaskConfig(6144, 1, 1);
+    bool cooperative = false;   // true ならタスクを生成せず、SukenWiFi.loop() で処理する
 };
 
-struct WiFiCredentials {
-    String ssid;
-    String password;
+struct TaskStats {
+    uint32_t runs = 0;                 // 生成された回数
+    uint32_t stackHighWaterMark = 0;   // 最小空きスタック（バイト）。0 は未計測
+    uint64_t busyUs = 0;               // 待機時間を除いた実行時間の累計
+    bool running = false;
+};
+
+// ソフトAP（セットアップモード）の設定
+struct SoftAPConfig {
+    uint8_t channel = 0;                // 0 で自動（保存済みネットワークのチャネル、なければ最も空いているチャネル）
+    bool alignToStoredNetwork = true;   // 保存済みネットワークと同じチャネルにして AP_STA 時のチャネル切替を避ける
+    uint8_t maxClients = 4;             // 同時接続数（1〜10）
+    uint16_t beaconIntervalTu = 100;    // ビーコン間隔（1TU = 1.024ms、100〜60000）
+    String password;                    // 空ならオープン。8文字以上で WPA2
+};
+
+// ソフトAPに接続したクライアント（MACごと）
+struct APClientInfo {
+    uint8_t mac[6] = {0};
+    IPAddress ip;
+    bool connected = false;
+    uint32_t associations = 0;      // このクライアントの接続回数
+    uint32_t associatedAtMs = 0;    // 最後に接続した時刻（millis）
+    uint32_t associatedMs = 0;      // 接続していた時間（接続中は現在まで）
+    uint32_t ipAssignMs = 0;        // 接続から IP 割り当てまでの時間
+};
+
+struct APStats {
+    uint8_t channel = 0;
+    uint8_t clients = 0;            // 現在の接続数
+    uint32_t associations = 0;
+    uint32_t disassociations = 0;
+};
+
+// 1回の接続（WiFi.begin() → GOT_IP）のフェーズ別所要時間
+struct ConnectTiming {
+    uint32_t associateMs = 0;   // WiFi.begin() → STA_CONNECTED
+    uint32_t ipMs = 0;          // STA_CONNECTED → GOT_IP（DHCP または保存済みリースの適用）
+    uint32_t totalMs = 0;
+    bool leaseReused = false;   // 前回の DHCP リースを暫定の静的設定として使ったか
+};
+
+struct ConnectTimingStats {
+    ConnectTiming last;
+    uint32_t connects = 0;
+    uint32_t dhcpConnects = 0;
+    uint32_t leaseConnects = 0;
+    uint32_t avgDhcpIpMs = 0;    // DHCP で取得した場合の ipMs 平均
+    uint32_t avgLeaseIpMs = 0;   // リースを再利用した場合の ipMs 平均
+};
+
+// セットアップポータルのメモリ（アリーナとヒープの断片化の確認用）
+struct PortalMemoryStats {
+    uint32_t sessions = 0;              // ポータルを開始した回数
+    uint32_t arenaBytes = 0;            // 直近のセッションで確保したアリーナの大きさ
+    uint32_t arenaUsed = 0;
+    uint32_t poolExhausted = 0;         // 応答バッファが足りず String で組み立てた回数
+    uint32_t largestFreeBefore = 0;     // ポータル開始前の最大連続空き（バイト）
+    uint32_t largestFreeAfter = 0;      // ポータル終了後の最大連続空き
+    uint32_t freeBefore = 0;            // ポータル開始前の空き合計
+    uint32_t freeAfter = 0;
+};
+
+// 協調モードの loop() 実行時間
+struct LoopStats {
+    uint32_t calls = 0;
+    uint32_t lastUs = 0;
+    uint32_t maxUs = 0;   // 最悪実行時間
+    uint32_t avgUs = 0;
 };
 
 // コールバック型定義
@@ -43,6 +187,7 @@ class SukenESPWiFi {
 public:
     // コンストラクタ
     explicit SukenESPWiFi(const String& deviceName = "ESP-WiFi-Manager");
+    ~SukenESPWiFi();
     
     // 初期化
     void init();
@@ -53,11 +198,57 @@ public:
     
     // WiFi状態
     bool isConnected() const;
+    // 接続済みで、疎通確認（有効な場合）でも上流に届いている
+    bool isOnline() const;
+    // IPv6（NetworkConfig::enableIPv6 が有効な場合）。未取得なら空文字列
+    String getGlobalIPv6() const;
+    String getLinkLocalIPv6() const;
+    // true なら IPv4 より先に IPv6 グローバルアドレスを取得した時点で接続済みとして扱う
+    // （isConnected()、waitUntilConnected()、onConnected が早く進む。疎通確認は IPv4 取得後に始まる）
+    void setConnectOnIPv6(bool enable);
+    bool getConnectOnIPv6() const;
+    
+    // リンクの疎通確認（ゲートウェイ ping、DNS、HTTP）
+    void setHealthConfig(const HealthConfig& config);
+    HealthConfig getHealthConfig() const;
+    LinkHealth getLinkHealth() const;
+    HealthStats getHealthStats() const;
+    
+    // mDNS（ホスト名はデバイス名。http/tcp/80 と TXT の mac は自動で登録）
+    // 例: addMdnsService("myapp", "tcp", 8080); setMdnsTxt("http", "tcp", "fw", "1.2.0");
+    void addMdnsService(const String& service, const String& proto, uint16_t port);
+    void removeMdnsService(const String& service, const String& proto);
+    void setMdnsTxt(const String& service, const String& proto, const String& key, const String& value);
+    MdnsStats getMdnsStats() const;
     String getLocalIP() const;
     String getMACAddress() const;
     String getConnectedSSID() const;
     String getDeviceMAC() const;
     String getNetworkInfo() const;
+    // 接続状態をまとめて取得（WiFi ドライバを呼ばないので loop() から頻繁に呼んでよい）
+    // isConnected()、getLocalIP()、getConnectedSSID() なども同じスナップショットを読む
+    NetworkSnapshot getNetworkSnapshot() const;
+    
+    // 起動プロファイル
+    BootProfile getBootProfile() const;
+    BootProfile getPreviousBootProfile() const;   // RTC メモリに保持された前回起動分
+    String getBootProfileJson() const;
+    // RTC メモリへの保持を有効化（init() より前に呼ぶ）
+    void enableBootProfilePersistence(bool enable);
+    
+    // ディープスリープ間欠動作（init() より前に呼ぶ）
+    // 接続先（SSID、パスフレーズまたは PMK、BSSID、チャネル、IP設定）を RTC メモリに保持し、
+    // 復帰時は SPIFFS のマウント、スキャン、設定ファイルの読み込みを行わずに直接接続する
+    void enableDeepSleepFastPath(bool enable);
+    bool isDeepSleepFastPathEnabled() const;
+    // 接続記録を残したままディープスリープに入る（戻らない）
+    void deepSleep(uint64_t durationUs);
+    
+    // DHCP リースの再利用（再接続/ディープスリープ復帰時に前回のIPを即座に使う）
+    // リース期間の半分（T1）までは前回の値を静的設定として使い、T1 で DHCP に戻す
+    void enableLeaseReuse(bool enable);
+    bool isLeaseReuseEnabled() const;
+    ConnectTimingStats getConnectTimingStats() const;
     
     // コールバック設定
     void onClientConnect(CallbackFunction callback);
@@ -71,10 +262,46 @@ public:
     void clearWiFiSettings();
     void clearNetworkSettings();
     
+    // 設定適用（UI を使わないプロビジョニング）
+    // 保存済みの設定との差分だけを保存・反映し、verify=true なら接続まで確認する
+    // （IP 設定だけの変更は接続を保ったまま適用し、SSID/パスワードが同じなら接続し直さない）
+    ProvisionResult applyConfig(const WiFiCredentials& credentials, const NetworkConfig& config, bool verify = true);
+    ProvisionResult applyConfigJson(const String& json, bool verify = true);
+    // 直前の設定適用（applyConfig、ポータル、シリアル）で行った処理（ConfigAction のビット）
+    ConfigActions getLastConfigActions() const;
+    // 1行の JSON コマンド（apply/status/clear）を処理し、結果を JSON で返す
+    String handleProvisioningCommand(const String& line);
+    static const char* provisionResultName(ProvisionResult result);
+    
+#if SUKEN_WIFI_HTTP_CLIENT
+    // HTTP(S) クライアント（接続を再利用し、リンク断中は送信を待機）
+    // rootCA を指定すると証明書を検証する。nullptr なら検証しない（従来動作）
+    void setCACert(const char* rootCA);
+    void setHttpTimeout(uint16_t timeoutMs);
+    HttpResponse httpGet(const String& url, uint32_t linkWaitMs = 5000);
+    HttpResponse httpPost(const String& url, const String& body, const String& contentType = "application/json", uint32_t linkWaitMs = 5000);
+    HttpStats getHttpStats() const;
+#endif
+    
+    // オフライン送信キュー（切断中のデータを保持し、接続時にまとめて送信）
+    void setOfflineQueue(const OfflineQueueConfig& config, QueueSender sender);
+    bool enqueue(const String& payload);
+    void flushOfflineQueue();
+    // まとめ書き待ちの未送信データを今すぐフラッシュに書く（電源を切る前など。deepSleep() は自動で行う）
+    void saveOfflineQueue();
+    OfflineQueueStats getOfflineQueueStats();
+    
+    // パスフレーズの代わりに PMK を保存する（保存時に一度だけ計算し、接続時の PBKDF2 を省く）
+    // WPA3-SAE のみのネットワークではパスフレーズが必要なため使えない
+    void enablePmkStorage(bool enable);
+    bool isPmkStorageEnabled() const;
+    
     // 設定取得
     WiFiCredentials getStoredCredentials() const;
     NetworkConfig getNetworkConfig() const;
     String getCurrentDNS() const;
+    // フラッシュ書き込みの統計（書き込み回数、スキップ数、1日あたりの書き込み回数など）
+    StoreStats getStoreStats();
     
     // セットアップモード制御
     void enterSetupMode();
@@ -85,10 +312,45 @@ public:
     // セットアップ時にブロックするかの設定（デフォルト: false）
     void setBlockingSetup(bool enable);
     bool getBlockingSetup() const;
+    // init() の実行方式（init() より前に設定）
+    void setInitMode(InitMode mode);
+    InitMode getInitMode() const;
+    // 初期化完了（接続成功またはセットアップモード移行）時に発火
+    void onInitComplete(CallbackFunction callback);
+    bool isInitComplete() const;
+    
+    // タスク構成（init() より前に設定）
+    void setTaskTopology(const TaskTopology& topology);
+    TaskTopology getTaskTopology() const;
+    TaskStats getTaskStats(LibraryTask task) const;
+    // 協調モード（TaskTopology::cooperative）ではアプリの loop() から呼ぶ
+    void loop();
+    LoopStats getLoopStats() const;
+    void resetLoopStats();
     
     // 詳細制御
     void setAPConfig(const IPAddress& ip, const IPAddress& gateway, const IPAddress& subnet);
     void setDeviceName(const String& name);
+    // WiFi.mode() を実際に切り替えた回数（無駄な無線再起動の確認用）
+    uint32_t getRadioModeTransitionCount() const;
+    // ソフトAPのチャネル、最大接続数、ビーコン間隔、パスワード（次のAP開始時に反映）
+    void setSoftAPConfig(const SoftAPConfig& config);
+    SoftAPConfig getSoftAPConfig() const;
+    APStats getAPStats() const;
+    // 直近のポータルセッションの前後のヒープ（最大連続空き）とアリーナの使用量
+    PortalMemoryStats getPortalMemoryStats() const;
+    // ポータルのクライアントごとの受付制限（超えたリクエストは 429 と Retry-After を返す）
+    void setPortalRateLimit(const RateLimitConfig& config);
+    RateLimitConfig getPortalRateLimit() const;
+    RateLimitStats getPortalRateLimitStats() const;
+    std::vector<APClientInfo> getAPClients() const;
+    // Webポータルと並行して動かすプロビジョニング方式を追加（所有権はライブラリへ移る）
+    // 例: addProvisioningTransport(std::unique_ptr<SukenWiFiLib::SmartConfigTransport>(new SukenWiFiLib::SmartConfigTransport()))
+    void addProvisioningTransport(std::unique_ptr<ProvisioningTransport> transport);
+    // 最後に認証情報を受け取った方式の名前（"WebPortal", "SmartConfig", "WPS", "BLE"）
+    String getLastProvisioningTransport() const;
+    // セットアップモード中にWiFi一覧を再スキャンする間隔（既定は0で起動時の1回のみ。最短30秒）
+    void setScanRefreshInterval(uint32_t intervalMs);
     
     // 自動セットアップ（切断時にAPへ）
     void enableAutoSetupOnDisconnect(bool enable);
@@ -108,20 +370,65 @@ private:
     NetworkConfig networkConfig_;
     
     // サーバー関連（セットアップモード時のみ）
-    HttpServer* server_;  // ポインタにして動的管理
-    std::unique_ptr<HttpServer> serverPtr_;
+    HttpServer* server_;  // ポインタにして動的管理（通常はポータル用アリーナ内に配置）
+    bool serverInArena_ = false;
+    // ポータルの間だけ使うメモリ（exitSetupMode() でまとめて返す）
+    PortalArena portalArena_;
+    BufferPool responsePool_;
+    PortalMemoryStats portalMemory_;
+    RateLimiter rateLimiter_;
+    // リクエスト処理中や別タスクからの停止は、ポータルタスクの次の周回まで遅らせる
+    volatile bool servingRequest_ = false;
+    volatile bool portalTeardownPending_ = false;
     IPAddress apIP_;
     String apIPString_;
-    DNSServer dnsServer_;
+    CaptiveDns* dnsServer_ = nullptr;   // server_ と同じくアリーナ内に配置
+    bool dnsInArena_ = false;
+    
+    // 永続化
+    ConfigStore store_;
+    bool storageMounted_ = false;
+    bool pmkStorage_ = false;
     
     // 状態管理
     bool setupMode_;
     bool blockSetup_;
     TaskHandle_t taskHandle_;
     
-    // 通信
-    WiFiClientSecure secureClient_;
-    JsonDoc wifiList_;
+#if SUKEN_WIFI_HTTP_CLIENT
+    // 通信（TLS クライアントは最初のリクエストで作る）
+    std::unique_ptr<HttpSession> http_;
+    const char* caCert_ = nullptr;
+    uint16_t httpTimeoutMs_ = 5000;
+    volatile bool httpResetPending_ = false;
+    HttpStats httpStats_;
+    uint64_t httpLatencyTotalMs_ = 0;
+    uint32_t httpLatencySamples_ = 0;   // 送信まで進んだ要求の数（平均の分母）
+#endif
+    
+    // プロビジョニング方式（先頭は Webポータル）
+    std::vector<std::unique_ptr<ProvisioningTransport>> transports_;
+    String lastProvisioningTransport_;
+    ConfigActions lastConfigActions_ = 0;
+    
+    // ソフトAP
+    SoftAPConfig softAPConfig_;
+    APStats apStats_;
+    static constexpr size_t MAX_AP_CLIENT_RECORDS = 10;
+    APClientInfo apClients_[MAX_AP_CLIENT_RECORDS];
+    
+    // ポータルのWiFi一覧（バージョン付き）とSSE配信先
+    ScanTable scanTable_;
+    static constexpr size_t MAX_SSE_CLIENTS = 4;
+    WiFiClient sseClients_[MAX_SSE_CLIENTS];
+    uint32_t scanRefreshIntervalMs_ = 0;
+    uint32_t lastScanMs_ = 0;
+    uint32_t lastSseKeepaliveMs_ = 0;
+    
+    // オフライン送信キュー
+    OfflineQueue offlineQueue_;
+    QueueSender queueSender_;
+    TaskHandle_t queueTaskHandle_ = nullptr;
     
     // コールバック
     CallbackFunction clientConnectedCallback_;
@@ -129,6 +436,7 @@ private:
     CallbackFunction disconnectedCallback_;
     CallbackFunction connectedCallback_;
     CallbackFunction reconnectedCallback_;
+    CallbackFunction initCompleteCallback_;
     
     // 内部メソッド
     void startAccessPoint();
@@ -136,12 +444,84 @@ private:
     void setupWebServer();
     void connectToWiFi();
     void attemptReconnectNonBlocking();
+    void mountStorage();
+    
+    // 無線モード管理（現在のモードと差分がある場合のみ切り替える）
+    void setRadioMode(wifi_mode_t mode);
+    void beginRadioBatch();
+    void endRadioBatch();
+    void leaveSetupModeToStation();
+    void onStationUp();
+    void startStationMdns();
+    bool beginFromCachedConfig();
+    bool beginFromRtcRecord();
+    bool waitForStation(uint32_t timeoutMs);
+    void storeConnectionRecord();
+    // WiFi.begin() の直前に呼ぶ。静的IP/保存済みリース/DHCP のいずれかを設定し、計測を始める
+    void prepareStationConnect(const String& ssid);
+    void finishInit();
+    
+    // 起動プロファイル
+    void beginBootProfile();
+    // init のタスクと WiFi イベントタスクの両方から呼ぶので bootProfileMutex_ で保護する
+    void markPhaseStart(BootPhase phase);
+    void markPhaseEnd(BootPhase phase);
+    void markGotIp();
+    void setBootFastPath(bool fastPath);
+    void persistBootProfileLocked();
+    void lockBootProfile() const;
+    void unlockBootProfile() const;
+    static const char* bootPhaseName(BootPhase phase);
+    static const char* bootKindName(BootKind kind);
     
     // ファイル操作
     void readWiFiCredentials(WiFiCredentials& credentials) const;
     void saveWiFiCredentials(const WiFiCredentials& credentials);
+    void migrateCredentialsToPmk();
     void readNetworkSettings();
-    void saveNetworkSettings() const;
+    void saveNetworkSettings();
+    bool parseConfigJson(const JsonDoc& doc, WiFiCredentials& credentials, NetworkConfig& config) const;
+    // 設定変更の差分適用
+    ConfigActions planConfigChange(const WiFiCredentials& credentials, const NetworkConfig& config);
+    bool saveConfigChanges(ConfigActions actions, const WiFiCredentials& credentials);
+    void applyLiveConfigChanges(ConfigActions actions);
+    bool importProvisioningFile();
+    
+#if SUKEN_WIFI_HTTP_CLIENT
+    // HTTP(S)
+    HttpResponse httpRequest(const char* method, const String& url, const String& body, const String& contentType, uint32_t linkWaitMs);
+    void closeHttpConnection();
+    void applyCACert();
+#endif
+    
+    // オフライン送信キュー
+    void startQueueDrain();
+    bool drainQueueBatch();
+    
+    // タスク本体（タスクまたは loop() から実行）
+    void startPortalServices();
+    void servicePortal();
+    void runReconnect();
+    void runDeferredInit();
+    void scheduleReconnect();
+    
+    // 協調モード（ブロックしない処理）
+    void initCooperative();
+    void syncFsmPolicy();
+    // WiFi イベントタスクから loop() へリンクの変化を渡す（fsm_ は loop() のタスクだけが触る）
+    void postLinkEvent(bool up);
+    void applyLinkEvents(uint32_t now);
+    void beginStationConnect();
+    void startAsyncScan();
+    void pollAsyncScan();
+    void fillWiFiList(int numNetworks);
+    
+    // タスク管理
+    bool spawnTask(LibraryTask task, TaskFunction_t entry, const char* name);
+    TaskHandle_t* taskHandleSlot(LibraryTask task);
+    const TaskConfig& taskConfig(LibraryTask task) const;
+    void finishTask(LibraryTask task);
+    void taskDelay(uint32_t ms);
     
     // ユーティリティ
     char* getMAC() const;
@@ -150,23 +530,74 @@ private:
     // Webハンドラ
     void handleWiFiSettingPage();
     void handleInfoAPI();
+    void handleSchemaAPI();
     void handleWiFiSettingAPI();
     void handleWiFiListAPI();
+    void handleEventsAPI();
     void handleNotFound();
+    void sendJsonWithETag(const char* json, size_t length);
+    bool admitPortalRequest(RouteClass route);
+    void sendTooManyRequests(RouteClass route, uint32_t retryAfterSec, const char* message);
+    void broadcastScanEvents(bool listChanged);
+    void serviceSse(uint32_t now);
+    
+    // ポータルの停止とメモリ
+    void stopPortal();
+    void acquirePortalArena();
+    void releasePortalArena();
+    
+    // プロビジョニング方式
+    void startProvisioningTransports();
+    void stopProvisioningTransports();
+    void pollProvisioningTransports();
+    void onTransportCredentials(ProvisioningTransport& source, const String& ssid, const String& password);
+    
+    // ソフトAP
+    uint8_t selectAPChannel();
+    void applyAPBeaconInterval();
+    void recordAPClient(const uint8_t* mac, bool connected);
+    void recordAPClientIP(const IPAddress& ip);
+    
+    // 疎通確認
+    void startHealthTask();
+    void softReconnect();
+    
+    // DHCP リースの再利用と接続時間の計測
+    bool applyStoredLease(const String& ssid);
+    void scheduleLeaseRenewal(uint32_t delaySec);
+    void storeLease();
+    void invalidateLease();
+    void recordConnectTiming();
+    void persistLinkRecord();
+    
+    // 接続状態のスナップショット
+    void startRssiSampler();
+    void stopRssiSampler();
+    void sampleRssi();
     
     // タスク
     static void taskMain(void* parameter);
     static void reconnectTask(void* parameter);
+    static void deferredInitTask(void* parameter);
+    static void queueDrainTask(void* parameter);
+    static void healthTask(void* parameter);
+    static void leaseTimerCallback(void* arg);
+    static void rssiTimerCallback(void* arg);
     
     // 定数
     static constexpr uint16_t DEFAULT_HTTP_PORT = 80;
     static constexpr uint16_t DEFAULT_DNS_PORT = 53;
-    static constexpr uint16_t TASK_STACK_SIZE = 8192;
-    static constexpr uint8_t TASK_PRIORITY = 2;
-    static constexpr uint8_t TASK_CORE = 1;
     static constexpr uint8_t MAX_WIFI_RETRY = 20;
     static constexpr uint32_t WIFI_RETRY_DELAY = 500;
     static constexpr uint32_t SETUP_RECONNECT_INTERVAL_MS = 5000;
+    static constexpr uint32_t SETUP_RECONNECT_ATTEMPT_MS = 3000;
+    static constexpr uint32_t AP_START_TIMEOUT_MS = 200;
+    static constexpr uint32_t SSE_KEEPALIVE_MS = 20000;
+    static constexpr uint32_t MIN_SCAN_REFRESH_INTERVAL_MS = 30000;
+    static constexpr size_t PORTAL_RESPONSE_BUFFER_SIZE = 3072;
+    static constexpr size_t PORTAL_RESPONSE_BUFFERS = 3;
+    static constexpr uint32_t APPLY_BUSY_RETRY_SEC = 5;
+    static constexpr uint32_t RSSI_SAMPLE_INTERVAL_MS = 2000;
     
     // 自動切断処理設定
     bool autoSetupOnDisconnect_ = true;
@@ -177,6 +608,71 @@ private:
     uint32_t disconnectRetryDelayMs_ = 500;
     bool wasEverConnected_ = false;
     bool disconnectedSinceLastConnect_ = false;
+    volatile bool stationUp_ = false;     // この接続で onStationUp() を実行済み（IPv4 または IPv6）
+    volatile bool ipv6Global_ = false;
+    bool connectOnIPv6_ = false;
+    
+    // 無線モード管理
+    uint32_t radioModeTransitions_ = 0;
+    uint8_t radioBatchDepth_ = 0;
+    wifi_mode_t pendingRadioMode_ = WIFI_MODE_NULL;
+    bool radioModePending_ = false;
+    volatile bool apStarted_ = false;
+    
+    // タスク構成
+    TaskTopology taskTopology_;
+    TaskStats taskStats_[static_cast<size_t>(LibraryTask::Count)];
+    int64_t taskStartUs_[static_cast<size_t>(LibraryTask::Count)] = {};
+    uint64_t taskSleptUs_[static_cast<size_t>(LibraryTask::Count)] = {};
+    TaskHandle_t initTaskHandle_ = nullptr;
+    
+    // mDNS レスポンダ（ポータルとステーションで共用）
+    MdnsManager mdns_;
+    
+    // 疎通確認
+    HealthMonitor healthMonitor_;
+    TaskHandle_t healthTaskHandle_ = nullptr;
+    volatile bool queueDrainPending_ = false;
+    uint32_t lastQueueBatchMs_ = 0;
+    
+    // 協調モード
+    ConnectionFsm fsm_;
+    QueueHandle_t linkEvents_ = nullptr;
+    LoopStats loopStats_;
+    uint64_t loopTotalUs_ = 0;
+    bool credentialsStored_ = false;
+    bool scanInProgress_ = false;
+    bool apConfigPending_ = false;
+    
+    // 初期化方式
+    InitMode initMode_ = InitMode::Sequential;
+    volatile bool initComplete_ = false;
+    bool networksScanned_ = false;
+    
+    // 起動プロファイル
+    BootProfile bootProfile_;
+    BootProfile previousBootProfile_;
+    SemaphoreHandle_t bootProfileMutex_ = nullptr;
+    bool persistBootProfile_ = false;
+    bool deepSleepFastPath_ = false;
+    bool fastPathActive_ = false;   // 今回の起動で RTC の接続記録から接続を開始した
+    
+    // DHCP リースの再利用と接続時間の計測
+    bool leaseReuse_ = false;
+    bool leaseConfigured_ = false;        // WiFi.config() にリースの値を設定した（DHCP に戻すまで true）
+    volatile bool leaseInUse_ = false;    // リースの値で動作中（T1 で DHCP に切り替えるまで）
+    volatile bool leaseRenewing_ = false; // DHCP へ切り替え中（次の GOT_IP は再接続ではない）
+    esp_timer_handle_t leaseTimer_ = nullptr;
+    int64_t connectStartUs_ = -1;
+    int64_t associatedUs_ = -1;
+    ConnectTimingStats connectTiming_;
+    uint64_t dhcpIpTotalMs_ = 0;
+    uint64_t leaseIpTotalMs_ = 0;
+    bool linkRecordPending_ = false;      // GOT_IP で立て、persistLinkRecord() で接続先を /wifi_state.log に書く
+    
+    // 接続状態のスナップショット（イベントで更新、RSSI は接続中に定期サンプル）
+    SnapshotCell snapshot_;
+    esp_timer_handle_t rssiTimer_ = nullptr;
 };
 
 // 便利なマクロ - より安全な実装
@@ -0,0 +1,72 @@
+#include "SukenWiFiArena.h"
+#include "esp_heap_caps.h"
+
+namespace SukenWiFiLib {
+
+// ---- PortalArena ----
+
+bool PortalArena::begin(size_t capacity) {
+    release();
+    block_ = static_cast<uint8_t*>(heap_caps_malloc(capacity, MALLOC_CAP_8BIT));
+    if (!block_) return false;
+    capacity_ = capacity;
+    used_ = 0;
+    return true;
+}
+
+void* PortalArena::allocate(size_t size, size_t align) {
+    if (!block_ || align == 0) return nullptr;
+    uintptr_t base = reinterpret_cast<uintptr_t>(block_);
+    uintptr_t start = (base + used_ + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+    size_t offset = start - base;
+    if (offset + size > capacity_) return nullptr;
+    used_ = offset + size;
+    return block_ + offset;
+}
+
+void PortalArena::release() {
+    if (!block_) return;
+    heap_caps_free(block_);
+    block_ = nullptr;
+    capacity_ = 0;
+    used_ = 0;
+}
+
+// ---- BufferPool ----
+
+bool BufferPool::begin(PortalArena& arena, size_t bufferSize, size_t count) {
+    reset();
+    if (count == 0 || count > MAX_BUFFERS) return false;
+    base_ = static_cast<char*>(arena.allocate(bufferSize * count, 4));
+    if (!base_) return false;
+    bufferSize_ = bufferSize;
+    count_ = count;
+    freeMask_ = count == MAX_BUFFERS ? 0xFFFFFFFFu : ((1u << count) - 1);
+    return true;
+}
+
+void BufferPool::reset() {
+    // 領域はアリーナごと返すので、ここでは参照を捨てるだけ
+    base_ = nullptr;
+    bufferSize_ = 0;
+    count_ = 0;
+    freeMask_ = 0;
+}
+
+char* BufferPool::acquire() {
+    if (freeMask_ == 0) {
+        if (base_) exhausted_++;
+        return nullptr;
+    }
+    size_t index = static_cast<size_t>(__builtin_ctz(freeMask_));
+    freeMask_ &= ~(1u << index);
+    return base_ + index * bufferSize_;
+}
+
+void BufferPool::release(char* buffer) {
+    if (!base_ || buffer < base_ || buffer >= base_ + bufferSize_ * count_) return;
+    size_t index = static_cast<size_t>(buffer - base_) / bufferSize_;
+    freeMask_ |= 1u << index;
+}
+
+} // namespace SukenWiFiLib
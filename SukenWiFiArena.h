@@ -0,0 +1,73 @@
+#ifndef SUKEN_WIFI_ARENA_H
+#define SUKEN_WIFI_ARENA_H
+
+#include <Arduino.h>
+#include <cstddef>
+
+namespace SukenWiFiLib {
+
+// セットアップポータルの間だけ使うメモリ
+// 開始時に1ブロックだけ確保して切り出し、終了時にまとめて返す。個別の解放はしない
+// （ポータルの確保と解放がアプリの確保と交互に起きて、終了後のヒープが断片化するのを避ける）
+class PortalArena {
+public:
+    ~PortalArena() { release(); }
+
+    bool begin(size_t capacity);
+    // 足りなければ nullptr（呼び出し側は通常のヒープを使う）
+    void* allocate(size_t size, size_t align);
+    void release();
+
+    bool active() const { return block_ != nullptr; }
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return used_; }
+
+private:
+    uint8_t* block_ = nullptr;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+};
+
+// アリーナから切り出した固定長バッファのプール（応答の組み立て用）
+class BufferPool {
+public:
+    static constexpr size_t MAX_BUFFERS = 32;
+
+    bool begin(PortalArena& arena, size_t bufferSize, size_t count);
+    void reset();
+
+    char* acquire();
+    void release(char* buffer);
+
+    size_t bufferSize() const { return bufferSize_; }
+    uint32_t exhausted() const { return exhausted_; }
+
+private:
+    char* base_ = nullptr;
+    size_t bufferSize_ = 0;
+    size_t count_ = 0;
+    uint32_t freeMask_ = 0;     // 1 が空き
+    uint32_t exhausted_ = 0;    // 空きがなく取得できなかった回数
+};
+
+// スコープを抜けるとプールに返すバッファ
+class PooledBuffer {
+public:
+    explicit PooledBuffer(BufferPool& pool) : pool_(pool), data_(pool.acquire()) {}
+    ~PooledBuffer() { if (data_) pool_.release(data_); }
+
+    char* data() const { return data_; }
+    size_t size() const { return data_ ? pool_.bufferSize() : 0; }
+    explicit operator bool() const { return data_ != nullptr; }
+
+private:
+    PooledBuffer(const PooledBuffer&);
+    PooledBuffer& operator=(const PooledBuffer&);
+
+    BufferPool& pool_;
+    char* data_;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_ARENA_H
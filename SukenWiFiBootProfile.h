@@ -0,0 +1,102 @@
+#ifndef SUKEN_WIFI_BOOT_PROFILE_H
+#define SUKEN_WIFI_BOOT_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace SukenWiFiLib {
+
+// 起動プロファイル - init() の各フェーズの所要時間を計測
+enum class BootPhase : uint8_t {
+    Mount = 0,      // SPIFFS マウント（必要ならフォーマット）
+    SettingsLoad,   // 設定ファイルの読み込み
+    Scan,           // 周辺 WiFi スキャン
+    Associate,      // WiFi.begin() → STA_CONNECTED
+    Dhcp,           // STA_CONNECTED → GOT_IP
+    Mdns,           // mDNS レスポンダ開始
+    PortalStart,    // AP 開始 → Web サーバー開始
+    Count
+};
+
+enum class BootKind : uint8_t {
+    Unknown = 0,
+    ColdBoot,       // 電源投入
+    WarmBoot,       // ソフトウェアリセット、WDT など
+    DeepSleepWake   // ディープスリープからの復帰
+};
+
+struct BootPhaseTiming {
+    int64_t startUs = -1;   // esp_timer_get_time() 基準。未計測は -1
+    int64_t endUs = -1;
+};
+
+// 時刻は呼び出し側から渡すため、ホスト上でも動作する（RTC メモリへ memcpy するので仮想関数は持たない）
+struct BootProfile {
+    BootKind kind = BootKind::Unknown;
+    uint32_t bootCount = 0;
+    int64_t initStartUs = -1;
+    int64_t gotIpUs = -1;       // 起動（ディープスリープ復帰）から最初の GOT_IP まで。未取得は -1
+    bool fastPath = false;      // RTC メモリの接続記録から接続した（SPIFFS を使わなかった）
+    BootPhaseTiming phases[static_cast<size_t>(BootPhase::Count)];
+
+    const BootPhaseTiming& phase(BootPhase p) const { return phases[static_cast<size_t>(p)]; }
+    // フェーズの所要時間（未完了なら 0）
+    uint32_t durationUs(BootPhase p) const {
+        const BootPhaseTiming& t = phase(p);
+        return (t.startUs >= 0 && t.endUs >= t.startUs) ? static_cast<uint32_t>(t.endUs - t.startUs) : 0;
+    }
+
+    // 起動時の初回のみ記録（再接続などでは上書きしない）。記録したら true
+    bool markStart(BootPhase p, int64_t nowUs) {
+        BootPhaseTiming& t = phases[static_cast<size_t>(p)];
+        if (t.startUs >= 0) return false;
+        t.startUs = nowUs;
+        return true;
+    }
+    // 開始済みで未完了のときだけ記録。記録したら true
+    bool markEnd(BootPhase p, int64_t nowUs) {
+        BootPhaseTiming& t = phases[static_cast<size_t>(p)];
+        if (t.startUs < 0 || t.endUs >= 0) return false;
+        t.endUs = nowUs;
+        return true;
+    }
+    // 最初の GOT_IP。DHCP フェーズも終える
+    bool markGotIp(int64_t nowUs) {
+        if (gotIpUs < 0) gotIpUs = nowUs;
+        return markEnd(BootPhase::Dhcp, nowUs);
+    }
+
+    // 記録の前後関係が起動手順と矛盾していないか（両方記録されたフェーズだけを比べる）
+    // - 各フェーズは init() 以降に始まり、終了は開始以降
+    // - SPIFFS のマウント後に設定を読む
+    // - アソシエーションの完了（STA_CONNECTED）後に DHCP が始まり、GOT_IP は DHCP の開始以降
+    bool ordered() const {
+        for (size_t i = 0; i < static_cast<size_t>(BootPhase::Count); ++i) {
+            const BootPhaseTiming& t = phases[i];
+            if (t.startUs < 0) {
+                if (t.endUs >= 0) return false;
+                continue;
+            }
+            if (initStartUs >= 0 && t.startUs < initStartUs) return false;
+            if (t.endUs >= 0 && t.endUs < t.startUs) return false;
+        }
+        if (!before(BootPhase::Mount, BootPhase::SettingsLoad)) return false;
+        if (!before(BootPhase::Associate, BootPhase::Dhcp)) return false;
+        const BootPhaseTiming& dhcp = phase(BootPhase::Dhcp);
+        if (gotIpUs >= 0 && dhcp.startUs >= 0 && gotIpUs < dhcp.startUs) return false;
+        return true;
+    }
+
+private:
+    // first が終わってから second が始まった（どちらかが未記録なら判定しない）
+    bool before(BootPhase first, BootPhase second) const {
+        const BootPhaseTiming& a = phase(first);
+        const BootPhaseTiming& b = phase(second);
+        if (a.endUs < 0 || b.startUs < 0) return true;
+        return a.endUs <= b.startUs;
+    }
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_BOOT_PROFILE_H
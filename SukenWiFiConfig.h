@@ -0,0 +1,20 @@
+#ifndef SUKEN_WIFI_CONFIG_H
+#define SUKEN_WIFI_CONFIG_H
+
+// ビルド時の機能選択
+// 使わない機能を 0 にすると、そのコードと依存ライブラリ（HTTPClient、ESPmDNS など）がリンクされず、
+// グローバルの SukenWiFi オブジェクトも小さくなる。
+// 値はライブラリ自身の .cpp にも同じものが見える必要があるため、スケッチの #define ではなく
+// PlatformIO の build_flags や arduino-cli の --build-property で -D を指定する（extras/size_report.sh を参照）
+
+// HTTP(S) クライアント（httpGet/httpPost、疎通確認の HTTP プローブ）
+#ifndef SUKEN_WIFI_HTTP_CLIENT
+#define SUKEN_WIFI_HTTP_CLIENT 1
+#endif
+
+// mDNS レスポンダ。0 なら addMdnsService() などは何もしない（ポータルは IP で開く）
+#ifndef SUKEN_WIFI_MDNS
+#define SUKEN_WIFI_MDNS 1
+#endif
+
+#endif // SUKEN_WIFI_CONFIG_H
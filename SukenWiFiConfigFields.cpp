@@ -0,0 +1,176 @@
+#include "SukenWiFiConfigFields.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+const char* kindName(FieldKind kind) {
+    switch (kind) {
+        case FieldKind::Bool: return "bool";
+        case FieldKind::IPv4: return "ipv4";
+        default: return "text";
+    }
+}
+
+String fieldText(const NetworkConfig& config, const NetworkField& field) {
+    if (field.kind == FieldKind::Bool) return (config.*field.flag) ? "true" : "false";
+    return (config.*field.address).toString();
+}
+
+void fieldToJson(const NetworkConfig& config, const NetworkField& field, JsonObject obj, const char* name) {
+    if (field.kind == FieldKind::Bool) {
+        obj[name] = config.*field.flag;
+    } else {
+        obj[name] = (config.*field.address).toString();
+    }
+}
+
+bool sameField(const NetworkConfig& a, const NetworkConfig& b, const NetworkField& field) {
+    if (field.kind == FieldKind::Bool) return a.*field.flag == b.*field.flag;
+    return a.*field.address == b.*field.address;
+}
+
+struct ConfigActionName {
+    ConfigAction action;
+    const char* name;
+};
+
+constexpr ConfigActionName CONFIG_ACTION_NAMES[] = {
+    {ConfigAction::SaveCredentials, "save_credentials"},
+    {ConfigAction::SaveNetwork, "save_network"},
+    {ConfigAction::ReapplyIP, "reapply_ip"},
+    {ConfigAction::EnableIPv6, "enable_ipv6"},
+    {ConfigAction::Reconnect, "reconnect"},
+};
+
+} // namespace
+
+bool parseNetworkFields(const JsonDocument& doc, NetworkConfig& config) {
+    config = NetworkConfig();
+    // staticOnly の項目を読むかどうかは表の並びに関係なく先に決める
+    config.useStaticIP = doc["useStaticIP"] | config.useStaticIP;
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        if (field.flag == &NetworkConfig::useStaticIP) continue;
+        if (field.staticOnly && !config.useStaticIP) continue;
+        auto value = doc[field.key];
+        if (value.isNull()) continue;
+        if (field.kind == FieldKind::Bool) {
+            config.*field.flag = value | (config.*field.flag);
+        } else if (!(config.*field.address).fromString(value.as<String>())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseConfigFields(const JsonDocument& doc, WiFiCredentials& credentials, NetworkConfig& config) {
+    for (const CredentialField& field : CREDENTIAL_FIELDS) {
+        String text = doc[field.key] | "";
+        if (text.length() < field.minLength || text.length() > field.maxLength) return false;
+        credentials.*field.text = text;
+    }
+    return parseNetworkFields(doc, config);
+}
+
+void networkFieldsToJson(const NetworkConfig& config, JsonObject obj) {
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        fieldToJson(config, field, obj, field.key);
+    }
+}
+
+String encodeNetworkConfig(const NetworkConfig& config) {
+    String content;
+    content.reserve(200);
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        content += field.key;
+        content += '=';
+        content += fieldText(config, field);
+        content += "\r\n";
+    }
+    return content;
+}
+
+bool decodeNetworkLine(const String& key, const String& value, NetworkConfig& config) {
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        if (!key.equals(field.key)) continue;
+        if (field.kind == FieldKind::Bool) {
+            config.*field.flag = (value == "true");
+        } else {
+            (config.*field.address).fromString(value);
+        }
+        return true;
+    }
+    return false;
+}
+
+void configSchemaToJson(const WiFiCredentials& credentials, const NetworkConfig& config, JsonDocument& doc) {
+    NetworkConfig defaults;
+    JsonArray fields = doc.createNestedArray("fields");
+    for (const CredentialField& field : CREDENTIAL_FIELDS) {
+        JsonObject obj = fields.createNestedObject();
+        obj["key"] = field.key;
+        obj["label"] = field.label;
+        obj["type"] = kindName(FieldKind::Text);
+        obj["minLength"] = field.minLength;
+        obj["maxLength"] = field.maxLength;
+        obj["secret"] = field.secret;
+        if (!field.secret) obj["value"] = credentials.*field.text;
+    }
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        JsonObject obj = fields.createNestedObject();
+        obj["key"] = field.key;
+        obj["label"] = field.label;
+        obj["type"] = kindName(field.kind);
+        obj["staticOnly"] = field.staticOnly;
+        fieldToJson(defaults, field, obj, "default");
+        fieldToJson(config, field, obj, "value");
+    }
+}
+
+ConfigActions diffConfig(const WiFiCredentials& oldCredentials, const NetworkConfig& oldConfig,
+                         const WiFiCredentials& newCredentials, const NetworkConfig& newConfig, bool associated) {
+    ConfigActions actions = 0;
+    bool credentialsChanged = false;
+    for (const CredentialField& field : CREDENTIAL_FIELDS) {
+        if (oldCredentials.*field.text != newCredentials.*field.text) credentialsChanged = true;
+    }
+    if (credentialsChanged) actions |= static_cast<uint8_t>(ConfigAction::SaveCredentials);
+
+    bool ipChanged = false;
+    bool ipv6Disabled = false;
+    bool dhcpOnly = !oldConfig.useStaticIP && !newConfig.useStaticIP;
+    for (const NetworkField& field : NETWORK_FIELDS) {
+        // DHCP のままなら固定IP用の項目は使われない（JSON からも読まない）ので比べない
+        if (field.staticOnly && dhcpOnly) continue;
+        if (sameField(oldConfig, newConfig, field)) continue;
+        actions |= static_cast<uint8_t>(ConfigAction::SaveNetwork);
+        if (field.flag == &NetworkConfig::enableIPv6) {
+            if (newConfig.enableIPv6) {
+                actions |= static_cast<uint8_t>(ConfigAction::EnableIPv6);
+            } else {
+                ipv6Disabled = true;
+            }
+        } else {
+            // useStaticIP 自体の切り替えか、固定IPで使う値の変更
+            ipChanged = true;
+        }
+    }
+
+    if (credentialsChanged || !associated || ipv6Disabled) {
+        // IPv6 のアドレスは接続中に外せないので、無効化は接続し直して反映する
+        // 接続し直せば IP 設定と IPv6 も接続時に反映される
+        actions &= ~(static_cast<uint8_t>(ConfigAction::EnableIPv6));
+        actions |= static_cast<uint8_t>(ConfigAction::Reconnect);
+    } else if (ipChanged) {
+        actions |= static_cast<uint8_t>(ConfigAction::ReapplyIP);
+    }
+    return actions;
+}
+
+void configActionsToJson(ConfigActions actions, JsonArray out) {
+    for (const ConfigActionName& entry : CONFIG_ACTION_NAMES) {
+        if (hasConfigAction(actions, entry.action)) out.add(entry.name);
+    }
+}
+
+} // namespace SukenWiFiLib
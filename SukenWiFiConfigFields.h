@@ -0,0 +1,108 @@
+#ifndef SUKEN_WIFI_CONFIG_FIELDS_H
+#define SUKEN_WIFI_CONFIG_FIELDS_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <ArduinoJson.h>
+
+namespace SukenWiFiLib {
+
+// 設定構造体 - 設定を構造化
+// 既定値はここのメンバ初期化子だけで定義する（クリア時やJSONに無い項目もこの値になる）
+struct NetworkConfig {
+    bool useStaticIP = false;
+    IPAddress staticIP = IPAddress(192, 168, 1, 200);
+    IPAddress gateway = IPAddress(192, 168, 1, 1);
+    IPAddress subnet = IPAddress(255, 255, 255, 0);
+    IPAddress primaryDNS = IPAddress(8, 8, 8, 8);
+    IPAddress secondaryDNS = IPAddress(8, 8, 4, 4);
+    bool enableIPv6 = false;   // 接続時にリンクローカルアドレスを作成し、SLAAC でグローバルアドレスを取得
+};
+
+struct WiFiCredentials {
+    String ssid;
+    String password;
+    bool isPmk = false;   // true なら password はパスフレーズではなく PMK（64桁の16進）
+};
+
+enum class FieldKind : uint8_t {
+    Bool = 0,
+    IPv4,
+    Text
+};
+
+// NetworkConfig の1項目。JSON、設定ファイル（key=value）、ポータルのフォームで同じキーを使う
+struct NetworkField {
+    const char* key;
+    const char* label;
+    FieldKind kind;
+    bool NetworkConfig::* flag;          // kind == Bool
+    IPAddress NetworkConfig::* address;  // kind == IPv4
+    bool staticOnly;                     // useStaticIP が true のときだけ JSON から読む
+};
+
+// 並びは設定ファイルとポータルのフォームの項目順（useStaticIP は parseNetworkFields() が最初に読む）
+constexpr NetworkField NETWORK_FIELDS[] = {
+    {"useStaticIP", "固定IPを使う", FieldKind::Bool, &NetworkConfig::useStaticIP, nullptr, false},
+    {"staticIP", "IPアドレス", FieldKind::IPv4, nullptr, &NetworkConfig::staticIP, true},
+    {"gateway", "ゲートウェイ", FieldKind::IPv4, nullptr, &NetworkConfig::gateway, true},
+    {"subnet", "サブネットマスク", FieldKind::IPv4, nullptr, &NetworkConfig::subnet, true},
+    {"primaryDNS", "優先DNS", FieldKind::IPv4, nullptr, &NetworkConfig::primaryDNS, true},
+    {"secondaryDNS", "代替DNS", FieldKind::IPv4, nullptr, &NetworkConfig::secondaryDNS, true},
+    {"enableIPv6", "IPv6を使う", FieldKind::Bool, &NetworkConfig::enableIPv6, nullptr, false},
+};
+
+// WiFiCredentials の項目（ファイルへの保存は PMK の扱いがあるため saveWiFiCredentials() が行う）
+struct CredentialField {
+    const char* key;
+    const char* label;
+    String WiFiCredentials::* text;
+    uint8_t minLength;
+    uint8_t maxLength;
+    bool secret;          // スキーマに現在値を含めない
+};
+
+constexpr CredentialField CREDENTIAL_FIELDS[] = {
+    {"ssid", "SSID", &WiFiCredentials::ssid, 1, 32, false},
+    {"password", "パスワード", &WiFiCredentials::password, 0, 64, true},
+};
+
+// JSON（ポータル、シリアル、インポート）から読む。長さが範囲外、アドレスが不正なら false
+bool parseConfigFields(const JsonDocument& doc, WiFiCredentials& credentials, NetworkConfig& config);
+bool parseNetworkFields(const JsonDocument& doc, NetworkConfig& config);
+void networkFieldsToJson(const NetworkConfig& config, JsonObject obj);
+
+// 設定ファイル（1行1項目の key=value）
+String encodeNetworkConfig(const NetworkConfig& config);
+// 知らないキーなら false
+bool decodeNetworkLine(const String& key, const String& value, NetworkConfig& config);
+
+// ポータルのフォーム用スキーマ（/api/schema）。パスワード以外は現在値も含める
+void configSchemaToJson(const WiFiCredentials& credentials, const NetworkConfig& config, JsonDocument& doc);
+
+// 設定の変更を反映するための処理。ConfigActions はこのビットの組み合わせ
+enum class ConfigAction : uint8_t {
+    SaveCredentials = 0x01,   // wifi_credentials.txt を書き直す
+    SaveNetwork = 0x02,       // network_settings.txt を書き直す
+    ReapplyIP = 0x04,         // アソシエーションを保ったまま IP 設定（固定IP/DHCP）を適用し直す
+    EnableIPv6 = 0x08,        // 接続中のインターフェースで IPv6 を有効にする
+    Reconnect = 0x10          // 接続し直す（SSID/パスワードの変更、または未接続）
+};
+using ConfigActions = uint8_t;
+
+inline bool hasConfigAction(ConfigActions actions, ConfigAction action) {
+    return (actions & static_cast<uint8_t>(action)) != 0;
+}
+
+// 保存済みの設定と新しい設定を比べ、必要最小限の処理を返す
+// associated: 今 STA が接続中か（未接続なら変更がなくても Reconnect）
+// 変更前も変更後も DHCP なら固定IP用の項目は比べない（保存も再適用もしない）。
+// IPv6 の無効化は接続中には戻せないため、接続し直して反映する
+ConfigActions diffConfig(const WiFiCredentials& oldCredentials, const NetworkConfig& oldConfig,
+                         const WiFiCredentials& newCredentials, const NetworkConfig& newConfig, bool associated);
+// 処理の名前（"save_credentials" など）を配列に追加する
+void configActionsToJson(ConfigActions actions, JsonArray out);
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_CONFIG_FIELDS_H
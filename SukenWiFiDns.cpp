@@ -0,0 +1,110 @@
+#include "SukenWiFiDns.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 12;
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t CLASS_IN = 1;
+// 応答レコード: 名前（質問への圧縮ポインタ）2 + 型 2 + クラス 2 + TTL 4 + 長さ 2 + IPv4 4
+constexpr size_t ANSWER_A_SIZE = 16;
+
+uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+void writeU16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+bool CaptiveDns::start(uint16_t port, const IPAddress& ip, uint32_t ttl) {
+    stop();
+    ip_ = ip;
+    ttl_ = ttl;
+    running_ = udp_.begin(port) == 1;
+    return running_;
+}
+
+void CaptiveDns::stop() {
+    if (!running_) return;
+    udp_.stop();
+    running_ = false;
+}
+
+void CaptiveDns::processNextRequest() {
+    if (!running_) return;
+    int size = udp_.parsePacket();
+    if (size <= 0) return;
+    if (static_cast<size_t>(size) > MAX_PACKET || static_cast<size_t>(size) < HEADER_SIZE) {
+        udp_.flush();
+        stats_.dropped++;
+        return;
+    }
+    int length = udp_.read(buffer_, MAX_PACKET);
+    if (length < static_cast<int>(HEADER_SIZE)) {
+        stats_.dropped++;
+        return;
+    }
+    stats_.queries++;
+    size_t replyLength = buildReply(static_cast<size_t>(length));
+    if (replyLength == 0) {
+        stats_.dropped++;
+        return;
+    }
+    udp_.beginPacket(udp_.remoteIP(), udp_.remotePort());
+    udp_.write(buffer_, replyLength);
+    udp_.endPacket();
+}
+
+size_t CaptiveDns::buildReply(size_t length) {
+    // 標準問い合わせ（QR=0, OPCODE=0）で質問が1つのものだけに答える
+    uint8_t flags1 = buffer_[2];
+    if ((flags1 & 0x80) != 0 || ((flags1 >> 3) & 0x0F) != 0) return 0;
+    if (readU16(buffer_ + 4) != 1) return 0;
+
+    // 質問の名前を読み飛ばす（問い合わせには圧縮ポインタは来ない）
+    size_t pos = HEADER_SIZE;
+    while (pos < length && buffer_[pos] != 0) {
+        if ((buffer_[pos] & 0xC0) != 0) return 0;
+        pos += buffer_[pos] + 1;
+    }
+    if (pos + 5 > length) return 0;
+    pos++;
+    uint16_t qtype = readU16(buffer_ + pos);
+    uint16_t qclass = readU16(buffer_ + pos + 2);
+    pos += 4;
+
+    bool answerA = qtype == TYPE_A && qclass == CLASS_IN;
+    if (answerA && pos + ANSWER_A_SIZE > MAX_PACKET) return 0;
+
+    // ヘッダーを応答に書き換える（ID と RD はそのまま、AA=1、RCODE=NOERROR）
+    buffer_[2] = static_cast<uint8_t>(0x80 | 0x04 | (flags1 & 0x01));
+    buffer_[3] = 0;
+    writeU16(buffer_ + 6, answerA ? 1 : 0);
+    writeU16(buffer_ + 8, 0);
+    writeU16(buffer_ + 10, 0);   // EDNS の OPT などの追加レコードは返さない
+
+    if (!answerA) {
+        // 名前は存在するがその型のレコードはない（NODATA）。NXDOMAIN だと A まで否定したと解釈されうる
+        stats_.noData++;
+        return pos;
+    }
+    uint8_t* answer = buffer_ + pos;
+    writeU16(answer, 0xC000 | HEADER_SIZE);
+    writeU16(answer + 2, TYPE_A);
+    writeU16(answer + 4, CLASS_IN);
+    writeU16(answer + 6, static_cast<uint16_t>(ttl_ >> 16));
+    writeU16(answer + 8, static_cast<uint16_t>(ttl_));
+    writeU16(answer + 10, 4);
+    for (int i = 0; i < 4; ++i) {
+        answer[12 + i] = ip_[i];
+    }
+    stats_.answeredA++;
+    return pos + ANSWER_A_SIZE;
+}
+
+} // namespace SukenWiFiLib
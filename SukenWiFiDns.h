@@ -0,0 +1,42 @@
+#ifndef SUKEN_WIFI_DNS_H
+#define SUKEN_WIFI_DNS_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+namespace SukenWiFiLib {
+
+struct CaptiveDnsStats {
+    uint32_t queries = 0;
+    uint32_t answeredA = 0;
+    uint32_t noData = 0;     // AAAA など A 以外の問い合わせ（応答レコードなしで返す）
+    uint32_t dropped = 0;    // 形式不正、複数の質問など
+};
+
+// セットアップポータル用の DNS サーバー（どの名前も AP のIPに向ける）
+// DNSServer は問い合わせの型を見ずに A レコードを返すため、AAAA に A が返って端末が待たされることがある。
+// ここでは A には AP のIPを、AAAA などそれ以外の型には応答レコードなし（NODATA）を返す
+class CaptiveDns {
+public:
+    bool start(uint16_t port, const IPAddress& ip, uint32_t ttl = 300);
+    void stop();
+    void processNextRequest();
+
+    CaptiveDnsStats stats() const { return stats_; }
+
+    static constexpr size_t MAX_PACKET = 512;
+
+private:
+    size_t buildReply(size_t length);
+
+    WiFiUDP udp_;
+    IPAddress ip_;
+    uint32_t ttl_ = 300;
+    bool running_ = false;
+    CaptiveDnsStats stats_;
+    uint8_t buffer_[MAX_PACKET];
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_DNS_H
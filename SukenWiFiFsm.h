@@ -0,0 +1,129 @@
+#ifndef SUKEN_WIFI_FSM_H
+#define SUKEN_WIFI_FSM_H
+
+#include <stdint.h>
+
+namespace SukenWiFiLib {
+
+// 接続状態
+enum class LinkState : uint8_t {
+    Idle = 0,          // 何もしていない（初期化前、自動再接続無効）
+    Disconnected,      // 切断を検知。次の tick() で再接続かポータルへ
+    Connecting,        // STA 接続中（期限まで待つ）
+    Connected,         // IP 取得済み
+    Portal,            // セットアップモード
+    PortalConnecting   // セットアップモード中に保存済み WiFi へ接続試行中
+};
+
+// tick() が要求する操作
+enum class FsmAction : uint8_t {
+    None = 0,
+    BeginConnect,      // WiFi.begin() を呼ぶ
+    EnterPortal,       // セットアップモードへ
+    ExitPortal         // セットアップモードを終了して STA へ
+};
+
+struct FsmPolicy {
+    uint8_t attemptsBeforePortal = 6;       // 切断後、ポータルへ移行するまでのポーリング回数
+    uint32_t retryDelayMs = 500;            // ポーリング間隔
+    uint32_t portalRetryIntervalMs = 5000;  // セットアップ中の再接続間隔
+    uint32_t portalAttemptMs = 3000;        // セットアップ中の1回の接続待ち時間
+    bool autoPortal = true;                 // 切断時にセットアップへ移行する
+    bool retryInPortal = true;              // セットアップ中に保存済み WiFi へ再接続する
+};
+
+// 接続/再接続/ポータル移行の状態機械
+// 時刻は呼び出し側から渡すため、ブロックせず、ホスト上でも動作する
+class ConnectionFsm {
+public:
+    void setPolicy(const FsmPolicy& policy) { policy_ = policy; }
+    const FsmPolicy& policy() const { return policy_; }
+    void setHasCredentials(bool has) { hasCredentials_ = has; }
+    LinkState state() const { return state_; }
+    bool inPortal() const { return state_ == LinkState::Portal || state_ == LinkState::PortalConnecting; }
+
+    // リンク断（STA_DISCONNECTED）。接続試行中の切断イベントは期限まで待つので無視する
+    void onLinkDown(uint32_t now) {
+        (void)now;
+        if (state_ == LinkState::Connected) {
+            state_ = policy_.autoPortal ? LinkState::Disconnected : LinkState::Idle;
+        }
+    }
+
+    // リンク確立（GOT_IP）
+    void onLinkUp(uint32_t now) {
+        (void)now;
+        if (inPortal()) exitPortalPending_ = true;
+        state_ = LinkState::Connected;
+    }
+
+    // 接続開始を要求（beginNow=false なら既に開始済みの接続を待つだけ）
+    void requestConnect(uint32_t now, uint32_t timeoutMs, bool beginNow = true) {
+        deadline_ = now + timeoutMs;
+        state_ = inPortal() ? LinkState::PortalConnecting : LinkState::Connecting;
+        lastPortalAttempt_ = now;
+        beginPending_ = beginNow;
+    }
+
+    // 外部要因でセットアップモードに入った
+    void enterPortal(uint32_t now) {
+        state_ = LinkState::Portal;
+        lastPortalAttempt_ = now;
+    }
+
+    FsmAction tick(uint32_t now) {
+        if (exitPortalPending_) {
+            exitPortalPending_ = false;
+            return FsmAction::ExitPortal;
+        }
+        if (beginPending_) {
+            beginPending_ = false;
+            return FsmAction::BeginConnect;
+        }
+        switch (state_) {
+            case LinkState::Disconnected:
+                if (!hasCredentials_) {
+                    enterPortal(now);
+                    return FsmAction::EnterPortal;
+                }
+                state_ = LinkState::Connecting;
+                deadline_ = now + static_cast<uint32_t>(policy_.attemptsBeforePortal) * policy_.retryDelayMs;
+                return FsmAction::BeginConnect;
+            case LinkState::Connecting:
+                if (static_cast<int32_t>(now - deadline_) >= 0) {
+                    enterPortal(now);
+                    return FsmAction::EnterPortal;
+                }
+                return FsmAction::None;
+            case LinkState::Portal:
+                if (policy_.retryInPortal && hasCredentials_ &&
+                    now - lastPortalAttempt_ >= policy_.portalRetryIntervalMs) {
+                    lastPortalAttempt_ = now;
+                    deadline_ = now + policy_.portalAttemptMs;
+                    state_ = LinkState::PortalConnecting;
+                    return FsmAction::BeginConnect;
+                }
+                return FsmAction::None;
+            case LinkState::PortalConnecting:
+                if (static_cast<int32_t>(now - deadline_) >= 0) {
+                    state_ = LinkState::Portal;
+                }
+                return FsmAction::None;
+            default:
+                return FsmAction::None;
+        }
+    }
+
+private:
+    FsmPolicy policy_;
+    LinkState state_ = LinkState::Idle;
+    bool hasCredentials_ = false;
+    bool exitPortalPending_ = false;
+    bool beginPending_ = false;
+    uint32_t deadline_ = 0;
+    uint32_t lastPortalAttempt_ = 0;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_FSM_H
@@ -0,0 +1,289 @@
+#include "SukenWiFiHealth.h"
+#include "SukenWiFiConfig.h"
+#include <WiFi.h>
+#if SUKEN_WIFI_HTTP_CLIENT
+#include <HTTPClient.h>
+#endif
+#include "lwip/dns.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+// 結果待ちの打ち切りに加える余裕（ping 自体のタイムアウト通知を待つため）
+constexpr uint32_t PROBE_TIMEOUT_MARGIN_MS = 100;
+
+} // namespace
+
+HealthMonitor::HealthMonitor() {
+    mutex_ = xSemaphoreCreateMutex();
+}
+
+HealthMonitor::~HealthMonitor() {
+    deletePingSession();
+    if (mutex_) vSemaphoreDelete(mutex_);
+}
+
+void HealthMonitor::lock() const {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+}
+
+void HealthMonitor::unlock() const {
+    xSemaphoreGive(mutex_);
+}
+
+void HealthMonitor::configure(const HealthConfig& config) {
+    // 実行中の巡回はそのままの設定で終え、次の巡回から使う（ping セッションの破棄も tick() で行う）
+    lock();
+    config_ = config;
+    if (config_.failureThreshold == 0) config_.failureThreshold = 1;
+    if (config_.failIntervalMs > config_.intervalMs) config_.failIntervalMs = config_.intervalMs;
+    if (config_.maxIntervalMs < config_.intervalMs) config_.maxIntervalMs = config_.intervalMs;
+    unlock();
+}
+
+HealthConfig HealthMonitor::config() const {
+    lock();
+    HealthConfig copy = config_;
+    unlock();
+    return copy;
+}
+
+bool HealthMonitor::enabled() const {
+    lock();
+    bool on = config_.enabled;
+    unlock();
+    return on;
+}
+
+void HealthMonitor::onLinkUp(uint32_t now) {
+    health_ = LinkHealth::Unknown;
+    stats_.consecutiveFailures = 0;
+    step_ = Step::Idle;
+    lock();
+    currentIntervalMs_ = config_.intervalMs;
+    // DHCP やゲートウェイの異常はつながった直後に多いので、最初は短い間隔で確認する
+    nextRoundMs_ = now + config_.failIntervalMs;
+    unlock();
+}
+
+void HealthMonitor::onLinkDown() {
+    if (step_ == Step::Gateway && ping_) esp_ping_stop(ping_);
+    step_ = Step::Idle;
+    health_ = LinkHealth::Down;
+}
+
+const char* HealthMonitor::healthName(LinkHealth health) {
+    switch (health) {
+        case LinkHealth::Healthy: return "healthy";
+        case LinkHealth::Degraded: return "degraded";
+        case LinkHealth::Unhealthy: return "unhealthy";
+        case LinkHealth::Down: return "down";
+        default: return "unknown";
+    }
+}
+
+bool HealthMonitor::tick(uint32_t now, bool allowBlocking) {
+    if (health_ == LinkHealth::Down) return false;
+    allowBlocking_ = allowBlocking;
+
+    if (step_ == Step::Idle) {
+        if (static_cast<int32_t>(now - nextRoundMs_) < 0) return false;
+        // DNS ホストや URL の String は巡回の間に差し替えられないよう写しを使う
+        lock();
+        roundConfig_ = config_;
+        unlock();
+        if (!roundConfig_.enabled) {
+            nextRoundMs_ = now + roundConfig_.intervalMs;
+            return false;
+        }
+        if (!roundConfig_.pingGateway) deletePingSession();
+        probesRun_ = 0;
+        probesFailed_ = 0;
+        return advance(Step::Gateway, now);
+    }
+
+    if (result_ == Result::Pending) {
+        if (now - stepStartMs_ < roundConfig_.probeTimeoutMs + PROBE_TIMEOUT_MARGIN_MS) return false;
+        if (step_ == Step::Gateway && ping_) esp_ping_stop(ping_);
+        result_ = Result::Failed;
+    }
+
+    if (result_ == Result::Ok) {
+        if (step_ == Step::Gateway) {
+            recordGateway(pingRttMs_);
+        } else if (step_ == Step::Dns) {
+            stats_.dnsLastMs = now - stepStartMs_;
+        }
+    } else {
+        probesFailed_++;
+    }
+    return advance(following(step_), now);
+}
+
+HealthMonitor::Step HealthMonitor::following(Step step) {
+    switch (step) {
+        case Step::Gateway: return Step::Dns;
+        case Step::Dns: return Step::Http;
+        default: return Step::Idle;
+    }
+}
+
+bool HealthMonitor::advance(Step from, uint32_t now) {
+    for (Step step = from; step != Step::Idle; step = following(step)) {
+        if (startStep(step, now)) {
+            step_ = step;
+            return false;
+        }
+    }
+    step_ = Step::Idle;
+    return finishRound(now);
+}
+
+bool HealthMonitor::startStep(Step step, uint32_t now) {
+    // コールバックが正しい手順を参照できるよう、開始前に設定しておく
+    step_ = step;
+    result_ = Result::Pending;
+    stepStartMs_ = now;
+    switch (step) {
+        case Step::Gateway: {
+            if (!roundConfig_.pingGateway) return false;
+            probesRun_++;
+            IPAddress gateway = WiFi.gatewayIP();
+            if (gateway == IPAddress(0, 0, 0, 0) || !ensurePingSession(gateway) || esp_ping_start(ping_) != ESP_OK) {
+                result_ = Result::Failed;
+            }
+            return true;
+        }
+        case Step::Dns: {
+            if (roundConfig_.dnsHost.length() == 0) return false;
+            probesRun_++;
+            ip_addr_t addr;
+            err_t err = dns_gethostbyname(roundConfig_.dnsHost.c_str(), &addr, &HealthMonitor::onDnsFound, this);
+            if (err == ERR_OK) {
+                result_ = Result::Ok; // キャッシュ済み（TTL 内）
+            } else if (err != ERR_INPROGRESS) {
+                result_ = Result::Failed;
+            }
+            return true;
+        }
+        case Step::Http: {
+#if SUKEN_WIFI_HTTP_CLIENT
+            if (roundConfig_.httpUrl.length() == 0 || !allowBlocking_) return false;
+            probesRun_++;
+            HTTPClient http;
+            http.setConnectTimeout(roundConfig_.probeTimeoutMs);
+            http.setTimeout(roundConfig_.probeTimeoutMs);
+            uint32_t start = millis();
+            int code = -1;
+            if (http.begin(roundConfig_.httpUrl)) {
+                code = http.sendRequest("HEAD", String());
+                http.end();
+            }
+            stats_.httpLastMs = millis() - start;
+            result_ = code > 0 ? Result::Ok : Result::Failed;
+            return true;
+#else
+            // HTTP クライアントを外したビルドでは httpUrl を無視する
+            return false;
+#endif
+        }
+        default:
+            return false;
+    }
+}
+
+bool HealthMonitor::finishRound(uint32_t now) {
+    if (probesRun_ == 0) {
+        // プローブが1つも有効でなければ判定しない
+        nextRoundMs_ = now + roundConfig_.intervalMs;
+        return false;
+    }
+    stats_.rounds++;
+    if (probesFailed_ < probesRun_) {
+        // 1つでも成功すれば上流は生きている（ICMP を落とすルーターもある）
+        bool wasHealthy = health_ == LinkHealth::Healthy;
+        stats_.consecutiveFailures = 0;
+        health_ = probesFailed_ == 0 ? LinkHealth::Healthy : LinkHealth::Degraded;
+        if (health_ == LinkHealth::Healthy && wasHealthy) {
+            currentIntervalMs_ = currentIntervalMs_ * 2 > roundConfig_.maxIntervalMs ? roundConfig_.maxIntervalMs : currentIntervalMs_ * 2;
+        } else {
+            currentIntervalMs_ = roundConfig_.intervalMs;
+        }
+        nextRoundMs_ = now + currentIntervalMs_;
+        return false;
+    }
+
+    stats_.failedRounds++;
+    stats_.consecutiveFailures++;
+    nextRoundMs_ = now + roundConfig_.failIntervalMs;
+    if (stats_.consecutiveFailures >= roundConfig_.failureThreshold) {
+        health_ = LinkHealth::Unhealthy;
+        stats_.consecutiveFailures = 0;
+        stats_.softReconnects++;
+        return true;
+    }
+    health_ = LinkHealth::Degraded;
+    return false;
+}
+
+void HealthMonitor::recordGateway(uint32_t ms) {
+    stats_.gatewayLastMs = ms;
+    if (ms > stats_.gatewayMaxMs) stats_.gatewayMaxMs = ms;
+    gatewayTotalMs_ += ms;
+    gatewaySamples_++;
+    stats_.gatewayAvgMs = static_cast<uint32_t>(gatewayTotalMs_ / gatewaySamples_);
+}
+
+bool HealthMonitor::ensurePingSession(const IPAddress& target) {
+    if (ping_ && pingTarget_ == target) return true;
+    deletePingSession();
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    config.count = 1;
+    config.timeout_ms = roundConfig_.probeTimeoutMs;
+    IP_ADDR4(&config.target_addr, target[0], target[1], target[2], target[3]);
+    esp_ping_callbacks_t callbacks;
+    callbacks.cb_args = this;
+    callbacks.on_ping_success = &HealthMonitor::onPingSuccess;
+    callbacks.on_ping_timeout = &HealthMonitor::onPingTimeout;
+    callbacks.on_ping_end = nullptr;
+    // セッション（と ping タスク）はゲートウェイが変わるまで使い回す
+    if (esp_ping_new_session(&config, &callbacks, &ping_) != ESP_OK) {
+        ping_ = nullptr;
+        return false;
+    }
+    pingTarget_ = target;
+    return true;
+}
+
+void HealthMonitor::deletePingSession() {
+    if (!ping_) return;
+    esp_ping_stop(ping_);
+    esp_ping_delete_session(ping_);
+    ping_ = nullptr;
+}
+
+void HealthMonitor::onPingSuccess(esp_ping_handle_t handle, void* args) {
+    HealthMonitor* self = static_cast<HealthMonitor*>(args);
+    if (self->step_ != Step::Gateway) return;
+    uint32_t elapsed = 0;
+    esp_ping_get_profile(handle, ESP_PING_PROF_TIMEGAP, &elapsed, sizeof(elapsed));
+    self->pingRttMs_ = elapsed;
+    self->result_ = Result::Ok;
+}
+
+void HealthMonitor::onPingTimeout(esp_ping_handle_t handle, void* args) {
+    (void)handle;
+    HealthMonitor* self = static_cast<HealthMonitor*>(args);
+    if (self->step_ != Step::Gateway) return;
+    self->result_ = Result::Failed;
+}
+
+void HealthMonitor::onDnsFound(const char* name, const ip_addr_t* ipaddr, void* args) {
+    (void)name;
+    HealthMonitor* self = static_cast<HealthMonitor*>(args);
+    if (self->step_ != Step::Dns) return;
+    self->result_ = ipaddr ? Result::Ok : Result::Failed;
+}
+
+} // namespace SukenWiFiLib
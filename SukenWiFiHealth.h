@@ -0,0 +1,108 @@
+#ifndef SUKEN_WIFI_HEALTH_H
+#define SUKEN_WIFI_HEALTH_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "ping/ping_sock.h"
+
+namespace SukenWiFiLib {
+
+// リンクの実際の疎通状態（WL_CONNECTED でも上流が死んでいることがある）
+enum class LinkHealth : uint8_t {
+    Unknown = 0,   // まだ判定していない
+    Healthy,       // 全プローブ成功
+    Degraded,      // 一部のプローブが失敗（ICMP を落とすルーターなど）
+    Unhealthy,     // 全プローブの失敗が閾値回数続いた（ソフト再接続を行う）
+    Down           // 未接続
+};
+
+struct HealthConfig {
+    bool enabled = false;
+    uint32_t intervalMs = 30000;       // 成功後の最初の間隔
+    uint32_t maxIntervalMs = 120000;   // 成功が続くと間隔を倍にしていく上限
+    uint32_t failIntervalMs = 5000;    // 失敗後の再確認間隔
+    uint32_t probeTimeoutMs = 1000;    // 1プローブの上限時間
+    uint8_t failureThreshold = 3;      // 連続失敗でソフト再接続
+    bool pingGateway = true;           // ゲートウェイへ ICMP ping
+    String dnsHost;                    // 空ならDNS確認なし（例: "example.com"）
+    String httpUrl;                    // 空ならHTTP確認なし。ブロッキングのため協調モードでは行わない
+};
+
+struct HealthStats {
+    uint32_t rounds = 0;
+    uint32_t failedRounds = 0;
+    uint8_t consecutiveFailures = 0;
+    uint32_t softReconnects = 0;
+    uint32_t gatewayLastMs = 0;
+    uint32_t gatewayAvgMs = 0;
+    uint32_t gatewayMaxMs = 0;
+    uint32_t dnsLastMs = 0;
+    uint32_t httpLastMs = 0;
+};
+
+// ゲートウェイ ping、DNS解決、HTTP の順にプローブする（ping と DNS は非同期）
+// configure() はアプリから、tick() はヘルスタスクから呼ばれるため、設定はロックして受け渡す
+class HealthMonitor {
+public:
+    HealthMonitor();
+    ~HealthMonitor();
+
+    void configure(const HealthConfig& config);
+    HealthConfig config() const;
+    bool enabled() const;   // config() と違い String を写さない（タスクのループ条件用）
+
+    // リンク確立/切断時に呼ぶ
+    void onLinkUp(uint32_t now);
+    void onLinkDown();
+
+    // 定期的に呼ぶ。true ならソフト再接続が必要。allowBlocking=false なら HTTP プローブは行わない
+    bool tick(uint32_t now, bool allowBlocking);
+    bool probing() const { return step_ != Step::Idle; }
+
+    LinkHealth health() const { return health_; }
+    HealthStats stats() const { return stats_; }
+    static const char* healthName(LinkHealth health);
+
+private:
+    enum class Step : uint8_t { Idle = 0, Gateway, Dns, Http };
+    enum class Result : uint8_t { Pending = 0, Ok, Failed };
+
+    static Step following(Step step);
+    bool advance(Step from, uint32_t now);
+    bool startStep(Step step, uint32_t now);
+    bool finishRound(uint32_t now);
+    void recordGateway(uint32_t ms);
+    bool ensurePingSession(const IPAddress& target);
+    void deletePingSession();
+    void lock() const;
+    void unlock() const;
+
+    static void onPingSuccess(esp_ping_handle_t handle, void* args);
+    static void onPingTimeout(esp_ping_handle_t handle, void* args);
+    static void onDnsFound(const char* name, const ip_addr_t* ipaddr, void* args);
+
+    HealthConfig config_;        // configure() で受け取った設定（ロックして読む）
+    HealthConfig roundConfig_;   // 1巡のプローブで使う設定。巡回の開始時に config_ から写す
+    HealthStats stats_;
+    LinkHealth health_ = LinkHealth::Unknown;
+    uint64_t gatewayTotalMs_ = 0;
+    uint32_t gatewaySamples_ = 0;
+
+    volatile Step step_ = Step::Idle;   // ping/DNS のコールバック（別タスク）からも参照する
+    volatile Result result_ = Result::Pending;
+    volatile uint32_t pingRttMs_ = 0;
+    uint32_t stepStartMs_ = 0;
+    uint32_t nextRoundMs_ = 0;
+    uint32_t currentIntervalMs_ = 0;
+    uint8_t probesRun_ = 0;
+    uint8_t probesFailed_ = 0;
+    bool allowBlocking_ = false;
+
+    esp_ping_handle_t ping_ = nullptr;
+    IPAddress pingTarget_;
+    SemaphoreHandle_t mutex_ = nullptr;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_HEALTH_H
@@ -0,0 +1,111 @@
+#include "SukenESPWiFi.h"
+#include "SukenWiFiHttp.h"
+
+#if SUKEN_WIFI_HTTP_CLIENT
+
+namespace SukenWiFiLib {
+
+void SukenESPWiFi::setCACert(const char* rootCA) {
+    caCert_ = rootCA;
+    closeHttpConnection();
+    if (http_) applyCACert();
+}
+
+void SukenESPWiFi::applyCACert() {
+    if (caCert_) {
+        http_->secureClient.setCACert(caCert_);
+    } else {
+        http_->secureClient.setInsecure();
+    }
+}
+
+void SukenESPWiFi::setHttpTimeout(uint16_t timeoutMs) { httpTimeoutMs_ = timeoutMs; }
+
+HttpResponse SukenESPWiFi::httpGet(const String& url, uint32_t linkWaitMs) {
+    return httpRequest("GET", url, String(), String(), linkWaitMs);
+}
+
+HttpResponse SukenESPWiFi::httpPost(const String& url, const String& body, const String& contentType, uint32_t linkWaitMs) {
+    return httpRequest("POST", url, body, contentType, linkWaitMs);
+}
+
+HttpStats SukenESPWiFi::getHttpStats() const { return httpStats_; }
+
+void SukenESPWiFi::closeHttpConnection() {
+    if (!http_ || http_->host.length() == 0) return;
+    http_->client.end();
+    http_->secureClient.stop();
+    http_->plainClient.stop();
+    http_->host = "";
+}
+
+HttpResponse SukenESPWiFi::httpRequest(const char* method, const String& url, const String& body, const String& contentType, uint32_t linkWaitMs) {
+    HttpResponse response;
+    httpStats_.requests++;
+    
+    // 再接続中はタイムアウトさせずにリンク回復を待つ
+    uint32_t waitStart = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - waitStart >= linkWaitMs) {
+            httpStats_.linkDownRejects++;
+            httpStats_.failures++;
+            response.status = HTTP_ERROR_LINK_DOWN;
+            return response;
+        }
+        delay(50);
+    }
+    
+    if (!http_) {
+        http_.reset(new HttpSession());
+        applyCACert();
+    }
+    HttpSession& session = *http_;
+    
+    // scheme://host:port が同じなら keep-alive 接続を再利用する
+    bool secure = url.startsWith("https://");
+    int hostEnd = url.indexOf('/', secure ? 8 : 7);
+    String host = hostEnd < 0 ? url : url.substring(0, hostEnd);
+    WiFiClient& client = secure ? static_cast<WiFiClient&>(session.secureClient) : session.plainClient;
+    if (httpResetPending_ || host != session.host) {
+        httpResetPending_ = false;
+        closeHttpConnection();
+    }
+    response.reusedConnection = (host == session.host) && client.connected();
+    if (response.reusedConnection) {
+        httpStats_.reusedConnections++;
+    } else {
+        httpStats_.newConnections++;
+    }
+    
+    uint32_t start = millis();
+    session.client.setReuse(true);
+    session.client.setTimeout(httpTimeoutMs_);
+    if (!session.client.begin(client, url)) {
+        httpStats_.failures++;
+        response.status = HTTPC_ERROR_CONNECTION_REFUSED;
+        return response;
+    }
+    session.host = host;
+    if (contentType.length() > 0) {
+        session.client.addHeader("Content-Type", contentType);
+    }
+    response.status = session.client.sendRequest(method, body);
+    if (response.status > 0) {
+        response.body = session.client.getString();
+    } else {
+        httpStats_.failures++;
+        closeHttpConnection();
+    }
+    response.latencyMs = millis() - start;
+    
+    httpStats_.lastLatencyMs = response.latencyMs;
+    if (response.latencyMs > httpStats_.maxLatencyMs) httpStats_.maxLatencyMs = response.latencyMs;
+    httpLatencyTotalMs_ += response.latencyMs;
+    httpLatencySamples_++;
+    httpStats_.avgLatencyMs = static_cast<uint32_t>(httpLatencyTotalMs_ / httpLatencySamples_);
+    return response;
+}
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_HTTP_CLIENT
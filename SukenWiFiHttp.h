@@ -0,0 +1,28 @@
+#ifndef SUKEN_WIFI_HTTP_H
+#define SUKEN_WIFI_HTTP_H
+
+// HTTP(S) ヘルパーの接続（ライブラリ内部用）
+// SukenESPWiFi.h から HTTPClient.h / WiFiClientSecure.h を外すため、ここで定義して .cpp だけが読み込む
+
+#include "SukenWiFiConfig.h"
+
+#if SUKEN_WIFI_HTTP_CLIENT
+
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+namespace SukenWiFiLib {
+
+// 最初の httpGet()/httpPost() で生成する（使わないアプリでは確保しない）
+struct HttpSession {
+    WiFiClientSecure secureClient;
+    WiFiClient plainClient;
+    HTTPClient client;
+    String host;           // keep-alive 中の接続先（scheme://host:port）
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_HTTP_CLIENT
+
+#endif // SUKEN_WIFI_HTTP_H
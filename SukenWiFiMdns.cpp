@@ -0,0 +1,173 @@
+#include "SukenWiFiMdns.h"
+
+#if SUKEN_WIFI_MDNS
+
+#include <ESPmDNS.h>
+#include "mdns.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+// ESP-IDF の mdns API はサービス名とプロトコルに "_" を付けて渡す（ESPmDNS は内部で付ける）
+String underscored(const String& name) {
+    return name.startsWith("_") ? name : String("_") + name;
+}
+
+} // namespace
+
+MdnsManager::MdnsManager() {
+    mutex_ = xSemaphoreCreateMutex();
+}
+
+MdnsManager::~MdnsManager() {
+    if (mutex_) vSemaphoreDelete(mutex_);
+}
+
+void MdnsManager::lock() {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+}
+
+void MdnsManager::unlock() {
+    xSemaphoreGive(mutex_);
+}
+
+bool MdnsManager::begin(const String& hostname) {
+    lock();
+    if (running_ && hostname == hostname_) {
+        unlock();
+        announce();
+        return true;
+    }
+    if (running_) {
+        // ホスト名が変わった（ポータルとステーションで名前が違う場合など）
+        MDNS.end();
+        running_ = false;
+        stats_.running = false;
+    }
+    hostname_ = hostname;
+    bool ok = startLocked();
+    unlock();
+    return ok;
+}
+
+bool MdnsManager::startLocked() {
+    if (!MDNS.begin(hostname_.c_str())) {
+        stats_.failures++;
+        // 失敗が続くほど間隔を空ける
+        retryDelayMs_ = retryDelayMs_ == 0 ? RETRY_MIN_MS : retryDelayMs_ * 2;
+        if (retryDelayMs_ > RETRY_MAX_MS) retryDelayMs_ = RETRY_MAX_MS;
+        retryAtMs_ = millis() + retryDelayMs_;
+        retryPending_ = true;
+        return false;
+    }
+    running_ = true;
+    retryPending_ = false;
+    retryDelayMs_ = 0;
+    stats_.running = true;
+    stats_.starts++;
+    for (const MdnsService& service : services_) {
+        registerLocked(service);
+    }
+    return true;
+}
+
+void MdnsManager::announce() {
+    if (!running_) return;
+    // 同じホスト名を設定し直すと、全インターフェースでプローブと告知をやり直す
+    // （IDF の mdns には告知だけを行う公開APIがない）
+    lock();
+    esp_err_t err = mdns_hostname_set(hostname_.c_str());
+    unlock();
+    if (err == ESP_OK) {
+        stats_.announces++;
+        stats_.lastAnnounceMs = millis();
+    }
+}
+
+void MdnsManager::poll(uint32_t now) {
+    if (running_ || !retryPending_ || static_cast<int32_t>(now - retryAtMs_) < 0) return;
+    lock();
+    if (!running_ && retryPending_) {
+        Serial.println("Retrying mDNS responder: " + hostname_);
+        startLocked();
+    }
+    unlock();
+}
+
+void MdnsManager::registerLocked(const MdnsService& service) {
+    MDNS.addService(service.service, service.proto, service.port);
+    for (const MdnsTxtRecord& record : service.txt) {
+        MDNS.addServiceTxt(service.service, service.proto, record.key, record.value);
+    }
+}
+
+MdnsService* MdnsManager::findLocked(const String& service, const String& proto) {
+    for (MdnsService& entry : services_) {
+        if (entry.service == service && entry.proto == proto) return &entry;
+    }
+    return nullptr;
+}
+
+void MdnsManager::addService(const String& service, const String& proto, uint16_t port) {
+    lock();
+    MdnsService* entry = findLocked(service, proto);
+    if (entry) {
+        if (entry->port == port) {
+            unlock();
+            return;
+        }
+        // ポートが変わった場合は登録し直す
+        if (running_) mdns_service_remove(underscored(service).c_str(), underscored(proto).c_str());
+        entry->port = port;
+    } else {
+        MdnsService added;
+        added.service = service;
+        added.proto = proto;
+        added.port = port;
+        services_.push_back(added);
+        entry = &services_.back();
+    }
+    if (running_) registerLocked(*entry);
+    unlock();
+}
+
+void MdnsManager::removeService(const String& service, const String& proto) {
+    lock();
+    for (size_t i = 0; i < services_.size(); ++i) {
+        if (services_[i].service != service || services_[i].proto != proto) continue;
+        services_.erase(services_.begin() + i);
+        if (running_) mdns_service_remove(underscored(service).c_str(), underscored(proto).c_str());
+        break;
+    }
+    unlock();
+}
+
+void MdnsManager::setTxt(const String& service, const String& proto, const String& key, const String& value) {
+    lock();
+    MdnsService* entry = findLocked(service, proto);
+    if (!entry) {
+        // サービス登録前の TXT は捨てる
+        unlock();
+        return;
+    }
+    bool found = false;
+    for (MdnsTxtRecord& record : entry->txt) {
+        if (record.key != key) continue;
+        record.value = value;
+        found = true;
+        break;
+    }
+    if (!found) {
+        MdnsTxtRecord record;
+        record.key = key;
+        record.value = value;
+        entry->txt.push_back(record);
+    }
+    if (running_) MDNS.addServiceTxt(service, proto, key, value);
+    unlock();
+}
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_MDNS
@@ -0,0 +1,95 @@
+#ifndef SUKEN_WIFI_MDNS_H
+#define SUKEN_WIFI_MDNS_H
+
+#include <Arduino.h>
+#include <vector>
+#include "SukenWiFiConfig.h"
+
+namespace SukenWiFiLib {
+
+struct MdnsTxtRecord {
+    String key;
+    String value;
+};
+
+// アプリが登録するサービス（例: "http", "tcp", 80）。レスポンダを開始し直しても再登録される
+struct MdnsService {
+    String service;
+    String proto;
+    uint16_t port = 0;
+    std::vector<MdnsTxtRecord> txt;
+};
+
+struct MdnsStats {
+    bool running = false;
+    uint32_t starts = 0;
+    uint32_t failures = 0;          // MDNS.begin() の失敗回数（失敗後は間隔を空けて再試行）
+    uint32_t announces = 0;         // GOT_IP/IP変更での再告知
+    uint32_t lastAnnounceMs = 0;
+};
+
+#if SUKEN_WIFI_MDNS
+
+// mDNS レスポンダの管理
+// 開始は1回だけ行い、以降の GOT_IP やアドレス変更では再告知だけを行う。
+// 開始に失敗してもタスクを止めず、poll() または次の begin() で再試行する
+class MdnsManager {
+public:
+    MdnsManager();
+    ~MdnsManager();
+
+    // 未開始なら開始、同じホスト名で開始済みなら再告知する
+    bool begin(const String& hostname);
+    void announce();
+    // 失敗後の再試行（定期的に呼ぶ）
+    void poll(uint32_t now);
+    bool running() const { return running_; }
+
+    void addService(const String& service, const String& proto, uint16_t port);
+    void removeService(const String& service, const String& proto);
+    void setTxt(const String& service, const String& proto, const String& key, const String& value);
+
+    MdnsStats stats() const { return stats_; }
+
+private:
+    bool startLocked();
+    void registerLocked(const MdnsService& service);
+    MdnsService* findLocked(const String& service, const String& proto);
+    void lock();
+    void unlock();
+
+    String hostname_;
+    volatile bool running_ = false;
+    bool retryPending_ = false;
+    uint32_t retryAtMs_ = 0;
+    uint32_t retryDelayMs_ = 0;
+    std::vector<MdnsService> services_;
+    MdnsStats stats_;
+    SemaphoreHandle_t mutex_ = nullptr;
+
+    static constexpr uint32_t RETRY_MIN_MS = 2000;
+    static constexpr uint32_t RETRY_MAX_MS = 60000;
+};
+
+#else
+
+// SUKEN_WIFI_MDNS=0: ESPmDNS をリンクしない。呼び出し側はそのままで、何もしない
+class MdnsManager {
+public:
+    bool begin(const String&) { return false; }
+    void announce() {}
+    void poll(uint32_t) {}
+    bool running() const { return false; }
+
+    void addService(const String&, const String&, uint16_t) {}
+    void removeService(const String&, const String&) {}
+    void setTxt(const String&, const String&, const String&, const String&) {}
+
+    MdnsStats stats() const { return MdnsStats(); }
+};
+
+#endif // SUKEN_WIFI_MDNS
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_MDNS_H
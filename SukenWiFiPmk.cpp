@@ -0,0 +1,50 @@
+#include "SukenWiFiPmk.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+constexpr unsigned int PMK_ITERATIONS = 4096;   // IEEE 802.11i で固定
+
+} // namespace
+
+bool derivePmk(const String& ssid, const String& passphrase, uint8_t pmk[PMK_LENGTH]) {
+    if (ssid.length() == 0 || ssid.length() > 32) return false;
+    if (passphrase.length() < 8 || passphrase.length() > 63) return false;
+
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    const mbedtls_md_info_t* info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA1);
+    int ret = info ? mbedtls_md_setup(&ctx, info, 1) : -1;
+    if (ret == 0) {
+        ret = mbedtls_pkcs5_pbkdf2_hmac(&ctx,
+                                        reinterpret_cast<const unsigned char*>(passphrase.c_str()), passphrase.length(),
+                                        reinterpret_cast<const unsigned char*>(ssid.c_str()), ssid.length(),
+                                        PMK_ITERATIONS, PMK_LENGTH, pmk);
+    }
+    mbedtls_md_free(&ctx);
+    return ret == 0;
+}
+
+String pmkToHex(const uint8_t pmk[PMK_LENGTH]) {
+    static const char digits[] = "0123456789abcdef";
+    String hex;
+    hex.reserve(PMK_HEX_LENGTH);
+    for (size_t i = 0; i < PMK_LENGTH; ++i) {
+        hex += digits[pmk[i] >> 4];
+        hex += digits[pmk[i] & 0x0F];
+    }
+    return hex;
+}
+
+bool isHexPmk(const String& value) {
+    if (value.length() != PMK_HEX_LENGTH) return false;
+    for (size_t i = 0; i < value.length(); ++i) {
+        if (!isxdigit(static_cast<unsigned char>(value[i]))) return false;
+    }
+    return true;
+}
+
+} // namespace SukenWiFiLib
@@ -0,0 +1,22 @@
+#ifndef SUKEN_WIFI_PMK_H
+#define SUKEN_WIFI_PMK_H
+
+#include <Arduino.h>
+
+namespace SukenWiFiLib {
+
+// WPA/WPA2-PSK の PMK（Pairwise Master Key）
+// PMK = PBKDF2-HMAC-SHA1(passphrase, ssid, 4096回, 32バイト)。接続のたびに計算すると数百msかかるため、
+// 保存時に一度だけ計算して 64桁の16進で保持し、WiFi.begin() にはそのまま渡す（64文字は PSK として扱われる）
+constexpr size_t PMK_LENGTH = 32;
+constexpr size_t PMK_HEX_LENGTH = PMK_LENGTH * 2;
+
+// passphrase は 8〜63文字、ssid は 1〜32バイト。範囲外や計算失敗なら false
+bool derivePmk(const String& ssid, const String& passphrase, uint8_t pmk[PMK_LENGTH]);
+String pmkToHex(const uint8_t pmk[PMK_LENGTH]);
+// 64桁の16進（既に PMK/PSK の形式）か
+bool isHexPmk(const String& value);
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_PMK_H
@@ -0,0 +1,201 @@
+#include "SukenWiFiProvisioning.h"
+#include "esp_wifi.h"
+#include "esp_smartconfig.h"
+#include "esp_wps.h"
+#if SUKEN_WIFI_ENABLE_BLE_PROV
+#include <wifi_provisioning/manager.h>
+#include <wifi_provisioning/scheme_ble.h>
+#endif
+
+namespace SukenWiFiLib {
+
+// ---- EventDrivenTransport ----
+
+void EventDrivenTransport::listen() {
+    if (listening_) return;
+    eventId_ = WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+        handleEvent(event, info);
+    });
+    listening_ = true;
+}
+
+void EventDrivenTransport::unlisten() {
+    if (!listening_) return;
+    WiFi.removeEvent(eventId_);
+    listening_ = false;
+    received_ = false;
+}
+
+void EventDrivenTransport::setReceived(const uint8_t* ssid, size_t ssidLen, const uint8_t* password, size_t passwordLen) {
+    // 固定長フィールドは終端されていないことがある
+    size_t n = strnlen(reinterpret_cast<const char*>(ssid), ssidLen < 32 ? ssidLen : 32);
+    memcpy(ssid_, ssid, n);
+    ssid_[n] = '\0';
+    n = strnlen(reinterpret_cast<const char*>(password), passwordLen < 64 ? passwordLen : 64);
+    memcpy(password_, password, n);
+    password_[n] = '\0';
+    received_ = true;
+}
+
+void EventDrivenTransport::poll() {
+    if (!received_) return;
+    received_ = false;
+    Serial.println(String("[") + name() + "] Credentials received for SSID: " + ssid_);
+    deliver(String(ssid_), String(password_));
+}
+
+// ---- SmartConfigTransport ----
+
+bool SmartConfigTransport::start() {
+    if (active_) return true;
+    listen();
+    // WiFi.beginSmartConfig() は STA モードへ切り替えてAPを止めるため、IDF を直接使う
+    esp_smartconfig_set_type(SC_TYPE_ESPTOUCH);
+    smartconfig_start_config_t config = SMARTCONFIG_START_CONFIG_DEFAULT();
+    if (esp_smartconfig_start(&config) != ESP_OK) {
+        Serial.println("[SmartConfig] Failed to start");
+        unlisten();
+        return false;
+    }
+    active_ = true;
+    Serial.println("[SmartConfig] Waiting for ESP-Touch");
+    return true;
+}
+
+void SmartConfigTransport::stop() {
+    if (!active_) return;
+    esp_smartconfig_stop();
+    unlisten();
+    active_ = false;
+}
+
+void SmartConfigTransport::handleEvent(arduino_event_id_t event, arduino_event_info_t& info) {
+    if (event == ARDUINO_EVENT_SC_GOT_SSID_PSWD) {
+        // Arduino コアもここで接続を始めるが、ライブラリが止めて固定IPなどを反映してから接続し直す
+        setReceived(info.sc_got_ssid_pswd.ssid, sizeof(info.sc_got_ssid_pswd.ssid),
+                    info.sc_got_ssid_pswd.password, sizeof(info.sc_got_ssid_pswd.password));
+    }
+}
+
+// ---- WpsTransport ----
+
+bool WpsTransport::enable() {
+    esp_wps_config_t config = WPS_CONFIG_INIT_DEFAULT(WPS_TYPE_PBC);
+    if (esp_wifi_wps_enable(&config) != ESP_OK) return false;
+    if (esp_wifi_wps_start(0) != ESP_OK) {
+        esp_wifi_wps_disable();
+        return false;
+    }
+    return true;
+}
+
+bool WpsTransport::start() {
+    if (active_) return true;
+    listen();
+    if (!enable()) {
+        Serial.println("[WPS] Failed to start");
+        unlisten();
+        return false;
+    }
+    succeeded_ = false;
+    restartPending_ = false;
+    active_ = true;
+    Serial.println("[WPS] Waiting for push button");
+    return true;
+}
+
+void WpsTransport::stop() {
+    if (!active_) return;
+    esp_wifi_wps_disable();
+    unlisten();
+    active_ = false;
+}
+
+void WpsTransport::handleEvent(arduino_event_id_t event, arduino_event_info_t& info) {
+    (void)info;
+    if (event == ARDUINO_EVENT_WPS_ER_SUCCESS) {
+        succeeded_ = true;
+    } else if (event == ARDUINO_EVENT_WPS_ER_FAILED || event == ARDUINO_EVENT_WPS_ER_TIMEOUT) {
+        // ボタンの受付時間切れ。セットアップモード中は待ち続ける
+        restartPending_ = true;
+    }
+}
+
+void WpsTransport::poll() {
+    if (!active_) return;
+    if (restartPending_) {
+        restartPending_ = false;
+        esp_wifi_wps_disable();
+        if (!enable()) {
+            Serial.println("[WPS] Failed to restart");
+            unlisten();
+            active_ = false;
+            return;
+        }
+    }
+    if (succeeded_) {
+        succeeded_ = false;
+        // 受け取った認証情報は STA の設定に書き込まれている
+        esp_wifi_wps_disable();
+        // unlisten() は未処理の値を捨てるので、読み出しより先に行う
+        unlisten();
+        active_ = false;
+        wifi_config_t conf;
+        if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK) {
+            setReceived(conf.sta.ssid, sizeof(conf.sta.ssid), conf.sta.password, sizeof(conf.sta.password));
+        }
+        EventDrivenTransport::poll();
+        return;
+    }
+    EventDrivenTransport::poll();
+}
+
+// ---- BleProvisioningTransport ----
+
+#if SUKEN_WIFI_ENABLE_BLE_PROV
+bool BleProvisioningTransport::start() {
+    if (active_) return true;
+    listen();
+    wifi_prov_mgr_config_t config = {};
+    config.scheme = wifi_prov_scheme_ble;
+    config.scheme_event_handler = WIFI_PROV_SCHEME_BLE_EVENT_HANDLER_FREE_BTDM;
+    if (wifi_prov_mgr_init(config) != ESP_OK) {
+        Serial.println("[BLE] Failed to init provisioning manager");
+        unlisten();
+        return false;
+    }
+    String service = serviceName_;
+    if (service.length() == 0) {
+        String mac = WiFi.macAddress();
+        mac.replace(":", "");
+        service = "PROV_" + mac.substring(6);
+    }
+    if (wifi_prov_mgr_start_provisioning(WIFI_PROV_SECURITY_1, pop_.c_str(), service.c_str(), nullptr) != ESP_OK) {
+        Serial.println("[BLE] Failed to start provisioning");
+        wifi_prov_mgr_deinit();
+        unlisten();
+        return false;
+    }
+    active_ = true;
+    Serial.println("[BLE] Advertising as " + service);
+    return true;
+}
+
+void BleProvisioningTransport::stop() {
+    if (!active_) return;
+    wifi_prov_mgr_stop_provisioning();
+    wifi_prov_mgr_deinit();
+    unlisten();
+    active_ = false;
+}
+
+void BleProvisioningTransport::handleEvent(arduino_event_id_t event, arduino_event_info_t& info) {
+    if (event == ARDUINO_EVENT_PROV_CRED_RECV) {
+        // プロビジョニングマネージャもここで接続を始めるが、ライブラリが止めて接続し直す
+        setReceived(info.prov_cred_recv.ssid, sizeof(info.prov_cred_recv.ssid),
+                    info.prov_cred_recv.password, sizeof(info.prov_cred_recv.password));
+    }
+}
+#endif
+
+} // namespace SukenWiFiLib
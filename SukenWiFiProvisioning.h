@@ -0,0 +1,135 @@
+#ifndef SUKEN_WIFI_PROVISIONING_H
+#define SUKEN_WIFI_PROVISIONING_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+
+// BLE プロビジョニングは Bluetooth スタックを含むためフラッシュ使用量が大きい。
+// 使う場合はビルドフラグで -DSUKEN_WIFI_ENABLE_BLE_PROV=1 を指定する
+#ifndef SUKEN_WIFI_ENABLE_BLE_PROV
+#define SUKEN_WIFI_ENABLE_BLE_PROV 0
+#endif
+
+namespace SukenWiFiLib {
+
+// セットアップモード中に認証情報を受け取る手段
+// Webポータルのほか、SmartConfig、WPS、BLE を同時に動かし、最初に届いたものを採用する
+class ProvisioningTransport {
+public:
+    // 受け取った SSID/パスワードの渡し先（ライブラリが保存と接続を行う）
+    using CredentialsHandler = std::function<void(ProvisioningTransport& source, const String& ssid, const String& password)>;
+
+    virtual ~ProvisioningTransport() {}
+
+    virtual const char* name() const = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+    // ポータルのループ（協調モードでは SukenWiFi.loop()）から呼ばれる。イベントで受け取った値はここで渡す
+    virtual void poll() {}
+
+    void setHandler(CredentialsHandler handler) { handler_ = handler; }
+
+protected:
+    void deliver(const String& ssid, const String& password) {
+        if (handler_) handler_(*this, ssid, password);
+    }
+
+private:
+    CredentialsHandler handler_;
+};
+
+// 既存の soft-AP Webポータル（開始/停止はライブラリ側の処理を呼ぶ）
+// 認証情報は /api/WiFiSetting から直接保存されるため deliver() は使わない
+class WebPortalTransport : public ProvisioningTransport {
+public:
+    WebPortalTransport(std::function<void()> startFn, std::function<void()> stopFn, std::function<bool()> activeFn)
+        : startFn_(startFn), stopFn_(stopFn), activeFn_(activeFn) {}
+
+    const char* name() const override { return "WebPortal"; }
+    bool start() override { startFn_(); return true; }
+    void stop() override { stopFn_(); }
+    bool isActive() const override { return activeFn_(); }
+
+private:
+    std::function<void()> startFn_;
+    std::function<void()> stopFn_;
+    std::function<bool()> activeFn_;
+};
+
+// イベントタスクで受け取った認証情報を poll() まで保持する共通部分
+class EventDrivenTransport : public ProvisioningTransport {
+public:
+    bool isActive() const override { return active_; }
+    void poll() override;
+
+protected:
+    void listen();
+    void unlisten();
+    void setReceived(const uint8_t* ssid, size_t ssidLen, const uint8_t* password, size_t passwordLen);
+    virtual void handleEvent(arduino_event_id_t event, arduino_event_info_t& info) = 0;
+
+    bool active_ = false;
+
+private:
+    wifi_event_id_t eventId_ = 0;
+    bool listening_ = false;
+    volatile bool received_ = false;
+    char ssid_[33] = {0};
+    char password_[65] = {0};
+};
+
+// ESP-Touch（SmartConfig）。スマートフォンアプリから認証情報を送る
+// 受信のため無線がチャネルを巡回している間はAPへの通信が途切れることがある
+class SmartConfigTransport : public EventDrivenTransport {
+public:
+    const char* name() const override { return "SmartConfig"; }
+    bool start() override;
+    void stop() override;
+
+protected:
+    void handleEvent(arduino_event_id_t event, arduino_event_info_t& info) override;
+};
+
+// WPS プッシュボタン方式。ルーターのWPSボタンを押すと認証情報を受け取る
+class WpsTransport : public EventDrivenTransport {
+public:
+    const char* name() const override { return "WPS"; }
+    bool start() override;
+    void stop() override;
+    void poll() override;
+
+protected:
+    void handleEvent(arduino_event_id_t event, arduino_event_info_t& info) override;
+
+private:
+    bool enable();
+    volatile bool succeeded_ = false;
+    volatile bool restartPending_ = false;
+};
+
+#if SUKEN_WIFI_ENABLE_BLE_PROV
+// BLE GATT（ESP-IDF wifi_provisioning）。ESP BLE Provisioning アプリから設定する
+class BleProvisioningTransport : public EventDrivenTransport {
+public:
+    // pop: 所有証明（Proof of Possession）。serviceName は省略時 "PROV_<MACアドレス下位6桁>"
+    BleProvisioningTransport(const String& pop, const String& serviceName = "")
+        : pop_(pop), serviceName_(serviceName) {}
+
+    const char* name() const override { return "BLE"; }
+    bool start() override;
+    void stop() override;
+
+protected:
+    void handleEvent(arduino_event_id_t event, arduino_event_info_t& info) override;
+
+private:
+    String pop_;
+    String serviceName_;
+};
+#endif
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_PROVISIONING_H
@@ -0,0 +1,163 @@
+#include "SukenWiFiQueue.h"
+
+namespace SukenWiFiLib {
+
+OfflineQueue::OfflineQueue() {
+    mutex_ = xSemaphoreCreateMutex();
+}
+
+OfflineQueue::~OfflineQueue() {
+    if (mutex_) vSemaphoreDelete(mutex_);
+}
+
+void OfflineQueue::lock() {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+}
+
+void OfflineQueue::unlock() {
+    xSemaphoreGive(mutex_);
+}
+
+void OfflineQueue::configure(const OfflineQueueConfig& config, ConfigStore* store) {
+    lock();
+    config_ = config;
+    if (config_.capacity == 0) config_.capacity = 1;
+    if (config_.batchSize == 0) config_.batchSize = 1;
+    if (config_.persistBatchSize == 0) config_.persistBatchSize = 1;
+    store_ = store;
+    buffer_.assign(config_.capacity, String());
+    head_ = 0;
+    count_ = 0;
+    unsaved_ = 0;
+    unlock();
+}
+
+bool OfflineQueue::pushLocked(const String& payload) {
+    if (buffer_.empty()) return false;
+    if (count_ == buffer_.size()) {
+        stats_.dropped++;
+        if (config_.dropPolicy == QueueDropPolicy::DropNewest) {
+            return false;
+        }
+        head_ = (head_ + 1) % buffer_.size();
+        count_--;
+    }
+    buffer_[(head_ + count_) % buffer_.size()] = payload;
+    count_++;
+    stats_.queued++;
+    return true;
+}
+
+bool OfflineQueue::push(const String& payload, bool persist) {
+    lock();
+    bool accepted = pushLocked(payload);
+    bool track = accepted && persist && config_.persistToFlash && store_;
+    if (track) {
+        if (unsaved_ == 0) firstUnsavedMs_ = millis();
+        if (unsaved_ < count_) unsaved_++;
+    }
+    unlock();
+    if (track) persistPending(millis(), false);
+    return accepted;
+}
+
+void OfflineQueue::persistPending(uint32_t now, bool force) {
+    if (!config_.persistToFlash || !store_) return;
+    lock();
+    bool due = unsaved_ > 0 &&
+               (force || unsaved_ >= config_.persistBatchSize || now - firstUnsavedMs_ >= config_.persistIntervalMs);
+    if (!due) {
+        unlock();
+        return;
+    }
+    // 長さ付きで1件ずつ（ペイロード内の改行もそのまま保持できる）。まとめて1回で追記する
+    String content;
+    for (size_t i = count_ - unsaved_; i < count_; ++i) {
+        const String& payload = buffer_[(head_ + i) % buffer_.size()];
+        content += String(payload.length()) + ":" + payload + "\n";
+    }
+    // 書き終えるまでロックを持つ（途中の push()/pop() で未保存の範囲がずれないように）。
+    // 書けなかった分は未保存のまま残し、次の呼び出しで書き直す
+    if (store_->appendRaw(FLASH_PATH, content)) {
+        unsaved_ = 0;
+        stats_.flashWrites++;
+    }
+    unlock();
+}
+
+bool OfflineQueue::peek(String& payload) {
+    lock();
+    bool available = count_ > 0;
+    if (available) payload = buffer_[head_];
+    unlock();
+    return available;
+}
+
+void OfflineQueue::pop() {
+    lock();
+    if (count_ > 0) {
+        buffer_[head_] = String();
+        head_ = (head_ + 1) % buffer_.size();
+        count_--;
+        if (unsaved_ > count_) unsaved_ = count_;
+    }
+    unlock();
+}
+
+size_t OfflineQueue::size() {
+    lock();
+    size_t n = count_;
+    unlock();
+    return n;
+}
+
+OfflineQueueStats OfflineQueue::stats() {
+    lock();
+    stats_.pending = count_;
+    stats_.unsaved = unsaved_;
+    OfflineQueueStats copy = stats_;
+    unlock();
+    return copy;
+}
+
+void OfflineQueue::syncFlash() {
+    if (!config_.persistToFlash || !store_) return;
+    lock();
+    // 全体を書き直すので、まとめ書き待ちの分もここで保存される
+    unsaved_ = 0;
+    if (count_ == 0) {
+        unlock();
+        if (store_->exists(FLASH_PATH)) store_->remove(FLASH_PATH);
+        return;
+    }
+    String content;
+    for (size_t i = 0; i < count_; ++i) {
+        const String& payload = buffer_[(head_ + i) % buffer_.size()];
+        content += String(payload.length()) + ":" + payload + "\n";
+    }
+    stats_.flashWrites++;
+    unlock();
+    store_->write(FLASH_PATH, content);
+}
+
+void OfflineQueue::loadFlash() {
+    if (!config_.persistToFlash || !store_) return;
+    String content;
+    if (!store_->exists(FLASH_PATH) || !store_->read(FLASH_PATH, content)) return;
+    lock();
+    int pos = 0;
+    int length = content.length();
+    while (pos < length) {
+        int colon = content.indexOf(':', pos);
+        if (colon < 0) break;
+        int payloadLength = content.substring(pos, colon).toInt();
+        int payloadEnd = colon + 1 + payloadLength;
+        if (payloadLength < 0 || payloadEnd > length) break;
+        pushLocked(content.substring(colon + 1, payloadEnd));
+        pos = payloadEnd + 1;
+    }
+    unlock();
+    Serial.println("Offline queue restored: " + String(size()) + " items");
+}
+
+} // namespace SukenWiFiLib
@@ -0,0 +1,85 @@
+#ifndef SUKEN_WIFI_QUEUE_H
+#define SUKEN_WIFI_QUEUE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "SukenWiFiStore.h"
+
+namespace SukenWiFiLib {
+
+// 満杯時にどちらを捨てるか
+enum class QueueDropPolicy : uint8_t {
+    DropOldest = 0,  // 古いデータを捨てて新しいデータを入れる
+    DropNewest       // 新しいデータを受け付けない
+};
+
+struct OfflineQueueConfig {
+    size_t capacity = 32;
+    QueueDropPolicy dropPolicy = QueueDropPolicy::DropOldest;
+    uint8_t batchSize = 8;            // 1バッチで送信する件数
+    uint32_t batchIntervalMs = 200;   // バッチ間の待ち時間（レート制限）
+    bool persistToFlash = false;      // 未送信データを SPIFFS に保存して再起動後も保持
+    // 切断中に積んだデータはまとめて追記する（1件ごとにフラッシュへ書かない）
+    // 件数か経過時間のどちらかに達したら書く。それまでの分は電源断で失われうる
+    uint8_t persistBatchSize = 8;
+    uint32_t persistIntervalMs = 60000;
+};
+
+struct OfflineQueueStats {
+    uint32_t queued = 0;
+    uint32_t flushed = 0;
+    uint32_t dropped = 0;
+    uint32_t sendFailures = 0;
+    uint32_t flashWrites = 0;         // 未送信データをフラッシュへ書いた回数
+    size_t pending = 0;
+    size_t unsaved = 0;               // フラッシュにまだ書いていない件数
+};
+
+// 送信関数。true を返すと送信済みとしてキューから取り除く
+using QueueSender = std::function<bool(const String& payload)>;
+
+// 切断中のアプリケーション送信を溜めておく固定長リングバッファ
+class OfflineQueue {
+public:
+    OfflineQueue();
+    ~OfflineQueue();
+
+    void configure(const OfflineQueueConfig& config, ConfigStore* store);
+    const OfflineQueueConfig& config() const { return config_; }
+
+    bool push(const String& payload, bool persist);
+    bool peek(String& payload);
+    void pop();
+    size_t size();
+    OfflineQueueStats stats();
+
+    void countFlushed() { stats_.flushed++; }
+    void countSendFailure() { stats_.sendFailures++; }
+
+    // まとめ書きの条件（件数/経過時間）を満たしていれば未保存分を追記する。force なら条件を見ない
+    void persistPending(uint32_t now, bool force);
+    // フラッシュ上のコピーを現在の内容に合わせる
+    void syncFlash();
+    void loadFlash();
+
+private:
+    bool pushLocked(const String& payload);
+    void lock();
+    void unlock();
+
+    OfflineQueueConfig config_;
+    ConfigStore* store_ = nullptr;
+    std::vector<String> buffer_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t unsaved_ = 0;              // 末尾から unsaved_ 件がフラッシュ未保存
+    uint32_t firstUnsavedMs_ = 0;
+    OfflineQueueStats stats_;
+    SemaphoreHandle_t mutex_ = nullptr;
+
+    static constexpr const char* FLASH_PATH = "/offline_queue.txt";
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_QUEUE_H
@@ -0,0 +1,139 @@
+#include "SukenWiFiRateLimit.h"
+
+namespace SukenWiFiLib {
+
+namespace {
+
+constexpr uint32_t MILLI_TOKENS = 1000;
+
+} // namespace
+
+void RateLimiter::configure(const RateLimitConfig& config) {
+    config_ = config;
+    resetClients();
+}
+
+void RateLimiter::resetClients() {
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+        clients_[i] = ClientEntry();
+    }
+}
+
+void RateLimiter::ruleFor(RouteClass route, uint16_t& burst, uint16_t& perMinute) const {
+    switch (route) {
+        case RouteClass::Page:
+            burst = config_.pageBurst;
+            perMinute = config_.pagePerMinute;
+            break;
+        case RouteClass::Api:
+            burst = config_.apiBurst;
+            perMinute = config_.apiPerMinute;
+            break;
+        default:
+            burst = config_.applyBurst;
+            perMinute = config_.applyPerMinute;
+            break;
+    }
+}
+
+RateLimiter::ClientEntry* RateLimiter::findOrInsert(uint32_t ip, uint32_t now) {
+    ClientEntry* oldest = nullptr;
+    ClientEntry* empty = nullptr;
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+        ClientEntry& entry = clients_[i];
+        if (!entry.used) {
+            if (!empty) empty = &entry;
+            continue;
+        }
+        if (entry.ip == ip) return &entry;
+        if (!oldest || static_cast<int32_t>(entry.lastMs - oldest->lastMs) < 0) oldest = &entry;
+    }
+    ClientEntry* slot = empty;
+    if (!slot) {
+        slot = oldest;
+        stats_.evictions++;
+    }
+    *slot = ClientEntry();
+    slot->used = true;
+    slot->ip = ip;
+    slot->lastMs = now;
+    // 新しいクライアントは満杯のバケットから始める
+    for (size_t route = 0; route < static_cast<size_t>(RouteClass::Count); ++route) {
+        uint16_t burst = 0;
+        uint16_t perMinute = 0;
+        ruleFor(static_cast<RouteClass>(route), burst, perMinute);
+        slot->tokens[route] = burst * MILLI_TOKENS;
+    }
+    return slot;
+}
+
+void RateLimiter::refill(ClientEntry& entry, uint32_t now) {
+    uint32_t elapsed = now - entry.lastMs;
+    entry.lastMs = now;
+    if (elapsed == 0) return;
+    for (size_t route = 0; route < static_cast<size_t>(RouteClass::Count); ++route) {
+        uint16_t burst = 0;
+        uint16_t perMinute = 0;
+        ruleFor(static_cast<RouteClass>(route), burst, perMinute);
+        uint32_t capacity = burst * MILLI_TOKENS;
+        // perMinute トークン/分 = perMinute/60 ミリトークン/ms
+        uint64_t tokens = entry.tokens[route] + static_cast<uint64_t>(elapsed) * perMinute / 60;
+        entry.tokens[route] = tokens > capacity ? capacity : static_cast<uint32_t>(tokens);
+    }
+}
+
+bool RateLimiter::allow(uint32_t ip, RouteClass route, uint32_t now, uint32_t& retryAfterSec) {
+    retryAfterSec = 0;
+    uint16_t burst = 0;
+    uint16_t perMinute = 0;
+    ruleFor(route, burst, perMinute);
+    if (!config_.enabled || burst == 0) {
+        stats_.allowed++;
+        return true;
+    }
+    ClientEntry* entry = findOrInsert(ip, now);
+    refill(*entry, now);
+    uint32_t& tokens = entry->tokens[static_cast<size_t>(route)];
+    if (tokens >= MILLI_TOKENS) {
+        tokens -= MILLI_TOKENS;
+        stats_.allowed++;
+        return true;
+    }
+    if (perMinute == 0) {
+        // 補充しない設定（burst 回で打ち止め）。ポータルを開き直すまで待たせる
+        retryAfterSec = 60;
+    } else {
+        uint32_t waitMs = (MILLI_TOKENS - tokens) * 60 / perMinute;
+        retryAfterSec = (waitMs + 999) / 1000;
+        if (retryAfterSec == 0) retryAfterSec = 1;
+    }
+    switch (route) {
+        case RouteClass::Page: stats_.rejectedPage++; break;
+        case RouteClass::Api: stats_.rejectedApi++; break;
+        default: stats_.rejectedApply++; break;
+    }
+    return false;
+}
+
+bool RateLimiter::tryBeginApply() {
+    if (__atomic_exchange_n(&applying_, true, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&stats_.rejectedBusy, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+void RateLimiter::endApply() {
+    __atomic_store_n(&applying_, false, __ATOMIC_RELEASE);
+}
+
+RateLimitStats RateLimiter::stats() const {
+    RateLimitStats stats = stats_;
+    stats.trackedClients = 0;
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+        if (clients_[i].used) stats.trackedClients++;
+    }
+    return stats;
+}
+
+} // namespace SukenWiFiLib
@@ -0,0 +1,92 @@
+#ifndef SUKEN_WIFI_RATE_LIMIT_H
+#define SUKEN_WIFI_RATE_LIMIT_H
+
+#include <Arduino.h>
+
+namespace SukenWiFiLib {
+
+// ポータルのルートの分類（分類ごとに別のバケットを持つ）
+enum class RouteClass : uint8_t {
+    Page = 0,   // "/"、"/WiFiSetting"、キャプティブポータルの判定（未定義のパス）
+    Api,        // /api/info、/api/WiFiList、/api/schema、/api/events
+    Apply,      // /api/WiFiSetting（保存して接続を試すので数秒かかる）
+    Count
+};
+
+// burst: 連続で受け付ける数、perMinute: 1分あたりの補充数。burst を 0 にするとその分類は制限しない
+struct RateLimitConfig {
+    bool enabled = true;
+    uint16_t pageBurst = 20;
+    uint16_t pagePerMinute = 120;
+    uint16_t apiBurst = 20;
+    uint16_t apiPerMinute = 240;      // WiFiList の差分取得（数秒ごと）を複数タブで開いても足りる量
+    uint16_t applyBurst = 2;
+    uint16_t applyPerMinute = 6;
+};
+
+struct RateLimitStats {
+    uint32_t allowed = 0;
+    uint32_t rejectedPage = 0;
+    uint32_t rejectedApi = 0;
+    uint32_t rejectedApply = 0;
+    uint32_t rejectedBusy = 0;       // 別の設定を適用中だった（429）
+    uint32_t evictions = 0;          // 表が一杯で、最も古いクライアントを追い出した
+    uint8_t trackedClients = 0;
+};
+
+// クライアントIPごとのトークンバケット
+// 表は固定長（ソフトAPの最大接続数）。ポータルのタスクからだけ呼ぶ（適用中のロックを除く）
+class RateLimiter {
+public:
+    // setSoftAPConfig() の maxClients の上限と同じ
+    static constexpr size_t MAX_CLIENTS = 10;
+
+    void configure(const RateLimitConfig& config);
+    const RateLimitConfig& config() const { return config_; }
+    // ポータルの開始時に表を空にする（統計は残す）
+    void resetClients();
+
+    // 受け付けるなら true。拒否した場合は retryAfterSec に次に受け付けるまでの秒数を入れる
+    bool allow(uint32_t ip, RouteClass route, uint32_t now, uint32_t& retryAfterSec);
+
+    // 設定の適用は同時に1つだけ（ポータル、シリアル、applyConfig() で共通）。どのタスクからでもよい
+    bool tryBeginApply();
+    void endApply();
+    bool applying() const { return __atomic_load_n(&applying_, __ATOMIC_ACQUIRE); }
+
+    RateLimitStats stats() const;
+
+private:
+    struct ClientEntry {
+        uint32_t ip = 0;
+        uint32_t lastMs = 0;
+        uint32_t tokens[static_cast<size_t>(RouteClass::Count)] = {};   // 1/1000 トークン単位
+        bool used = false;
+    };
+
+    ClientEntry* findOrInsert(uint32_t ip, uint32_t now);
+    void refill(ClientEntry& entry, uint32_t now);
+    void ruleFor(RouteClass route, uint16_t& burst, uint16_t& perMinute) const;
+
+    RateLimitConfig config_;
+    ClientEntry clients_[MAX_CLIENTS];
+    RateLimitStats stats_;
+    bool applying_ = false;
+};
+
+// スコープの間だけ適用中のロックを持つ
+class ApplySlot {
+public:
+    explicit ApplySlot(RateLimiter& limiter) : limiter_(limiter), acquired_(limiter.tryBeginApply()) {}
+    ~ApplySlot() { if (acquired_) limiter_.endApply(); }
+
+    bool acquired() const { return acquired_; }
+
+private:
+    RateLimiter& limiter_;
+    bool acquired_;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_RATE_LIMIT_H
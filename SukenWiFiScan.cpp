@@ -0,0 +1,181 @@
+#include "SukenWiFiScan.h"
+#include <WiFi.h>
+
+namespace SukenWiFiLib {
+
+ScanEntry* ScanTable::find(const String& ssid) {
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        if (entries_[i].ssid[0] != 0 && strcmp(entries_[i].ssid, ssid.c_str()) == 0) return &entries_[i];
+    }
+    return nullptr;
+}
+
+ScanEntry* ScanTable::allocate() {
+    ScanEntry* oldest = nullptr;
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        if (entries_[i].ssid[0] == 0) return &entries_[i];
+        if (!entries_[i].live && (oldest == nullptr || entries_[i].changedVersion < oldest->changedVersion)) {
+            oldest = &entries_[i];
+        }
+    }
+    if (oldest == nullptr) return nullptr; // 表示中のネットワークで満杯
+    // 削除済みエントリを再利用すると、それ以前のバージョンからの差分は作れなくなる
+    if (oldest->changedVersion > horizon_) horizon_ = oldest->changedVersion;
+    *oldest = ScanEntry();
+    return oldest;
+}
+
+bool ScanTable::update(int numNetworks) {
+    bool seen[MAX_ENTRIES] = {false};
+    int8_t rssi[MAX_ENTRIES];
+    uint8_t channel[MAX_ENTRIES];
+    bool secure[MAX_ENTRIES];
+
+    for (int i = 0; i < numNetworks; ++i) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) continue; // ステルスSSIDは一覧に出さない
+        ScanEntry* entry = find(ssid);
+        if (entry == nullptr) {
+            entry = allocate();
+            if (entry == nullptr) continue;
+            strncpy(entry->ssid, ssid.c_str(), sizeof(entry->ssid) - 1);
+        }
+        size_t idx = entry - entries_;
+        int8_t r = static_cast<int8_t>(WiFi.RSSI(i));
+        if (seen[idx] && r <= rssi[idx]) continue;
+        seen[idx] = true;
+        rssi[idx] = r;
+        channel[idx] = static_cast<uint8_t>(WiFi.channel(i));
+        secure[idx] = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+    }
+
+    uint32_t next = version_ + 1;
+    bool changed = false;
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        ScanEntry& e = entries_[i];
+        if (e.ssid[0] == 0) continue;
+        if (seen[i]) {
+            if (!e.live) {
+                e.live = true;
+                e.addedVersion = next;
+                e.changedVersion = next;
+                e.reportedRssi = rssi[i];
+                changed = true;
+            } else if (abs(rssi[i] - e.reportedRssi) >= RSSI_CHANGE_DB ||
+                       channel[i] != e.channel || secure[i] != e.secure) {
+                e.changedVersion = next;
+                e.reportedRssi = rssi[i];
+                changed = true;
+            }
+            e.rssi = rssi[i];
+            e.channel = channel[i];
+            e.secure = secure[i];
+        } else if (e.live) {
+            e.live = false;
+            e.changedVersion = next;
+            changed = true;
+        }
+    }
+    if (changed) version_ = next;
+    return changed;
+}
+
+size_t ScanTable::size() const {
+    size_t n = 0;
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        if (entries_[i].live) n++;
+    }
+    return n;
+}
+
+void ScanTable::entryToJson(const ScanEntry& entry, JsonObject obj) {
+    obj["ssid"] = entry.ssid;
+    obj["rssi"] = entry.rssi;
+    obj["ch"] = entry.channel;
+    obj["secure"] = entry.secure;
+}
+
+bool ScanTable::toJson(uint32_t since, JsonDocument& doc) const {
+    if (since != 0 && since == version_) return false;
+    doc["version"] = version_;
+
+    if (since == 0 || since > version_ || since < horizon_) {
+        // 全体（旧形式との互換のため networks は SSID の配列のまま、電波の強い順）
+        doc["full"] = true;
+        size_t order[MAX_ENTRIES];
+        size_t count = 0;
+        for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+            if (!entries_[i].live) continue;
+            size_t pos = count++;
+            while (pos > 0 && entries_[order[pos - 1]].rssi < entries_[i].rssi) {
+                order[pos] = order[pos - 1];
+                pos--;
+            }
+            order[pos] = i;
+        }
+        JsonArray networks = doc.createNestedArray("networks");
+        JsonArray details = doc.createNestedArray("entries");
+        for (size_t k = 0; k < count; ++k) {
+            networks.add(entries_[order[k]].ssid);
+            entryToJson(entries_[order[k]], details.createNestedObject());
+        }
+        return true;
+    }
+
+    doc["full"] = false;
+    JsonArray added = doc.createNestedArray("added");
+    JsonArray changed = doc.createNestedArray("changed");
+    JsonArray removed = doc.createNestedArray("removed");
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        const ScanEntry& e = entries_[i];
+        if (e.ssid[0] == 0 || e.changedVersion <= since) continue;
+        if (e.live) {
+            entryToJson(e, (e.addedVersion > since ? added : changed).createNestedObject());
+        } else if (e.addedVersion <= since) {
+            // クライアントが一度も見ていないネットワークの削除は送らない
+            removed.add(e.ssid);
+        }
+    }
+    return true;
+}
+
+const ScanEntry* ScanTable::lookup(const String& ssid) const {
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        if (entries_[i].live && strcmp(entries_[i].ssid, ssid.c_str()) == 0) return &entries_[i];
+    }
+    return nullptr;
+}
+
+uint8_t ScanTable::leastCongestedChannel() const {
+    static const uint8_t candidates[] = {1, 6, 11};
+    uint8_t best = candidates[0];
+    int32_t bestScore = INT32_MAX;
+    for (uint8_t c : candidates) {
+        int32_t score = 0;
+        for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+            const ScanEntry& e = entries_[i];
+            if (!e.live || e.channel == 0) continue;
+            int distance = abs(static_cast<int>(e.channel) - c);
+            if (distance > 4) continue; // 5チャネル以上離れていれば重ならない
+            // 強い電波ほど、近いチャネルほど重く数える
+            int strength = e.rssi + 100;
+            if (strength < 1) strength = 1;
+            score += strength * (5 - distance);
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            best = c;
+        }
+    }
+    return best;
+}
+
+void ScanTable::rssiToJson(JsonDocument& doc) const {
+    doc["v"] = version_;
+    JsonObject rssi = doc.createNestedObject("rssi");
+    for (size_t i = 0; i < MAX_ENTRIES; ++i) {
+        if (entries_[i].live) rssi[entries_[i].ssid] = entries_[i].rssi;
+    }
+}
+
+} // namespace SukenWiFiLib
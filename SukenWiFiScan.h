@@ -0,0 +1,58 @@
+#ifndef SUKEN_WIFI_SCAN_H
+#define SUKEN_WIFI_SCAN_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+namespace SukenWiFiLib {
+
+// スキャン結果の1ネットワーク（SSID単位。同一SSIDの複数BSSIDは最も強いものを採用）
+struct ScanEntry {
+    char ssid[33] = {0};         // ポータル終了後も残るため String（ヒープ）にしない
+    int8_t rssi = 0;             // 最新のRSSI（SSEで配信）
+    int8_t reportedRssi = 0;     // 差分APIで最後に「変更」として扱ったRSSI
+    uint8_t channel = 0;
+    bool secure = false;
+    bool live = false;           // false なら削除済み（差分用に残している）
+    uint32_t addedVersion = 0;
+    uint32_t changedVersion = 0;
+};
+
+// バージョン付きスキャン結果
+// クライアントが最後に見たバージョンを送ると、追加/変更/削除されたネットワークだけを返す
+class ScanTable {
+public:
+    // WiFi.scanNetworks() の結果を取り込む。内容が変わればバージョンを進めて true
+    bool update(int numNetworks);
+
+    uint32_t version() const { return version_; }
+    size_t size() const;
+
+    // since と同じバージョンなら false（304）。それ以外は doc に全体または差分を書く
+    bool toJson(uint32_t since, JsonDocument& doc) const;
+    // SSE用：全ネットワークの現在のRSSI
+    void rssiToJson(JsonDocument& doc) const;
+
+    // 表示中のネットワークを検索（なければ nullptr）
+    const ScanEntry* lookup(const String& ssid) const;
+    // 1/6/11 のうち、周囲のネットワーク（重なるチャネルを含む、強いほど重い）が最も少ないチャネル
+    uint8_t leastCongestedChannel() const;
+
+    static constexpr size_t MAX_ENTRIES = 32;
+    // この幅未満のRSSI変動は差分APIでは「変更」にしない（SSEでは配信する）
+    static constexpr int RSSI_CHANGE_DB = 6;
+
+private:
+    ScanEntry* find(const String& ssid);
+    ScanEntry* allocate();
+    static void entryToJson(const ScanEntry& entry, JsonObject obj);
+
+    ScanEntry entries_[MAX_ENTRIES];
+    uint32_t version_ = 0;
+    // これより古いバージョンからの差分は作れない（削除済みエントリを再利用したため）
+    uint32_t horizon_ = 0;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_SCAN_H
@@ -0,0 +1,52 @@
+#include "SukenWiFiSnapshot.h"
+
+namespace SukenWiFiLib {
+
+SnapshotCell::SnapshotCell() {
+    mutex_ = xSemaphoreCreateMutex();
+}
+
+SnapshotCell::~SnapshotCell() {
+    if (mutex_) vSemaphoreDelete(mutex_);
+}
+
+void SnapshotCell::lock() const {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+}
+
+void SnapshotCell::unlock() const {
+    xSemaphoreGive(mutex_);
+}
+
+NetworkSnapshot SnapshotCell::read() const {
+    NetworkSnapshot copy;
+    for (int i = 0; i < READ_RETRIES; ++i) {
+        uint32_t before = __atomic_load_n(&seq_, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        memcpy(&copy, &published_, sizeof(copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seq_, __ATOMIC_RELAXED) == before) return copy;
+    }
+    // 書き込みが終わるまで待つ（staging_ は常に最新の値）
+    lock();
+    copy = staging_;
+    unlock();
+    return copy;
+}
+
+void SnapshotCell::update(const std::function<void(NetworkSnapshot&)>& mutate) {
+    lock();
+    uint32_t sequence = staging_.sequence;
+    mutate(staging_);
+    // mutate が構造体ごと初期化しても番号は戻さない
+    staging_.sequence = sequence + 1;
+    staging_.updatedMs = millis();
+
+    __atomic_store_n(&seq_, seq_ + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&published_, &staging_, sizeof(published_));
+    __atomic_store_n(&seq_, seq_ + 1, __ATOMIC_RELEASE);
+    unlock();
+}
+
+} // namespace SukenWiFiLib
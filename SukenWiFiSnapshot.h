@@ -0,0 +1,54 @@
+#ifndef SUKEN_WIFI_SNAPSHOT_H
+#define SUKEN_WIFI_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <functional>
+
+namespace SukenWiFiLib {
+
+// STA の接続状態（WiFi イベントと RSSI の定期サンプルで更新する）
+// isConnected() などの取得系はこれを読むだけで、WiFi ドライバを呼ばない。
+// 1回の取得で得た値どうしは必ず同じ時点のもの（SSID と IP が別々の接続のものになることはない）
+struct NetworkSnapshot {
+    bool associated = false;     // STA_CONNECTED 〜 DISCONNECTED
+    bool hasIPv4 = false;        // GOT_IP 〜 LOST_IP / DISCONNECTED（WiFi.status() == WL_CONNECTED と同じ）
+    char ssid[33] = {};
+    uint8_t bssid[6] = {};
+    uint8_t channel = 0;
+    int8_t rssi = 0;             // dBm。未接続なら 0
+    uint32_t ip = 0;             // IPv4 は IPAddress(ip) で変換できる形（uint32_t(IPAddress) と同じ）
+    uint32_t gateway = 0;
+    uint32_t subnet = 0;
+    uint32_t dns1 = 0;
+    uint32_t dns2 = 0;
+    uint32_t sequence = 0;       // 更新ごとに増える（前回の取得から変化したかの判定に使える）
+    uint32_t updatedMs = 0;
+};
+
+// 書き込みは稀、読み出しは頻繁な NetworkSnapshot の入れ物（seqlock）
+// 読み出しはロックを取らず、書き込み中に重なった場合だけ読み直す
+class SnapshotCell {
+public:
+    SnapshotCell();
+    ~SnapshotCell();
+
+    NetworkSnapshot read() const;
+    // イベントタスクと RSSI タイマーから呼ぶ。mutate の中でドライバを呼ばないこと
+    void update(const std::function<void(NetworkSnapshot&)>& mutate);
+
+private:
+    void lock() const;
+    void unlock() const;
+
+    NetworkSnapshot published_;  // 読み出し側が見るコピー
+    NetworkSnapshot staging_;    // 書き込み側の作業用（mutex で保護）
+    uint32_t seq_ = 0;           // 奇数の間は published_ を書き換え中
+    SemaphoreHandle_t mutex_ = nullptr;
+
+    // 書き込み側が同じコアで割り込まれていると読み直しが続くので、この回数でロックに切り替える
+    static constexpr int READ_RETRIES = 8;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_SNAPSHOT_H
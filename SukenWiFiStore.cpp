@@ -0,0 +1,311 @@
+#include "SukenWiFiStore.h"
+
+namespace SukenWiFiLib {
+
+ConfigStore::ConfigStore() {
+    // writeNow() から read() を呼ぶなど、ロック中に公開メソッドを使うので再帰ミューテックス
+    mutex_ = xSemaphoreCreateRecursiveMutex();
+}
+
+ConfigStore::~ConfigStore() {
+    if (mutex_) vSemaphoreDelete(mutex_);
+}
+
+void ConfigStore::lock() const {
+    xSemaphoreTakeRecursive(mutex_, portMAX_DELAY);
+}
+
+void ConfigStore::unlock() const {
+    xSemaphoreGiveRecursive(mutex_);
+}
+
+bool ConfigStore::read(const char* path, String& content) const {
+    lock();
+    File file = SPIFFS.open(path, "r");
+    bool opened = static_cast<bool>(file);
+    if (opened) {
+        content = file.readString();
+        file.close();
+    }
+    unlock();
+    return opened;
+}
+
+bool ConfigStore::exists(const char* path) const {
+    lock();
+    bool found = SPIFFS.exists(path);
+    unlock();
+    return found;
+}
+
+bool ConfigStore::write(const char* path, const String& content) {
+    lock();
+    bool ok = true;
+    if (transactionDepth_ > 0) {
+        // 同じファイルへの更新は最後の内容だけを残す
+        bool merged = false;
+        for (auto& p : pending_) {
+            if (p.path == path) {
+                p.content = content;
+                merged = true;
+                break;
+            }
+        }
+        if (!merged) pending_.push_back({String(path), content});
+    } else {
+        ok = writeNow(path, content);
+    }
+    unlock();
+    return ok;
+}
+
+bool ConfigStore::writeNow(const char* path, const String& content) {
+    String current;
+    if (SPIFFS.exists(path) && read(path, current) && current == content) {
+        stats_.skippedWrites++;
+        Serial.println(String("Unchanged, skipped write: ") + path);
+        return true;
+    }
+    File file = SPIFFS.open(path, "w");
+    if (!file) {
+        Serial.println(String("Error writing ") + path);
+        return false;
+    }
+    size_t written = file.print(content);
+    file.close();
+    countWrite(written);
+    return written == content.length();
+}
+
+bool ConfigStore::remove(const char* path) {
+    lock();
+    // ログのキャッシュも破棄する
+    for (size_t i = 0; i < logCache_.size();) {
+        if (logCache_[i].path == path) {
+            logCache_.erase(logCache_.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+    for (size_t i = 0; i < loadedLogs_.size(); ++i) {
+        if (loadedLogs_[i] == path) {
+            loadedLogs_.erase(loadedLogs_.begin() + i);
+            break;
+        }
+    }
+    bool removed = SPIFFS.exists(path) && SPIFFS.remove(path);
+    unlock();
+    return removed;
+}
+
+bool ConfigStore::inTransaction() const {
+    lock();
+    bool open = transactionDepth_ > 0;
+    unlock();
+    return open;
+}
+
+void ConfigStore::beginTransaction() {
+    // ロックは対応する commit() で返す
+    lock();
+    transactionDepth_++;
+}
+
+bool ConfigStore::commit() {
+    lock();
+    if (transactionDepth_ == 0) {
+        unlock();
+        return true;
+    }
+    bool ok = true;
+    if (--transactionDepth_ == 0) {
+        for (const auto& p : pending_) {
+            ok = writeNow(p.path.c_str(), p.content) && ok;
+        }
+        pending_.clear();
+    }
+    // beginTransaction() で取った分とこの関数で取った分
+    unlock();
+    unlock();
+    return ok;
+}
+
+void ConfigStore::loadLog(const char* path) {
+    for (const auto& loaded : loadedLogs_) {
+        if (loaded == path) return;
+    }
+    loadedLogs_.push_back(String(path));
+    recoverCompaction(path);
+    File file = SPIFFS.open(path, "r");
+    if (!file) return;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        int separatorIndex = line.indexOf('=');
+        if (separatorIndex == -1) continue;
+        String key = line.substring(0, separatorIndex);
+        String value = line.substring(separatorIndex + 1);
+        LogEntry* entry = findLogEntry(path, key);
+        if (entry) {
+            entry->value = value;
+        } else {
+            logCache_.push_back({String(path), key, value});
+        }
+    }
+    file.close();
+}
+
+ConfigStore::LogEntry* ConfigStore::findLogEntry(const char* path, const String& key) {
+    for (auto& entry : logCache_) {
+        if (entry.path == path && entry.key == key) return &entry;
+    }
+    return nullptr;
+}
+
+bool ConfigStore::append(const char* path, const String& key, const String& value) {
+    lock();
+    bool ok = appendLocked(path, key, value);
+    unlock();
+    return ok;
+}
+
+bool ConfigStore::appendLocked(const char* path, const String& key, const String& value) {
+    loadLog(path);
+    LogEntry* entry = findLogEntry(path, key);
+    if (entry && entry->value == value) {
+        stats_.skippedWrites++;
+        return true;
+    }
+    if (entry) {
+        entry->value = value;
+    } else {
+        logCache_.push_back({String(path), key, value});
+    }
+
+    File file = SPIFFS.open(path, "a");
+    if (!file) {
+        Serial.println(String("Error appending to ") + path);
+        return false;
+    }
+    size_t written = file.print(key + "=" + value + "\n");
+    size_t size = file.size();
+    file.close();
+    countWrite(written);
+
+    if (size > LOG_COMPACT_THRESHOLD) {
+        return compactLog(path);
+    }
+    return true;
+}
+
+bool ConfigStore::appendRaw(const char* path, const String& content) {
+    lock();
+    File file = SPIFFS.open(path, "a");
+    bool ok = false;
+    if (file) {
+        size_t written = file.print(content);
+        file.close();
+        countWrite(written);
+        ok = written == content.length();
+    } else {
+        Serial.println(String("Error appending to ") + path);
+    }
+    unlock();
+    return ok;
+}
+
+bool ConfigStore::readLog(const char* path, const String& key, String& value) {
+    lock();
+    loadLog(path);
+    LogEntry* entry = findLogEntry(path, key);
+    if (entry) value = entry->value;
+    unlock();
+    return entry != nullptr;
+}
+
+bool ConfigStore::compactLog(const char* path) {
+    // 最新値だけを一時ファイルに書き出してから置き換える
+    // SPIFFS の rename は既存のファイルを上書きできないので、元のログを消してから rename する。
+    // どの時点で電源が落ちても、次の loadLog() で recoverCompaction() が完全な方を残す
+    String tmpPath = String(path) + ".tmp";
+    File file = SPIFFS.open(tmpPath.c_str(), "w");
+    if (!file) return false;
+    size_t expected = 0;
+    size_t written = 0;
+    for (const auto& entry : logCache_) {
+        if (entry.path == path) {
+            String line = entry.key + "=" + entry.value + "\n";
+            expected += line.length();
+            written += file.print(line);
+        }
+    }
+    file.close();
+    countWrite(written);
+    if (written != expected) {
+        // 元のログはそのまま使える（長いだけ）
+        SPIFFS.remove(tmpPath.c_str());
+        Serial.println(String("Log compaction failed: ") + path);
+        return false;
+    }
+    SPIFFS.remove(path);
+    if (!SPIFFS.rename(tmpPath.c_str(), path)) {
+        // 一時ファイルは残す（次の loadLog() で rename し直す）
+        Serial.println(String("Log compaction failed: ") + path);
+        return false;
+    }
+    stats_.compactions++;
+    Serial.println(String("Log compacted: ") + path);
+    return true;
+}
+
+void ConfigStore::recoverCompaction(const char* path) {
+    String tmpPath = String(path) + ".tmp";
+    if (!SPIFFS.exists(tmpPath.c_str())) return;
+    if (SPIFFS.exists(path)) {
+        // 一時ファイルの書き込み中に止まった。元のログが完全
+        SPIFFS.remove(tmpPath.c_str());
+    } else {
+        // 元のログを消した後に止まった。一時ファイルは書き終わっている
+        SPIFFS.rename(tmpPath.c_str(), path);
+        Serial.println(String("Log compaction recovered: ") + path);
+    }
+}
+
+void ConfigStore::countWrite(size_t bytes) {
+    uint32_t now = millis();
+    if (now - dayStartMs_ >= DAY_MS) {
+        lastDayWrites_ = dayWrites_;
+        dayWrites_ = 0;
+        dayStartMs_ = now;
+        fullDayElapsed_ = true;
+    }
+    dayWrites_++;
+    stats_.writes++;
+    stats_.bytesWritten += bytes;
+}
+
+StoreStats ConfigStore::stats() {
+    lock();
+    uint32_t now = millis();
+    uint32_t elapsed = now - dayStartMs_;
+    if (elapsed >= DAY_MS) {
+        lastDayWrites_ = dayWrites_;
+        dayWrites_ = 0;
+        dayStartMs_ = now;
+        fullDayElapsed_ = true;
+        elapsed = 0;
+    }
+    if (fullDayElapsed_) {
+        stats_.writesPerDay = lastDayWrites_;
+    } else if (elapsed < 60000UL) {
+        stats_.writesPerDay = dayWrites_;
+    } else {
+        // 起動後24時間未満は経過時間から推定
+        stats_.writesPerDay = static_cast<uint32_t>(static_cast<uint64_t>(dayWrites_) * DAY_MS / elapsed);
+    }
+    StoreStats copy = stats_;
+    unlock();
+    return copy;
+}
+
+} // namespace SukenWiFiLib
@@ -0,0 +1,92 @@
+#ifndef SUKEN_WIFI_STORE_H
+#define SUKEN_WIFI_STORE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <vector>
+
+namespace SukenWiFiLib {
+
+// 永続化の統計
+struct StoreStats {
+    uint32_t writes = 0;          // 実際にフラッシュへ書き込んだ回数
+    uint32_t skippedWrites = 0;   // 内容が同一のためスキップした回数
+    uint32_t bytesWritten = 0;
+    uint32_t compactions = 0;     // ログファイルの圧縮回数
+    uint32_t writesPerDay = 0;    // 直近24時間（起動後24時間未満は推定値）
+};
+
+// SPIFFS への書き込みを最小化する永続化レイヤ
+// - 保存済みの内容と同じなら書き込まない
+// - トランザクション中の書き込みはファイルごとに1回へまとめる
+// - 頻繁に更新する値は追記型ログに書き、一定サイズで圧縮する
+// ポータル、アプリ、送信キューのタスクから同時に使われるため、すべての操作を再帰ミューテックスで守る。
+// beginTransaction() 〜 commit() の間はロックを持ち続け、他のタスクの書き込みが混ざらないようにする
+class ConfigStore {
+public:
+    ConfigStore();
+    ~ConfigStore();
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    bool read(const char* path, String& content) const;
+    bool write(const char* path, const String& content);
+    bool remove(const char* path);
+    bool exists(const char* path) const;
+
+    // beginTransaction() 〜 commit() の間の write() は commit() でまとめて書き込む
+    void beginTransaction();
+    bool commit();
+    // commit() 前の write() はまだフラッシュにない（ロックを持っているタスクから見た状態）
+    bool inTransaction() const;
+
+    // 追記型ログ（同じキーは最後に書いた値が有効）
+    bool append(const char* path, const String& key, const String& value);
+    bool readLog(const char* path, const String& key, String& value);
+    // キーを付けずにそのまま追記する（送信キューの保存など。append() のログには使わない）
+    bool appendRaw(const char* path, const String& content);
+
+    StoreStats stats();
+
+private:
+    struct PendingWrite {
+        String path;
+        String content;
+    };
+    struct LogEntry {
+        String path;
+        String key;
+        String value;
+    };
+
+    void lock() const;
+    void unlock() const;
+    // 以下はロックを持った状態で呼ぶ
+    bool writeNow(const char* path, const String& content);
+    bool appendLocked(const char* path, const String& key, const String& value);
+    void loadLog(const char* path);
+    bool compactLog(const char* path);
+    void recoverCompaction(const char* path);
+    LogEntry* findLogEntry(const char* path, const String& key);
+    void countWrite(size_t bytes);
+
+    std::vector<PendingWrite> pending_;
+    uint8_t transactionDepth_ = 0;
+    std::vector<LogEntry> logCache_;
+    std::vector<String> loadedLogs_;
+
+    StoreStats stats_;
+    uint32_t dayStartMs_ = 0;
+    uint32_t dayWrites_ = 0;
+    uint32_t lastDayWrites_ = 0;
+    bool fullDayElapsed_ = false;
+    SemaphoreHandle_t mutex_ = nullptr;
+
+    static constexpr size_t LOG_COMPACT_THRESHOLD = 2048;
+    static constexpr uint32_t DAY_MS = 24UL * 60UL * 60UL * 1000UL;
+};
+
+} // namespace SukenWiFiLib
+
+#endif // SUKEN_WIFI_STORE_H
@@ -0,0 +1,101 @@
+#include <SukenESPWiFi.h>
+
+// 設定変更の差分判定の確認
+// 変更の種類ごとに diffConfig() が最小限の処理だけを返すことを確認し、結果を表示します。
+// （WiFi には接続しません。ボードに書き込んでシリアルモニタで確認してください）
+
+using namespace SukenWiFiLib;
+
+static ConfigActions bits(std::initializer_list<ConfigAction> actions) {
+    ConfigActions mask = 0;
+    for (ConfigAction action : actions) mask |= static_cast<uint8_t>(action);
+    return mask;
+}
+
+static String describe(ConfigActions actions) {
+    JsonDocument doc;
+    configActionsToJson(actions, doc.createNestedArray("actions"));
+    String text;
+    serializeJson(doc["actions"], text);
+    return text;
+}
+
+static int failures = 0;
+
+static void check(const char* name, const WiFiCredentials& newCreds, const NetworkConfig& newConfig,
+                  bool associated, ConfigActions expected) {
+    WiFiCredentials oldCreds;
+    oldCreds.ssid = "MyNetwork";
+    oldCreds.password = "secret123";
+    NetworkConfig oldConfig;
+    oldConfig.useStaticIP = true;
+    oldConfig.staticIP = IPAddress(192, 168, 10, 50);
+
+    ConfigActions actual = diffConfig(oldCreds, oldConfig, newCreds, newConfig, associated);
+    bool ok = actual == expected;
+    if (!ok) failures++;
+    Serial.printf("%-4s %-32s %s", ok ? "OK" : "FAIL", name, describe(actual).c_str());
+    if (!ok) Serial.printf(" (expected %s)", describe(expected).c_str());
+    Serial.println();
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    WiFiCredentials creds;
+    creds.ssid = "MyNetwork";
+    creds.password = "secret123";
+    NetworkConfig config;
+    config.useStaticIP = true;
+    config.staticIP = IPAddress(192, 168, 10, 50);
+
+    check("unchanged", creds, config, true, 0);
+    check("unchanged, not connected", creds, config, false, bits({ConfigAction::Reconnect}));
+
+    NetworkConfig dns = config;
+    dns.primaryDNS = IPAddress(1, 1, 1, 1);
+    check("DNS only", creds, dns, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    NetworkConfig address = config;
+    address.staticIP = IPAddress(192, 168, 10, 60);
+    check("static IP only", creds, address, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    NetworkConfig dhcp = config;
+    dhcp.useStaticIP = false;
+    check("static -> DHCP", creds, dhcp, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    // 固定IPが無効なままなら、固定IP用の値は比べない
+    NetworkConfig unusedStatic = dhcp;
+    unusedStatic.gateway = IPAddress(10, 0, 0, 1);
+    WiFiCredentials dhcpOld = creds;
+    NetworkConfig dhcpOldConfig = dhcp;
+    ConfigActions unused = diffConfig(dhcpOld, dhcpOldConfig, creds, unusedStatic, true);
+    bool unusedOk = unused == 0;
+    if (!unusedOk) failures++;
+    Serial.printf("%-4s %-32s %s\n", unusedOk ? "OK" : "FAIL", "unused static field", describe(unused).c_str());
+
+    NetworkConfig ipv6On = config;
+    ipv6On.enableIPv6 = true;
+    check("IPv6 on", creds, ipv6On, true, bits({ConfigAction::SaveNetwork, ConfigAction::EnableIPv6}));
+    ConfigActions ipv6Off = diffConfig(creds, ipv6On, creds, config, true);
+    bool ipv6OffOk = ipv6Off == bits({ConfigAction::SaveNetwork, ConfigAction::Reconnect});
+    if (!ipv6OffOk) failures++;
+    Serial.printf("%-4s %-32s %s\n", ipv6OffOk ? "OK" : "FAIL", "IPv6 off", describe(ipv6Off).c_str());
+
+    WiFiCredentials password = creds;
+    password.password = "changed456";
+    check("password", password, config, true, bits({ConfigAction::SaveCredentials, ConfigAction::Reconnect}));
+    check("password + IPv6 on", password, ipv6On, true,
+          bits({ConfigAction::SaveCredentials, ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+
+    WiFiCredentials ssid = creds;
+    ssid.ssid = "OtherNetwork";
+    check("SSID + static IP", ssid, address, true,
+          bits({ConfigAction::SaveCredentials, ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+
+    Serial.println(failures == 0 ? "All checks passed" : "Some checks FAILED");
+}
+
+void loop() {
+    delay(1000);
+}
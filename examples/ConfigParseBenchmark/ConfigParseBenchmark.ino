@@ -0,0 +1,114 @@
+#include <SukenESPWiFi.h>
+
+// 設定の読み込み速度の比較
+// ポータルから送られる JSON と設定ファイルの行を、以前の手書きの処理（containsKey と if の連鎖）と
+// 項目表（SukenWiFiConfigFields.h）から生成した処理でそれぞれ読み、1回あたりの時間を表示します。
+// 結果が一致することも確認します。
+
+static const char* PORTAL_JSON =
+    "{\"ssid\":\"MyNetwork\",\"password\":\"secret123\",\"useStaticIP\":true,"
+    "\"staticIP\":\"192.168.10.50\",\"gateway\":\"192.168.10.1\",\"subnet\":\"255.255.255.0\","
+    "\"primaryDNS\":\"1.1.1.1\",\"secondaryDNS\":\"1.0.0.1\",\"enableIPv6\":true}";
+
+static const char* SETTINGS_LINES[][2] = {
+    {"useStaticIP", "true"},       {"staticIP", "192.168.10.50"}, {"gateway", "192.168.10.1"},
+    {"subnet", "255.255.255.0"},   {"primaryDNS", "1.1.1.1"},     {"secondaryDNS", "1.0.0.1"},
+    {"enableIPv6", "true"},
+};
+
+static const int RUNS = 2000;
+
+using SukenWiFiLib::NetworkConfig;
+using SukenWiFiLib::WiFiCredentials;
+
+// 以前の parseConfigJson() と同じ処理
+static bool legacyParseJson(const JsonDocument& doc, WiFiCredentials& credentials, NetworkConfig& config) {
+    if (!doc.containsKey("ssid")) return false;
+    credentials.ssid = doc["ssid"].as<String>();
+    credentials.password = doc["password"] | "";
+    if (credentials.ssid.length() == 0 || credentials.ssid.length() > 32 || credentials.password.length() > 64) {
+        return false;
+    }
+    config = NetworkConfig();
+    config.enableIPv6 = doc["enableIPv6"] | false;
+    config.useStaticIP = doc["useStaticIP"] | false;
+    if (config.useStaticIP) {
+        if (doc.containsKey("staticIP") && !config.staticIP.fromString(doc["staticIP"].as<String>())) return false;
+        if (doc.containsKey("gateway") && !config.gateway.fromString(doc["gateway"].as<String>())) return false;
+        if (doc.containsKey("subnet") && !config.subnet.fromString(doc["subnet"].as<String>())) return false;
+        if (doc.containsKey("primaryDNS") && !config.primaryDNS.fromString(doc["primaryDNS"].as<String>())) return false;
+        if (doc.containsKey("secondaryDNS") && !config.secondaryDNS.fromString(doc["secondaryDNS"].as<String>())) return false;
+    }
+    return true;
+}
+
+// 以前の readNetworkSettings() の1行分
+static void legacyDecodeLine(const String& key, const String& value, NetworkConfig& config) {
+    if (key.equals("useStaticIP")) {
+        config.useStaticIP = (value == "true");
+    } else if (key.equals("staticIP")) {
+        config.staticIP.fromString(value);
+    } else if (key.equals("gateway")) {
+        config.gateway.fromString(value);
+    } else if (key.equals("subnet")) {
+        config.subnet.fromString(value);
+    } else if (key.equals("primaryDNS")) {
+        config.primaryDNS.fromString(value);
+    } else if (key.equals("secondaryDNS")) {
+        config.secondaryDNS.fromString(value);
+    } else if (key.equals("enableIPv6")) {
+        config.enableIPv6 = (value == "true");
+    }
+}
+
+static bool sameConfig(const NetworkConfig& a, const NetworkConfig& b) {
+    return SukenWiFiLib::encodeNetworkConfig(a) == SukenWiFiLib::encodeNetworkConfig(b);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    JsonDocument doc;
+    deserializeJson(doc, PORTAL_JSON);
+
+    WiFiCredentials legacyCreds, tableCreds;
+    NetworkConfig legacyConfig, tableConfig;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < RUNS; ++i) legacyParseJson(doc, legacyCreds, legacyConfig);
+    int64_t legacyJsonUs = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int i = 0; i < RUNS; ++i) SukenWiFiLib::parseConfigFields(doc, tableCreds, tableConfig);
+    int64_t tableJsonUs = esp_timer_get_time() - start;
+    bool jsonMatch = sameConfig(legacyConfig, tableConfig) && legacyCreds.ssid == tableCreds.ssid &&
+                     legacyCreds.password == tableCreds.password;
+
+    // 設定ファイルの行（String の生成は両方に同じだけかかるので先に作っておく）
+    const size_t lineCount = sizeof(SETTINGS_LINES) / sizeof(SETTINGS_LINES[0]);
+    String keys[lineCount], values[lineCount];
+    for (size_t k = 0; k < lineCount; ++k) {
+        keys[k] = SETTINGS_LINES[k][0];
+        values[k] = SETTINGS_LINES[k][1];
+    }
+    NetworkConfig legacyFile, tableFile;
+    start = esp_timer_get_time();
+    for (int i = 0; i < RUNS; ++i) {
+        for (size_t k = 0; k < lineCount; ++k) legacyDecodeLine(keys[k], values[k], legacyFile);
+    }
+    int64_t legacyFileUs = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int i = 0; i < RUNS; ++i) {
+        for (size_t k = 0; k < lineCount; ++k) SukenWiFiLib::decodeNetworkLine(keys[k], values[k], tableFile);
+    }
+    int64_t tableFileUs = esp_timer_get_time() - start;
+
+    Serial.printf("JSON parse:  legacy=%.2fus table=%.2fus (%s)\n",
+                  static_cast<double>(legacyJsonUs) / RUNS, static_cast<double>(tableJsonUs) / RUNS,
+                  jsonMatch ? "match" : "MISMATCH");
+    Serial.printf("file decode: legacy=%.2fus table=%.2fus (%s)\n",
+                  static_cast<double>(legacyFileUs) / RUNS, static_cast<double>(tableFileUs) / RUNS,
+                  sameConfig(legacyFile, tableFile) ? "match" : "MISMATCH");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -0,0 +1,32 @@
+#include <SukenESPWiFi.h>
+
+// 協調モード（シングルタスク）の例
+// ライブラリはタスクを生成せず、loop() から SukenWiFi.loop() を呼び出して動作します。
+// 5秒ごとに SukenWiFi.loop() の実行時間（平均/最悪値）を表示します。
+
+static uint32_t lastReportMs = 0;
+
+void setup() {
+    Serial.begin(115200);
+
+    SukenWiFiLib::TaskTopology topo;
+    topo.cooperative = true;
+    SukenWiFi.setTaskTopology(topo);
+
+    SukenWiFi.init("MyDevice"); // ブロックせずにすぐ戻る
+}
+
+void loop() {
+    SukenWiFi.loop();
+
+    if (millis() - lastReportMs >= 5000) {
+        lastReportMs = millis();
+        auto ls = SukenWiFi.getLoopStats();
+        Serial.printf("loop: calls=%u avg=%uus max=%uus connected=%d\n",
+                      ls.calls, ls.avgUs, ls.maxUs, SukenWiFi.isConnected());
+        SukenWiFi.resetLoopStats();
+    }
+
+    // アプリ側の処理（ここでも長時間ブロックしないこと）
+    delay(1);
+}
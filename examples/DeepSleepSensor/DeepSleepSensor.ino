@@ -0,0 +1,31 @@
+#include <SukenESPWiFi.h>
+
+// ディープスリープ間欠動作の例
+// 初回（コールドブート）は通常どおり SPIFFS の設定で接続し、接続先を RTC メモリに記録します。
+// 以降のタイマー復帰では記録から直接接続し、復帰から IP 取得までの時間を表示してまた眠ります。
+
+static const uint64_t SLEEP_US = 5ULL * 60 * 1000 * 1000; // 5分
+
+void setup() {
+    Serial.begin(115200);
+
+    SukenWiFi.enableDeepSleepFastPath(true);
+    SukenWiFi.enableLeaseReuse(true);   // DHCP の往復も省く
+    SukenWiFi.init("MySensor");
+}
+
+void loop() {
+    // 未設定または接続失敗の間は、セットアップポータルで設定されるまで起きたまま待つ
+    if (!SukenWiFi.isConnected()) {
+        delay(100);
+        return;
+    }
+
+    auto profile = SukenWiFi.getBootProfile();
+    Serial.printf("wake-to-IP: %lld us (fast path: %s)\n",
+                  profile.gotIpUs, profile.fastPath ? "yes" : "no");
+    // ここで測定値を送信する
+    SukenWiFi.httpPost("http://example.com/api/data", "{\"value\":42}");
+
+    SukenWiFi.deepSleep(SLEEP_US);
+}
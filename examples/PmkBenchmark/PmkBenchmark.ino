@@ -0,0 +1,52 @@
+#include <SukenESPWiFi.h>
+
+// PMK 保存の例
+// 起動時に IEEE 802.11i（Annex H.4）のテストベクタで PMK 計算を検証し、1回の計算時間を表示します。
+// この時間は、パスフレーズを保存している場合に接続のたびにかかる時間です。
+// その後 PMK 保存を有効にして初期化します（平文で保存済みのパスフレーズは PMK に置き換わります）。
+
+struct PmkVector {
+    const char* passphrase;
+    const char* ssid;
+    const char* expected;
+};
+
+static const PmkVector VECTORS[] = {
+    {"password", "IEEE", "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e"},
+    {"ThisIsAPassword", "ThisIsASSID", "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af"},
+};
+
+static const int BENCH_RUNS = 5;
+
+void setup() {
+    Serial.begin(115200);
+
+    bool allPassed = true;
+    for (const PmkVector& v : VECTORS) {
+        uint8_t pmk[SukenWiFiLib::PMK_LENGTH];
+        bool ok = SukenWiFiLib::derivePmk(v.ssid, v.passphrase, pmk) &&
+                  SukenWiFiLib::pmkToHex(pmk) == v.expected;
+        Serial.printf("vector ssid=%s: %s\n", v.ssid, ok ? "OK" : "FAILED");
+        allPassed = allPassed && ok;
+    }
+
+    uint32_t totalUs = 0;
+    uint32_t maxUs = 0;
+    for (int i = 0; i < BENCH_RUNS; ++i) {
+        uint8_t pmk[SukenWiFiLib::PMK_LENGTH];
+        int64_t start = esp_timer_get_time();
+        SukenWiFiLib::derivePmk("ThisIsASSID", "ThisIsAPassword", pmk);
+        uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+        totalUs += elapsed;
+        if (elapsed > maxUs) maxUs = elapsed;
+    }
+    Serial.printf("PBKDF2-HMAC-SHA1 x4096: avg=%uus max=%uus (%s)\n",
+                  totalUs / BENCH_RUNS, maxUs, allPassed ? "vectors OK" : "vectors FAILED");
+
+    SukenWiFi.enablePmkStorage(true);
+    SukenWiFi.init("MyDevice");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -44,7 +44,10 @@ void serialEvent() {
     if (Serial.available() > 0) {
         String command = Serial.readStringUntil('\n');
         command.trim();
-        if (command == "clear all") {
+        if (command.startsWith("{")) {
+            // 量産用プロビジョニング: {"cmd":"apply","ssid":"...","password":"..."}
+            Serial.println(SukenWiFi.handleProvisioningCommand(command));
+        } else if (command == "clear all") {
             SukenWiFi.clearAllSettings();
             Serial.println("All settings cleared. You can reconfigure via AP portal.");
         } else if (command == "clear wifi") {
@@ -0,0 +1,474 @@
+// 多数のデバイスの一斉再接続（AP 再起動など）をホスト上で再現するシミュレータ
+//
+// 各デバイスはライブラリと同じ ConnectionFsm（再接続→ポータル移行の状態機械）で動き、
+// 容量制限、アソシエーション/DHCP の遅延を持つ AP のモデルに接続する。
+// 仮想時計で進めるため、数時間分の動作が数秒で終わる。
+// 再試行ポリシー（setDisconnectRetryPolicy() などの値）を変えたときの
+// 復旧時間の分布、誤ってセットアップモードに入った台数、AP の最大負荷を比較するために使う。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -O2 -I. extras/fleet_sim/fleet_sim.cpp -o fleet_sim
+// 例:
+//   ./fleet_sim --devices 300 --outage 60000:45000 --duration 1800000
+//   ./fleet_sim --devices 300 --attempts 60 --retry-delay 1000   # ポータル移行を遅らせる
+//
+// モデルの前提:
+// - AP は capacity 台まで接続でき、同時に処理するアソシエーションは assoc-slots 件まで。
+//   超えた分は拒否する
+// - アソシエーションの遅延は同時に処理中の台数に比例して伸びる
+// - DHCP サーバーは同時に dhcp-concurrency 件まで処理し、残りは順番待ちになる
+// - AP が見つからない、または拒否された場合、Arduino コアの自動再接続と同じく
+//   scan-ms ごとに再試行する（ConnectionFsm が接続試行中の間だけ）
+// - 停電ではなく AP だけの再起動を想定し、停止後 detect-ms（+ジッター）でデバイスが切断を検知する
+
+#include "SukenWiFiFsm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+struct Outage {
+    uint32_t startMs = 0;
+    uint32_t durationMs = 0;
+    uint32_t bootMs = 0;      // 電波が戻ってから接続を受け付けるまで
+    uint32_t endMs() const { return startMs + durationMs + bootMs; }
+};
+
+struct SimConfig {
+    uint32_t devices = 300;
+    uint32_t durationMs = 30UL * 60 * 1000;
+    uint32_t stepMs = 10;
+    uint32_t seed = 1;
+    FsmPolicy policy;
+    // AP
+    uint32_t capacity = 512;
+    uint32_t assocSlots = 16;
+    uint32_t assocMs = 150;
+    uint32_t assocPerStaMs = 20;        // 同時処理中の1台あたりの追加遅延
+    uint32_t assocJitterMs = 200;
+    uint32_t dhcpMs = 300;
+    uint32_t dhcpJitterMs = 700;
+    uint32_t dhcpConcurrency = 8;
+    uint32_t scanMs = 2500;             // AP が見つからないときの再試行間隔
+    uint32_t detectMs = 3000;           // ビーコン喪失の検知
+    uint32_t detectJitterMs = 3000;
+    std::vector<Outage> outages;
+};
+
+enum class Phase : uint8_t {
+    Idle = 0,
+    Searching,      // AP が見つからない/拒否された。phaseUntil で再試行
+    Associating,
+    DhcpWait,       // DHCP サーバーの順番待ち
+    Dhcp,
+    Up
+};
+
+struct Device {
+    ConnectionFsm fsm;
+    Phase phase = Phase::Idle;
+    uint32_t phaseUntil = 0;
+    uint32_t downAt = 0;          // 切断を検知する時刻（0 なら予定なし）
+    int pendingOutage = -1;       // 復旧待ちの停止（outages の添字）
+    uint32_t portalEntries = 0;
+    uint32_t portalSinceMs = 0;
+    uint32_t portalTotalMs = 0;
+};
+
+struct OutageResult {
+    std::vector<uint32_t> recoveryMs;   // AP 復帰から GOT_IP まで
+    uint32_t unrecovered = 0;
+};
+
+struct ApLoad {
+    uint32_t associated = 0;
+    uint32_t associating = 0;
+    uint32_t dhcpInFlight = 0;
+    std::deque<size_t> dhcpQueue;
+    uint32_t peakAssociated = 0;
+    uint32_t peakAssociating = 0;
+    uint32_t peakDhcpQueue = 0;
+    uint32_t rejects = 0;
+    uint32_t attempts = 0;
+    uint32_t attemptsThisSecond = 0;
+    uint32_t peakAttemptsPerSecond = 0;
+};
+
+class FleetSim {
+public:
+    explicit FleetSim(const SimConfig& config)
+        : config_(config), devices_(config.devices), results_(config.outages.size()), rng_(config.seed) {}
+
+    void run() {
+        // 全台が接続済みの状態から始める
+        for (size_t i = 0; i < devices_.size(); ++i) {
+            Device& d = devices_[i];
+            d.fsm.setPolicy(config_.policy);
+            d.fsm.setHasCredentials(true);
+            d.fsm.onLinkUp(0);
+            d.phase = Phase::Up;
+            ap_.associated++;
+        }
+        uint32_t secondStart = 0;
+        for (uint32_t now = 0; now <= config_.durationMs; now += config_.stepMs) {
+            applyOutages(now);
+            for (size_t i = 0; i < devices_.size(); ++i) {
+                stepDevice(i, now);
+            }
+            serviceDhcpQueue(now);
+            ap_.peakAssociated = std::max(ap_.peakAssociated, ap_.associated);
+            ap_.peakAssociating = std::max(ap_.peakAssociating, ap_.associating);
+            ap_.peakDhcpQueue = std::max(ap_.peakDhcpQueue, static_cast<uint32_t>(ap_.dhcpQueue.size()));
+            if (now - secondStart >= 1000) {
+                secondStart = now;
+                ap_.attemptsThisSecond = 0;
+            }
+        }
+        for (Device& d : devices_) {
+            if (d.pendingOutage >= 0) results_[d.pendingOutage].unrecovered++;
+            if (d.fsm.inPortal()) d.portalTotalMs += config_.durationMs - d.portalSinceMs;
+        }
+    }
+
+    void report() const {
+        printf("devices=%u duration=%us step=%ums seed=%u\n", config_.devices,
+               config_.durationMs / 1000, config_.stepMs, config_.seed);
+        printf("policy: attemptsBeforePortal=%u retryDelayMs=%u portalRetryIntervalMs=%u portalAttemptMs=%u autoPortal=%d retryInPortal=%d\n",
+               config_.policy.attemptsBeforePortal, config_.policy.retryDelayMs,
+               config_.policy.portalRetryIntervalMs, config_.policy.portalAttemptMs,
+               config_.policy.autoPortal, config_.policy.retryInPortal);
+        printf("ap: capacity=%u assocSlots=%u assocMs=%u(+%u/sta, jitter %u) dhcpMs=%u(jitter %u, concurrency %u)\n\n",
+               config_.capacity, config_.assocSlots, config_.assocMs, config_.assocPerStaMs, config_.assocJitterMs,
+               config_.dhcpMs, config_.dhcpJitterMs, config_.dhcpConcurrency);
+
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const Outage& o = config_.outages[i];
+            std::vector<uint32_t> samples = results_[i].recoveryMs;
+            std::sort(samples.begin(), samples.end());
+            printf("outage #%zu at %us for %us (+%us boot): recovered=%zu unrecovered=%u\n", i + 1,
+                   o.startMs / 1000, o.durationMs / 1000, o.bootMs / 1000,
+                   samples.size(), results_[i].unrecovered);
+            if (samples.empty()) continue;
+            printf("  time-to-recovery after AP is back (ms): min=%u p50=%u p90=%u p99=%u max=%u\n",
+                   samples.front(), percentile(samples, 50), percentile(samples, 90),
+                   percentile(samples, 99), samples.back());
+            printHistogram(samples);
+        }
+
+        uint32_t portalDevices = 0;
+        uint32_t portalEntries = 0;
+        uint64_t portalMs = 0;
+        for (const Device& d : devices_) {
+            if (d.portalEntries > 0) portalDevices++;
+            portalEntries += d.portalEntries;
+            portalMs += d.portalTotalMs;
+        }
+        // 全台が正しい認証情報を持っているので、セットアップモードへの移行はすべて誤り
+        printf("\nsetup mode (wrong): devices=%u entries=%u avgTimeInPortal=%llums\n", portalDevices, portalEntries,
+               static_cast<unsigned long long>(portalDevices ? portalMs / portalDevices : 0));
+        printf("ap load: peakAssociated=%u peakAssociating=%u peakDhcpQueue=%u peakAttempts/s=%u attempts=%u rejects=%u\n",
+               ap_.peakAssociated, ap_.peakAssociating, ap_.peakDhcpQueue, ap_.peakAttemptsPerSecond,
+               ap_.attempts, ap_.rejects);
+    }
+
+private:
+    bool apUp(uint32_t now) const {
+        for (const Outage& o : config_.outages) {
+            if (now >= o.startMs && now < o.endMs()) return false;
+        }
+        return true;
+    }
+
+    uint32_t jitter(uint32_t maxMs) {
+        if (maxMs == 0) return 0;
+        return std::uniform_int_distribution<uint32_t>(0, maxMs)(rng_);
+    }
+
+    void applyOutages(uint32_t now) {
+        for (size_t k = 0; k < config_.outages.size(); ++k) {
+            if (config_.outages[k].startMs != now) continue;
+            // AP が落ちると全台のアソシエーションと DHCP の処理中のものが失われる
+            ap_.associated = 0;
+            ap_.associating = 0;
+            ap_.dhcpInFlight = 0;
+            ap_.dhcpQueue.clear();
+            for (Device& d : devices_) {
+                if (d.phase == Phase::Up) d.downAt = now + config_.detectMs + jitter(config_.detectJitterMs);
+                if (d.phase != Phase::Up && d.phase != Phase::Idle) d.phase = Phase::Searching;
+                if (d.pendingOutage >= 0) results_[d.pendingOutage].unrecovered++;
+                d.pendingOutage = static_cast<int>(k);
+            }
+        }
+    }
+
+    void stepDevice(size_t index, uint32_t now) {
+        Device& d = devices_[index];
+        if (d.downAt != 0 && now >= d.downAt) {
+            d.downAt = 0;
+            if (d.phase == Phase::Up) {
+                d.phase = Phase::Idle;
+                d.fsm.onLinkDown(now);
+            }
+        }
+
+        switch (d.fsm.tick(now)) {
+            case FsmAction::BeginConnect:
+                beginConnect(index, now);
+                break;
+            case FsmAction::EnterPortal:
+                d.portalEntries++;
+                d.portalSinceMs = now;
+                break;
+            case FsmAction::ExitPortal:
+                d.portalTotalMs += now - d.portalSinceMs;
+                break;
+            default:
+                break;
+        }
+
+        switch (d.phase) {
+            case Phase::Searching: {
+                LinkState state = d.fsm.state();
+                bool trying = state == LinkState::Connecting || state == LinkState::PortalConnecting;
+                if (!trying) {
+                    d.phase = Phase::Idle;
+                } else if (now >= d.phaseUntil) {
+                    beginConnect(index, now);
+                }
+                break;
+            }
+            case Phase::Associating:
+                if (now >= d.phaseUntil) {
+                    ap_.associating--;
+                    ap_.associated++;
+                    d.phase = Phase::DhcpWait;
+                    ap_.dhcpQueue.push_back(index);
+                }
+                break;
+            case Phase::Dhcp:
+                if (now >= d.phaseUntil) {
+                    ap_.dhcpInFlight--;
+                    linkUp(d, now);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void beginConnect(size_t index, uint32_t now) {
+        Device& d = devices_[index];
+        // WiFi.begin() は進行中の接続を捨ててやり直す
+        releaseAttempt(index);
+        ap_.attempts++;
+        ap_.attemptsThisSecond++;
+        ap_.peakAttemptsPerSecond = std::max(ap_.peakAttemptsPerSecond, ap_.attemptsThisSecond);
+        if (!apUp(now)) {
+            d.phase = Phase::Searching;
+            d.phaseUntil = now + config_.scanMs;
+            return;
+        }
+        if (ap_.associated + ap_.associating >= config_.capacity || ap_.associating >= config_.assocSlots) {
+            ap_.rejects++;
+            d.phase = Phase::Searching;
+            d.phaseUntil = now + config_.assocMs + config_.scanMs;
+            return;
+        }
+        ap_.associating++;
+        d.phase = Phase::Associating;
+        d.phaseUntil = now + config_.assocMs + config_.assocPerStaMs * ap_.associating + jitter(config_.assocJitterMs);
+    }
+
+    void releaseAttempt(size_t index) {
+        Device& d = devices_[index];
+        switch (d.phase) {
+            case Phase::Associating:
+                ap_.associating--;
+                break;
+            case Phase::DhcpWait:
+                ap_.associated--;
+                ap_.dhcpQueue.erase(std::find(ap_.dhcpQueue.begin(), ap_.dhcpQueue.end(), index));
+                break;
+            case Phase::Dhcp:
+                ap_.associated--;
+                ap_.dhcpInFlight--;
+                break;
+            case Phase::Up:
+                ap_.associated--;
+                break;
+            default:
+                break;
+        }
+        d.phase = Phase::Idle;
+    }
+
+    void serviceDhcpQueue(uint32_t now) {
+        while (!ap_.dhcpQueue.empty() && ap_.dhcpInFlight < config_.dhcpConcurrency) {
+            Device& d = devices_[ap_.dhcpQueue.front()];
+            ap_.dhcpQueue.pop_front();
+            ap_.dhcpInFlight++;
+            d.phase = Phase::Dhcp;
+            d.phaseUntil = now + config_.dhcpMs + jitter(config_.dhcpJitterMs);
+        }
+    }
+
+    void linkUp(Device& d, uint32_t now) {
+        d.phase = Phase::Up;
+        d.downAt = 0;
+        d.fsm.onLinkUp(now);
+        if (d.pendingOutage >= 0) {
+            uint32_t back = config_.outages[d.pendingOutage].endMs();
+            results_[d.pendingOutage].recoveryMs.push_back(now > back ? now - back : 0);
+            d.pendingOutage = -1;
+        }
+    }
+
+    static uint32_t percentile(const std::vector<uint32_t>& sorted, uint32_t p) {
+        size_t index = (sorted.size() - 1) * p / 100;
+        return sorted[index];
+    }
+
+    static void printHistogram(const std::vector<uint32_t>& sorted) {
+        static const uint32_t BOUNDS_MS[] = {1000, 2000, 5000, 10000, 20000, 30000, 60000, 120000, 300000};
+        size_t begin = 0;
+        uint32_t lower = 0;
+        for (uint32_t bound : BOUNDS_MS) {
+            size_t end = std::lower_bound(sorted.begin(), sorted.end(), bound) - sorted.begin();
+            if (end > begin) printf("  %6us-%6us: %zu\n", lower / 1000, bound / 1000, end - begin);
+            begin = end;
+            lower = bound;
+        }
+        if (sorted.size() > begin) printf("  %6us-      : %zu\n", lower / 1000, sorted.size() - begin);
+    }
+
+    SimConfig config_;
+    std::vector<Device> devices_;
+    std::vector<OutageResult> results_;
+    ApLoad ap_;
+    std::mt19937 rng_;
+};
+
+void usage(const char* name) {
+    printf("usage: %s [options]\n"
+           "  --devices N             仮想デバイス数 (300)\n"
+           "  --duration MS           シミュレーション時間 (1800000)\n"
+           "  --step MS               仮想時計の刻み (10)\n"
+           "  --seed N                乱数の種 (1)\n"
+           "  --outage START:DUR[:BOOT]  AP の停止（複数指定可、既定 60000:45000:5000）\n"
+           "  --attempts N            ポータル移行までの再接続ポーリング回数 (6)\n"
+           "  --retry-delay MS        ポーリング間隔 (500)\n"
+           "  --portal-retry MS       セットアップ中の再接続間隔 (5000)\n"
+           "  --portal-attempt MS     セットアップ中の1回の接続待ち時間 (3000)\n"
+           "  --no-auto-portal        切断時にセットアップへ移行しない\n"
+           "  --no-portal-retry       セットアップ中に再接続しない\n"
+           "  --capacity N            AP の最大接続数 (512)\n"
+           "  --assoc-slots N         同時に処理するアソシエーション数 (16)\n"
+           "  --assoc-ms MS           アソシエーションの基本遅延 (150)\n"
+           "  --assoc-per-sta-ms MS   同時処理1台あたりの追加遅延 (20)\n"
+           "  --dhcp-ms MS            DHCP の基本遅延 (300)\n"
+           "  --dhcp-concurrency N    DHCP の同時処理数 (8)\n"
+           "  --scan-ms MS            AP が見つからないときの再試行間隔 (2500)\n"
+           "  --detect-ms MS          切断検知までの時間 (3000、+0〜3000 のジッター)\n",
+           name);
+}
+
+bool parseOutage(const char* text, Outage& outage) {
+    unsigned long start = 0, duration = 0, boot = 0;
+    int n = sscanf(text, "%lu:%lu:%lu", &start, &duration, &boot);
+    if (n < 2) return false;
+    outage.startMs = static_cast<uint32_t>(start);
+    outage.durationMs = static_cast<uint32_t>(duration);
+    outage.bootMs = static_cast<uint32_t>(boot);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        uint32_t value = hasValue ? static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10)) : 0;
+        if (strcmp(arg, "--no-auto-portal") == 0) {
+            config.policy.autoPortal = false;
+            continue;
+        }
+        if (strcmp(arg, "--no-portal-retry") == 0) {
+            config.policy.retryInPortal = false;
+            continue;
+        }
+        if (!hasValue) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--outage") == 0) {
+            Outage outage;
+            if (!parseOutage(argv[i + 1], outage)) {
+                usage(argv[0]);
+                return 1;
+            }
+            config.outages.push_back(outage);
+        } else if (strcmp(arg, "--devices") == 0) {
+            config.devices = value;
+        } else if (strcmp(arg, "--duration") == 0) {
+            config.durationMs = value;
+        } else if (strcmp(arg, "--step") == 0) {
+            config.stepMs = value > 0 ? value : 1;
+        } else if (strcmp(arg, "--seed") == 0) {
+            config.seed = value;
+        } else if (strcmp(arg, "--attempts") == 0) {
+            config.policy.attemptsBeforePortal = static_cast<uint8_t>(value > 255 ? 255 : value);
+        } else if (strcmp(arg, "--retry-delay") == 0) {
+            config.policy.retryDelayMs = value;
+        } else if (strcmp(arg, "--portal-retry") == 0) {
+            config.policy.portalRetryIntervalMs = value;
+        } else if (strcmp(arg, "--portal-attempt") == 0) {
+            config.policy.portalAttemptMs = value;
+        } else if (strcmp(arg, "--capacity") == 0) {
+            config.capacity = value;
+        } else if (strcmp(arg, "--assoc-slots") == 0) {
+            config.assocSlots = value > 0 ? value : 1;
+        } else if (strcmp(arg, "--assoc-ms") == 0) {
+            config.assocMs = value;
+        } else if (strcmp(arg, "--assoc-per-sta-ms") == 0) {
+            config.assocPerStaMs = value;
+        } else if (strcmp(arg, "--dhcp-ms") == 0) {
+            config.dhcpMs = value;
+        } else if (strcmp(arg, "--dhcp-concurrency") == 0) {
+            config.dhcpConcurrency = value > 0 ? value : 1;
+        } else if (strcmp(arg, "--scan-ms") == 0) {
+            config.scanMs = value;
+        } else if (strcmp(arg, "--detect-ms") == 0) {
+            config.detectMs = value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+    if (config.outages.empty()) {
+        Outage outage;
+        outage.startMs = 60000;
+        outage.durationMs = 45000;
+        outage.bootMs = 5000;
+        config.outages.push_back(outage);
+    }
+    // 停止の開始時刻は刻みに揃える（applyOutages() は一致で判定する）
+    for (Outage& outage : config.outages) {
+        outage.startMs -= outage.startMs % config.stepMs;
+    }
+
+    FleetSim sim(config);
+    sim.run();
+    sim.report();
+    return 0;
+}
@@ -0,0 +1,185 @@
+// 起動プロファイル（BootProfile）の記録順序のテスト
+//
+// init() の各方式（Sequential / Deferred / ポータル起動）と、その後の再接続で
+// 呼ばれる順に markStart / markEnd / markGotIp を呼び、
+// 初回だけが記録されること、前後関係が ordered() で崩れていないことを確認する。
+// 時刻は仮想のもの（esp_timer_get_time() の代わりに直接渡す）。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -I. extras/host_tests/boot_profile_test.cpp -o boot_profile_test
+
+#include "SukenWiFiBootProfile.h"
+
+#include <cstdio>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+BootProfile startProfile() {
+    BootProfile profile;
+    profile.kind = BootKind::ColdBoot;
+    profile.initStartUs = 1000;
+    return profile;
+}
+
+// beginSequential(): マウント → 設定 → スキャン → 接続 → GOT_IP → mDNS
+void testSequential() {
+    BootProfile p = startProfile();
+    p.markStart(BootPhase::Mount, 1100);
+    p.markEnd(BootPhase::Mount, 40000);
+    p.markStart(BootPhase::SettingsLoad, 40000);
+    p.markEnd(BootPhase::SettingsLoad, 43000);
+    p.markStart(BootPhase::Scan, 43100);
+    p.markEnd(BootPhase::Scan, 2100000);
+    p.markStart(BootPhase::Associate, 2100100);
+    p.markEnd(BootPhase::Associate, 2600000);     // STA_CONNECTED
+    p.markStart(BootPhase::Dhcp, 2600000);
+    expect(p.markGotIp(2900000), "sequential: GOT_IP ends dhcp");
+    p.markStart(BootPhase::Mdns, 2900100);
+    p.markEnd(BootPhase::Mdns, 2950000);
+
+    expect(p.ordered(), "sequential: ordered");
+    expect(p.gotIpUs == 2900000, "sequential: gotIpUs");
+    expect(p.durationUs(BootPhase::Scan) == 2056900, "sequential: scan duration");
+    expect(p.durationUs(BootPhase::Dhcp) == 300000, "sequential: dhcp duration");
+    expect(p.durationUs(BootPhase::PortalStart) == 0, "sequential: portal not recorded");
+}
+
+// beginDeferred(): キャッシュ設定で接続を先に始め、その間にマウントと設定の読み込み
+void testDeferred() {
+    BootProfile p = startProfile();
+    p.markStart(BootPhase::Associate, 1200);
+    p.markStart(BootPhase::Mount, 1500);
+    p.markEnd(BootPhase::Mount, 38000);
+    p.markStart(BootPhase::SettingsLoad, 38000);
+    p.markEnd(BootPhase::Associate, 350000);      // 設定の読み込み中に STA_CONNECTED
+    p.markStart(BootPhase::Dhcp, 350000);
+    p.markEnd(BootPhase::SettingsLoad, 360000);
+    p.markGotIp(520000);
+
+    expect(p.ordered(), "deferred: ordered");
+    expect(p.durationUs(BootPhase::Associate) == 348800, "deferred: associate overlaps mount");
+}
+
+// RTC の接続記録から接続（マウントも設定の読み込みもしない）
+void testFastPath() {
+    BootProfile p = startProfile();
+    p.kind = BootKind::DeepSleepWake;
+    p.fastPath = true;
+    p.markStart(BootPhase::Associate, 1100);
+    p.markEnd(BootPhase::Associate, 90000);
+    p.markStart(BootPhase::Dhcp, 90000);
+    p.markGotIp(95000);
+
+    expect(p.ordered(), "fast path: ordered");
+    expect(p.phase(BootPhase::Mount).startUs < 0, "fast path: no mount");
+}
+
+// 接続後の切断と再接続は起動時の記録を上書きしない
+void testReconnectKeepsFirst() {
+    BootProfile p = startProfile();
+    p.markStart(BootPhase::Associate, 2000);
+    p.markEnd(BootPhase::Associate, 300000);
+    p.markStart(BootPhase::Dhcp, 300000);
+    p.markGotIp(400000);
+
+    // DISCONNECTED → 再接続
+    expect(!p.markStart(BootPhase::Associate, 9000000), "reconnect: associate start ignored");
+    expect(!p.markEnd(BootPhase::Associate, 9300000), "reconnect: associate end ignored");
+    expect(!p.markStart(BootPhase::Dhcp, 9300000), "reconnect: dhcp start ignored");
+    expect(!p.markGotIp(9400000), "reconnect: GOT_IP ignored");
+
+    expect(p.gotIpUs == 400000, "reconnect: first GOT_IP kept");
+    expect(p.phase(BootPhase::Associate).endUs == 300000, "reconnect: first associate kept");
+    expect(p.ordered(), "reconnect: ordered");
+}
+
+// 保存済み設定がなくポータルから始め、設定後に接続する
+void testPortalThenConnect() {
+    BootProfile p = startProfile();
+    p.markStart(BootPhase::Mount, 1100);
+    p.markEnd(BootPhase::Mount, 30000);
+    p.markStart(BootPhase::SettingsLoad, 30000);
+    p.markEnd(BootPhase::SettingsLoad, 31000);
+    p.markStart(BootPhase::Scan, 31000);
+    p.markEnd(BootPhase::Scan, 2000000);
+    p.markStart(BootPhase::PortalStart, 2000100);
+    p.markStart(BootPhase::Mdns, 2200000);        // ポータル用の mDNS
+    p.markEnd(BootPhase::Mdns, 2250000);
+    p.markEnd(BootPhase::PortalStart, 2300000);
+
+    // ポータルから設定を保存して接続
+    p.markStart(BootPhase::Associate, 60000000);
+    p.markEnd(BootPhase::Associate, 60400000);
+    p.markStart(BootPhase::Dhcp, 60400000);
+    p.markGotIp(60700000);
+    expect(!p.markStart(BootPhase::Mdns, 60700100), "portal: station mDNS does not overwrite");
+
+    expect(p.ordered(), "portal: ordered");
+    expect(p.durationUs(BootPhase::PortalStart) == 299900, "portal: portal duration");
+}
+
+// 手順が崩れた記録（RTC メモリの破損、計測箇所の入れ替えなど）は ordered() が検出する
+void testViolations() {
+    // 開始前に終了は記録できない
+    BootProfile p = startProfile();
+    expect(!p.markEnd(BootPhase::Dhcp, 5000), "violation: end without start rejected");
+    expect(!p.markGotIp(5000) && p.gotIpUs == 5000, "violation: GOT_IP without dhcp keeps time only");
+    expect(p.ordered(), "violation: GOT_IP without dhcp is still ordered");
+
+    BootProfile reversed = startProfile();
+    reversed.phases[static_cast<size_t>(BootPhase::Scan)].startUs = 5000;
+    reversed.phases[static_cast<size_t>(BootPhase::Scan)].endUs = 4000;
+    expect(!reversed.ordered(), "violation: end before start");
+
+    BootProfile settingsFirst = startProfile();
+    settingsFirst.markStart(BootPhase::SettingsLoad, 2000);
+    settingsFirst.markEnd(BootPhase::SettingsLoad, 3000);
+    settingsFirst.markStart(BootPhase::Mount, 3500);
+    settingsFirst.markEnd(BootPhase::Mount, 9000);
+    expect(!settingsFirst.ordered(), "violation: settings read before mount");
+
+    BootProfile dhcpFirst = startProfile();
+    dhcpFirst.markStart(BootPhase::Associate, 2000);
+    dhcpFirst.markStart(BootPhase::Dhcp, 2500);
+    dhcpFirst.markEnd(BootPhase::Associate, 3000);
+    expect(!dhcpFirst.ordered(), "violation: dhcp before association");
+
+    BootProfile beforeInit = startProfile();
+    beforeInit.markStart(BootPhase::Mount, 500);
+    expect(!beforeInit.ordered(), "violation: phase before init");
+
+    BootProfile orphanEnd = startProfile();
+    orphanEnd.phases[static_cast<size_t>(BootPhase::Mdns)].endUs = 7000;
+    expect(!orphanEnd.ordered(), "violation: end without start");
+
+    BootProfile earlyIp = startProfile();
+    earlyIp.markStart(BootPhase::Associate, 2000);
+    earlyIp.markEnd(BootPhase::Associate, 3000);
+    earlyIp.markStart(BootPhase::Dhcp, 3000);
+    earlyIp.gotIpUs = 2500;
+    expect(!earlyIp.ordered(), "violation: GOT_IP before dhcp");
+}
+
+} // namespace
+
+int main() {
+    testSequential();
+    testDeferred();
+    testFastPath();
+    testReconnectKeepsFirst();
+    testPortalThenConnect();
+    testViolations();
+    std::printf("%s\n", failures == 0 ? "boot_profile_test: all passed" : "boot_profile_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
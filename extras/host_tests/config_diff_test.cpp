@@ -0,0 +1,138 @@
+// 設定変更の差分判定（diffConfig）のテスト（examples/ConfigDiffCheck のホスト版）
+//
+// 変更の種類ごとに、保存・IP の再適用・IPv6 の有効化・再接続のうち必要なものだけが返ることを確認する。
+// ArduinoJson と IPAddress は stubs/ の代わりを使う。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/config_diff_test.cpp
+//       SukenWiFiConfigFields.cpp -o config_diff_test
+
+#include "SukenWiFiConfigFields.h"
+
+#include <cstdio>
+#include <initializer_list>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+ConfigActions bits(std::initializer_list<ConfigAction> actions) {
+    ConfigActions mask = 0;
+    for (ConfigAction action : actions) mask |= static_cast<uint8_t>(action);
+    return mask;
+}
+
+String describe(ConfigActions actions) {
+    JsonDocument doc;
+    configActionsToJson(actions, doc.createNestedArray("actions"));
+    String text;
+    serializeJson(doc, text);
+    return text;
+}
+
+void expectActions(const char* name, ConfigActions actual, ConfigActions expected) {
+    if (actual == expected) return;
+    failures++;
+    std::printf("FAIL %s: %s (expected %s)\n", name, describe(actual).c_str(), describe(expected).c_str());
+}
+
+WiFiCredentials storedCredentials() {
+    WiFiCredentials credentials;
+    credentials.ssid = "MyNetwork";
+    credentials.password = "secret123";
+    return credentials;
+}
+
+NetworkConfig storedConfig() {
+    NetworkConfig config;
+    config.useStaticIP = true;
+    config.staticIP = IPAddress(192, 168, 10, 50);
+    return config;
+}
+
+// 保存済みの設定（固定IP 192.168.10.50）からの変更
+void check(const char* name, const WiFiCredentials& credentials, const NetworkConfig& config, bool associated,
+           ConfigActions expected) {
+    expectActions(name, diffConfig(storedCredentials(), storedConfig(), credentials, config, associated), expected);
+}
+
+void testNetworkChanges() {
+    WiFiCredentials creds = storedCredentials();
+    NetworkConfig config = storedConfig();
+    check("unchanged", creds, config, true, 0);
+    check("unchanged, not connected", creds, config, false, bits({ConfigAction::Reconnect}));
+
+    NetworkConfig dns = config;
+    dns.primaryDNS = IPAddress(1, 1, 1, 1);
+    check("DNS only", creds, dns, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    NetworkConfig address = config;
+    address.staticIP = IPAddress(192, 168, 10, 60);
+    check("static IP only", creds, address, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    NetworkConfig dhcp = config;
+    dhcp.useStaticIP = false;
+    check("static -> DHCP", creds, dhcp, true, bits({ConfigAction::SaveNetwork, ConfigAction::ReapplyIP}));
+
+    // 固定IPが無効なままなら、固定IP用の値は比べない（JSON からも読まれない）
+    NetworkConfig unusedStatic = dhcp;
+    unusedStatic.gateway = IPAddress(10, 0, 0, 1);
+    expectActions("unused static field", diffConfig(creds, dhcp, creds, unusedStatic, true), 0);
+
+    NetworkConfig ipv6On = config;
+    ipv6On.enableIPv6 = true;
+    check("IPv6 on", creds, ipv6On, true, bits({ConfigAction::SaveNetwork, ConfigAction::EnableIPv6}));
+    // 接続し直すなら接続時に有効になる
+    check("IPv6 on, not connected", creds, ipv6On, false, bits({ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+    // 無効化は接続中に戻せないので接続し直す
+    expectActions("IPv6 off", diffConfig(creds, ipv6On, creds, config, true),
+                  bits({ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+}
+
+void testCredentialChanges() {
+    NetworkConfig config = storedConfig();
+    NetworkConfig ipv6On = config;
+    ipv6On.enableIPv6 = true;
+    NetworkConfig address = config;
+    address.staticIP = IPAddress(192, 168, 10, 60);
+
+    WiFiCredentials password = storedCredentials();
+    password.password = "changed456";
+    check("password", password, config, true, bits({ConfigAction::SaveCredentials, ConfigAction::Reconnect}));
+    check("password + IPv6 on", password, ipv6On, true,
+          bits({ConfigAction::SaveCredentials, ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+
+    WiFiCredentials ssid = storedCredentials();
+    ssid.ssid = "OtherNetwork";
+    check("SSID + static IP", ssid, address, true,
+          bits({ConfigAction::SaveCredentials, ConfigAction::SaveNetwork, ConfigAction::Reconnect}));
+
+    // 初回（保存済みの認証情報なし）
+    expectActions("first setup", diffConfig(WiFiCredentials(), NetworkConfig(), storedCredentials(), NetworkConfig(), false),
+                  bits({ConfigAction::SaveCredentials, ConfigAction::Reconnect}));
+}
+
+void testActionNames() {
+    String all = describe(bits({ConfigAction::SaveCredentials, ConfigAction::SaveNetwork, ConfigAction::ReapplyIP,
+                                ConfigAction::EnableIPv6, ConfigAction::Reconnect}));
+    if (all != "{\"actions\":[\"save_credentials\",\"save_network\",\"reapply_ip\",\"enable_ipv6\",\"reconnect\"]}") {
+        failures++;
+        std::printf("FAIL action names: %s\n", all.c_str());
+    }
+    if (describe(0) != "{\"actions\":[]}") {
+        failures++;
+        std::printf("FAIL no actions: %s\n", describe(0).c_str());
+    }
+}
+
+} // namespace
+
+int main() {
+    testNetworkChanges();
+    testCredentialChanges();
+    testActionNames();
+    std::printf("%s\n", failures == 0 ? "config_diff_test: all passed" : "config_diff_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
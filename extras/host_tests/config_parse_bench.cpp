@@ -0,0 +1,177 @@
+// 設定の読み込み速度の比較（examples/ConfigParseBenchmark のホスト版）
+//
+// ポータルから送られる JSON と設定ファイルの行を、以前の手書きの処理（containsKey と if の連鎖）と
+// 項目表（SukenWiFiConfigFields.h）から生成した処理でそれぞれ読み、結果が一致することを確認して
+// 1回あたりの時間を表示する。ArduinoJson と IPAddress は stubs/ の代わりを使うため、
+// 時間は ESP32 での値ではなく、両者の比較の目安として見る。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -O2 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/config_parse_bench.cpp
+//       SukenWiFiConfigFields.cpp -o config_parse_bench
+
+#include "SukenWiFiConfigFields.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+const char* PORTAL_JSON =
+    "{\"ssid\":\"MyNetwork\",\"password\":\"secret123\",\"useStaticIP\":true,"
+    "\"staticIP\":\"192.168.10.50\",\"gateway\":\"192.168.10.1\",\"subnet\":\"255.255.255.0\","
+    "\"primaryDNS\":\"1.1.1.1\",\"secondaryDNS\":\"1.0.0.1\",\"enableIPv6\":true}";
+
+const char* SETTINGS_LINES[][2] = {
+    {"useStaticIP", "true"},       {"staticIP", "192.168.10.50"}, {"gateway", "192.168.10.1"},
+    {"subnet", "255.255.255.0"},   {"primaryDNS", "1.1.1.1"},     {"secondaryDNS", "1.0.0.1"},
+    {"enableIPv6", "true"},
+};
+
+const int RUNS = 20000;
+
+// 以前の parseConfigJson() と同じ処理
+bool legacyParseJson(const JsonDocument& doc, WiFiCredentials& credentials, NetworkConfig& config) {
+    if (!doc.containsKey("ssid")) return false;
+    credentials.ssid = doc["ssid"].as<String>();
+    credentials.password = doc["password"] | "";
+    if (credentials.ssid.length() == 0 || credentials.ssid.length() > 32 || credentials.password.length() > 64) {
+        return false;
+    }
+    config = NetworkConfig();
+    config.enableIPv6 = doc["enableIPv6"] | false;
+    config.useStaticIP = doc["useStaticIP"] | false;
+    if (config.useStaticIP) {
+        if (doc.containsKey("staticIP") && !config.staticIP.fromString(doc["staticIP"].as<String>())) return false;
+        if (doc.containsKey("gateway") && !config.gateway.fromString(doc["gateway"].as<String>())) return false;
+        if (doc.containsKey("subnet") && !config.subnet.fromString(doc["subnet"].as<String>())) return false;
+        if (doc.containsKey("primaryDNS") && !config.primaryDNS.fromString(doc["primaryDNS"].as<String>())) return false;
+        if (doc.containsKey("secondaryDNS") && !config.secondaryDNS.fromString(doc["secondaryDNS"].as<String>())) return false;
+    }
+    return true;
+}
+
+// 以前の readNetworkSettings() の1行分
+void legacyDecodeLine(const String& key, const String& value, NetworkConfig& config) {
+    if (key.equals("useStaticIP")) {
+        config.useStaticIP = (value == "true");
+    } else if (key.equals("staticIP")) {
+        config.staticIP.fromString(value);
+    } else if (key.equals("gateway")) {
+        config.gateway.fromString(value);
+    } else if (key.equals("subnet")) {
+        config.subnet.fromString(value);
+    } else if (key.equals("primaryDNS")) {
+        config.primaryDNS.fromString(value);
+    } else if (key.equals("secondaryDNS")) {
+        config.secondaryDNS.fromString(value);
+    } else if (key.equals("enableIPv6")) {
+        config.enableIPv6 = (value == "true");
+    }
+}
+
+bool sameConfig(const NetworkConfig& a, const NetworkConfig& b) {
+    return encodeNetworkConfig(a) == encodeNetworkConfig(b);
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchJson() {
+    JsonDocument doc;
+    expect(!deserializeJson(doc, PORTAL_JSON), "json: parsed");
+
+    WiFiCredentials legacyCreds, tableCreds;
+    NetworkConfig legacyConfig, tableConfig;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; ++i) legacyParseJson(doc, legacyCreds, legacyConfig);
+    double legacyUs = elapsedUs(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; ++i) parseConfigFields(doc, tableCreds, tableConfig);
+    double tableUs = elapsedUs(start);
+
+    expect(sameConfig(legacyConfig, tableConfig), "json: same network config");
+    expect(legacyCreds.ssid == tableCreds.ssid && legacyCreds.password == tableCreds.password, "json: same credentials");
+    expect(tableConfig.useStaticIP && tableConfig.staticIP == IPAddress(192, 168, 10, 50) && tableConfig.enableIPv6,
+           "json: values read");
+    std::printf("JSON parse:  legacy=%.3fus table=%.3fus\n", legacyUs / RUNS, tableUs / RUNS);
+}
+
+void benchFile() {
+    // String の生成は両方に同じだけかかるので先に作っておく
+    const size_t lineCount = sizeof(SETTINGS_LINES) / sizeof(SETTINGS_LINES[0]);
+    String keys[lineCount], values[lineCount];
+    for (size_t k = 0; k < lineCount; ++k) {
+        keys[k] = SETTINGS_LINES[k][0];
+        values[k] = SETTINGS_LINES[k][1];
+    }
+    NetworkConfig legacyFile, tableFile;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; ++i) {
+        for (size_t k = 0; k < lineCount; ++k) legacyDecodeLine(keys[k], values[k], legacyFile);
+    }
+    double legacyUs = elapsedUs(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; ++i) {
+        for (size_t k = 0; k < lineCount; ++k) decodeNetworkLine(keys[k], values[k], tableFile);
+    }
+    double tableUs = elapsedUs(start);
+
+    expect(sameConfig(legacyFile, tableFile), "file: same network config");
+    std::printf("file decode: legacy=%.3fus table=%.3fus\n", legacyUs / RUNS, tableUs / RUNS);
+}
+
+// ポータルのフォームはスキーマから作るので、項目ごとに型と現在値が揃っていること
+void checkSchema() {
+    WiFiCredentials credentials;
+    credentials.ssid = "MyNetwork";
+    credentials.password = "secret123";
+    NetworkConfig config;
+    config.useStaticIP = true;
+    JsonDocument doc;
+    configSchemaToJson(credentials, config, doc);
+    String json;
+    serializeJson(doc, json);
+
+    // ポータルが受け取るのと同じく、文字列にしてから読み直す
+    JsonDocument parsed;
+    expect(!deserializeJson(parsed, json), "schema: serializes to valid JSON");
+    const JsonDocument& view = parsed;
+    JsonVariantConst fields = view["fields"];
+    size_t expected = sizeof(CREDENTIAL_FIELDS) / sizeof(CREDENTIAL_FIELDS[0]) + sizeof(NETWORK_FIELDS) / sizeof(NETWORK_FIELDS[0]);
+    expect(fields.size() == expected, "schema: one entry per field");
+    bool passwordHidden = false;
+    bool typesKnown = true;
+    bool staticValue = false;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        String key = fields[i]["key"].as<String>();
+        String type = fields[i]["type"].as<String>();
+        if (type != "text" && type != "bool" && type != "ipv4") typesKnown = false;
+        if (key == "password") passwordHidden = fields[i]["value"].isNull();
+        if (key == "staticIP") staticValue = fields[i]["value"].as<String>() == "192.168.1.200" && (fields[i]["staticOnly"] | false);
+    }
+    expect(typesKnown, "schema: known field types");
+    expect(passwordHidden, "schema: password value omitted");
+    expect(staticValue, "schema: current value and staticOnly for the form");
+}
+
+} // namespace
+
+int main() {
+    benchJson();
+    benchFile();
+    checkSchema();
+    std::printf("%s\n", failures == 0 ? "config_parse_bench: all passed" : "config_parse_bench: FAILED");
+    return failures == 0 ? 0 : 1;
+}
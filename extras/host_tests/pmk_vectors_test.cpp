@@ -0,0 +1,95 @@
+// PMK 計算（derivePmk）のテストとベンチマーク
+//
+// IEEE 802.11i（Annex H.4）の PBKDF2 テストベクタで derivePmk() と pmkToHex() を確かめ、
+// 範囲外の入力を拒否することと isHexPmk() の判定も確認する。
+// 最後に1回の計算時間を表示する（ESP32 での時間は examples/PmkBenchmark で測る）。
+// mbedtls は stubs/mbedtls の SHA-1 実装で代わりをする。テストベクタが一致すれば、
+// derivePmk() の引数（パスフレーズと SSID の順、長さ、反復回数）と代わりの実装の両方が正しい。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/pmk_vectors_test.cpp
+//       SukenWiFiPmk.cpp -o pmk_vectors_test
+
+#include "SukenWiFiPmk.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+struct PmkVector {
+    const char* passphrase;
+    const char* ssid;
+    const char* expected;
+};
+
+const PmkVector VECTORS[] = {
+    {"password", "IEEE", "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e"},
+    {"ThisIsAPassword", "ThisIsASSID", "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af"},
+};
+
+const int BENCH_RUNS = 20;
+
+void testVectors() {
+    for (const PmkVector& v : VECTORS) {
+        uint8_t pmk[PMK_LENGTH];
+        bool derived = derivePmk(v.ssid, v.passphrase, pmk);
+        expect(derived, v.ssid);
+        String hex = pmkToHex(pmk);
+        if (derived && hex != v.expected) {
+            std::printf("  ssid=%s got %s\n", v.ssid, hex.c_str());
+            expect(false, "vector: PMK matches");
+        }
+        expect(isHexPmk(hex), "vector: hex form recognized");
+    }
+}
+
+void testRejectsOutOfRange() {
+    uint8_t pmk[PMK_LENGTH];
+    expect(!derivePmk("", "password", pmk), "range: empty ssid");
+    expect(!derivePmk(String(std::string(33, 's').c_str()), "password", pmk), "range: ssid over 32 bytes");
+    expect(!derivePmk("IEEE", "short", pmk), "range: passphrase under 8");
+    expect(!derivePmk("IEEE", String(std::string(64, 'p').c_str()), pmk), "range: passphrase over 63");
+    expect(derivePmk(String(std::string(32, 's').c_str()), String(std::string(63, 'p').c_str()), pmk),
+           "range: longest accepted");
+}
+
+void testIsHexPmk() {
+    expect(!isHexPmk("password"), "hex: passphrase");
+    expect(!isHexPmk(String(std::string(63, 'a').c_str())), "hex: 63 digits");
+    expect(isHexPmk(String(std::string(64, 'A').c_str())), "hex: upper case");
+    expect(!isHexPmk(String((std::string(63, 'a') + "g").c_str())), "hex: non hex digit");
+}
+
+void benchmark() {
+    uint8_t pmk[PMK_LENGTH];
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RUNS; ++i) {
+        derivePmk("ThisIsASSID", "ThisIsAPassword", pmk);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::printf("pmk: %.2f ms per derivation (%d runs, 4096 iterations each)\n",
+                elapsed.count() / 1000.0 / BENCH_RUNS, BENCH_RUNS);
+}
+
+} // namespace
+
+int main() {
+    testVectors();
+    testRejectsOutOfRange();
+    testIsHexPmk();
+    benchmark();
+    std::printf("%s\n", failures == 0 ? "pmk_vectors_test: all passed" : "pmk_vectors_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
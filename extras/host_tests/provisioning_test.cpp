@@ -0,0 +1,185 @@
+// プロビジョニング方式（ProvisioningTransport）のテスト
+//
+// WiFi イベントを stubs/WiFi.h から送り、SmartConfig / WPS と独自の方式が
+// 受け取った認証情報をハンドラへ渡すまでを確認する。
+// - イベントタスクで受け取った値は poll() まで渡さず、渡すのは1回だけ
+// - 終端されていない固定長フィールド（SSID 32バイト、パスワード 64バイト）を切り詰める
+// - 停止するとイベントの登録を外し、未処理の値も捨てる
+// - WPS の受付時間切れでは受付をやり直し、成功すると STA の設定から認証情報を読む
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/provisioning_test.cpp
+//       SukenWiFiProvisioning.cpp -o provisioning_test
+
+#include "SukenWiFiProvisioning.h"
+#include "esp_wps.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+struct Delivery {
+    String source;
+    String ssid;
+    String password;
+};
+
+std::vector<Delivery> deliveries;
+
+void attach(ProvisioningTransport& transport) {
+    deliveries.clear();
+    transport.setHandler([](ProvisioningTransport& source, const String& ssid, const String& password) {
+        Delivery delivery;
+        delivery.source = source.name();
+        delivery.ssid = ssid;
+        delivery.password = password;
+        deliveries.push_back(delivery);
+    });
+}
+
+arduino_event_info_t smartConfigInfo(const char* ssid, const char* password) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    memcpy(info.sc_got_ssid_pswd.ssid, ssid, strnlen(ssid, sizeof(info.sc_got_ssid_pswd.ssid)));
+    memcpy(info.sc_got_ssid_pswd.password, password, strnlen(password, sizeof(info.sc_got_ssid_pswd.password)));
+    return info;
+}
+
+// README の「独自の方式」と同じ作り方
+class FakeTransport : public ProvisioningTransport {
+public:
+    const char* name() const override { return "Fake"; }
+    bool start() override { active_ = true; return true; }
+    void stop() override { active_ = false; }
+    bool isActive() const override { return active_; }
+    void inject(const String& ssid, const String& password) { deliver(ssid, password); }
+
+private:
+    bool active_ = false;
+};
+
+void testSmartConfigDeliversOnPoll() {
+    SmartConfigTransport transport;
+    attach(transport);
+    expect(transport.start(), "smartconfig: start");
+    expect(transport.isActive() && hostSmartConfig().running, "smartconfig: running");
+    expect(WiFi.handlerCount() == 1, "smartconfig: listening");
+
+    WiFi.hostEmit(ARDUINO_EVENT_WIFI_STA_CONNECTED, smartConfigInfo("other", "event"));
+    WiFi.hostEmit(ARDUINO_EVENT_SC_GOT_SSID_PSWD, smartConfigInfo("HomeNet", "secret123"));
+    expect(deliveries.empty(), "smartconfig: not delivered from the event task");
+    transport.poll();
+    expect(deliveries.size() == 1, "smartconfig: delivered on poll");
+    expect(deliveries.size() == 1 && deliveries[0].source == "SmartConfig" && deliveries[0].ssid == "HomeNet" &&
+               deliveries[0].password == "secret123",
+           "smartconfig: credentials passed through");
+    transport.poll();
+    expect(deliveries.size() == 1, "smartconfig: delivered once");
+
+    transport.stop();
+    expect(!transport.isActive() && !hostSmartConfig().running, "smartconfig: stopped");
+    expect(WiFi.handlerCount() == 0, "smartconfig: unlistened");
+}
+
+void testUnterminatedFields() {
+    SmartConfigTransport transport;
+    attach(transport);
+    transport.start();
+    // 32文字の SSID と 64文字のパスフレーズは終端文字なしで届く
+    std::string ssid(32, 's');
+    std::string password(64, 'p');
+    arduino_event_info_t info;
+    memset(&info, 'x', sizeof(info));
+    memcpy(info.sc_got_ssid_pswd.ssid, ssid.data(), ssid.size());
+    memcpy(info.sc_got_ssid_pswd.password, password.data(), password.size());
+    WiFi.hostEmit(ARDUINO_EVENT_SC_GOT_SSID_PSWD, info);
+    transport.poll();
+    expect(deliveries.size() == 1 && deliveries[0].ssid.str() == ssid, "unterminated: ssid cut at 32");
+    expect(deliveries.size() == 1 && deliveries[0].password.str() == password, "unterminated: password cut at 64");
+    transport.stop();
+}
+
+void testStopDropsPending() {
+    SmartConfigTransport transport;
+    attach(transport);
+    transport.start();
+    WiFi.hostEmit(ARDUINO_EVENT_SC_GOT_SSID_PSWD, smartConfigInfo("Late", "pass"));
+    transport.stop();
+    transport.poll();
+    expect(deliveries.empty(), "stop: pending credentials dropped");
+    WiFi.hostEmit(ARDUINO_EVENT_SC_GOT_SSID_PSWD, smartConfigInfo("After", "pass"));
+    transport.poll();
+    expect(deliveries.empty(), "stop: events after stop ignored");
+}
+
+void testSmartConfigStartFailure() {
+    hostSmartConfig().startResult = ESP_FAIL;
+    SmartConfigTransport transport;
+    expect(!transport.start(), "start failure: reported");
+    expect(!transport.isActive(), "start failure: inactive");
+    expect(WiFi.handlerCount() == 0, "start failure: not left listening");
+    hostSmartConfig().startResult = ESP_OK;
+}
+
+void testWpsRestartAndSuccess() {
+    hostWps() = HostWpsState();
+    WpsTransport transport;
+    attach(transport);
+    expect(transport.start(), "wps: start");
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+
+    // ボタンの受付時間切れ。セットアップモード中は受付をやり直す
+    WiFi.hostEmit(ARDUINO_EVENT_WPS_ER_TIMEOUT, info);
+    transport.poll();
+    expect(hostWps().enables == 2 && hostWps().enabled, "wps: restarted after timeout");
+    expect(transport.isActive() && deliveries.empty(), "wps: still waiting");
+
+    // 成功時の認証情報は STA の設定に入っている
+    memset(&hostStaConfig(), 0, sizeof(wifi_config_t));
+    memcpy(hostStaConfig().sta.ssid, "RouterNet", 9);
+    memcpy(hostStaConfig().sta.password, "wpspass", 7);
+    WiFi.hostEmit(ARDUINO_EVENT_WPS_ER_SUCCESS, info);
+    expect(deliveries.empty(), "wps: not delivered from the event task");
+    transport.poll();
+    expect(deliveries.size() == 1 && deliveries[0].source == "WPS" && deliveries[0].ssid == "RouterNet" &&
+               deliveries[0].password == "wpspass",
+           "wps: credentials read from station config");
+    expect(!transport.isActive() && !hostWps().enabled, "wps: finished");
+    expect(WiFi.handlerCount() == 0, "wps: unlistened");
+}
+
+void testCustomTransport() {
+    FakeTransport transport;
+    attach(transport);
+    transport.start();
+    transport.inject("Custom", "pw");
+    expect(deliveries.size() == 1 && deliveries[0].source == "Fake" && deliveries[0].ssid == "Custom" &&
+               deliveries[0].password == "pw",
+           "custom: deliver() reaches the handler");
+}
+
+} // namespace
+
+int main() {
+    testSmartConfigDeliversOnPoll();
+    testUnterminatedFields();
+    testStopDropsPending();
+    testSmartConfigStartFailure();
+    testWpsRestartAndSuccess();
+    testCustomTransport();
+    std::printf("%s\n", failures == 0 ? "provisioning_test: all passed" : "provisioning_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+// オフライン送信キュー（OfflineQueue）のリンク断続テスト
+//
+// 接続/切断を繰り返しながらアプリが enqueue() し、接続中はライブラリと同じ手順
+// （drainQueueBatch() → 失敗か空で syncFlash()）で送信する。送信は一定の割合で失敗させる。
+// 確認すること:
+// - 取りこぼしも重複もない（最後に残りを送り切ると、送信済み = enqueue した分）
+// - 送信順が enqueue の順（送信に失敗した分は次の接続で先頭から送る）
+// - 切断中の enqueue が1件ごとにフラッシュへ書かれない（まとめ書き）
+// - 切断中の再起動で、保存済みの分が順番どおりに復元される
+// - 書き込みに失敗した分は未保存のまま残り、次の呼び出しで書かれる
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/queue_flap_test.cpp
+//       SukenWiFiQueue.cpp SukenWiFiStore.cpp -o queue_flap_test
+
+#include "SukenWiFiQueue.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+// 再現性のため固定シードの線形合同法
+uint32_t randomState = 12345;
+uint32_t nextRandom(uint32_t range) {
+    randomState = randomState * 1103515245u + 12345u;
+    return (randomState >> 8) % range;
+}
+
+OfflineQueueConfig makeConfig() {
+    OfflineQueueConfig config;
+    config.capacity = 256;
+    config.batchSize = 4;
+    config.persistToFlash = true;
+    config.persistBatchSize = 8;
+    config.persistIntervalMs = 60000;
+    return config;
+}
+
+// SukenESPWiFi::drainQueueBatch() と同じ手順。続きがあれば true
+bool drainBatch(OfflineQueue& queue, const OfflineQueueConfig& config, std::vector<int>& delivered, int failPercent) {
+    uint8_t sent = 0;
+    String payload;
+    while (sent < config.batchSize && queue.peek(payload)) {
+        if (static_cast<int>(nextRandom(100)) < failPercent) {
+            queue.countSendFailure();
+            return false;
+        }
+        delivered.push_back(payload.toInt());
+        queue.pop();
+        queue.countFlushed();
+        sent++;
+    }
+    return queue.size() > 0;
+}
+
+void testLinkFlap() {
+    SPIFFS.hostFormat();
+    SPIFFS.hostStats() = fs::HostFsStats();
+    ConfigStore store;
+    OfflineQueue queue;
+    OfflineQueueConfig config = makeConfig();
+    config.capacity = 4096;   // 取りこぼしの確認なので溢れさせない
+    queue.configure(config, &store);
+
+    std::vector<int> delivered;
+    int next = 0;
+    int offlineItems = 0;
+    for (int cycle = 0; cycle < 200; ++cycle) {
+        // 切断中: 数秒おきにテレメトリを積む
+        int items = static_cast<int>(nextRandom(20));
+        for (int i = 0; i < items; ++i) {
+            hostAdvanceMillis(1000 + nextRandom(4000));
+            queue.push(String(next++), true);
+            offlineItems++;
+        }
+        // 接続: 1件以上送れるか失敗するまでバッチで送信し、最後にフラッシュを合わせる
+        bool more = true;
+        while (more) {
+            more = drainBatch(queue, config, delivered, 15);
+            hostAdvanceMillis(config.batchIntervalMs);
+            if (!more) break;
+            // 送信の途中で切れることもある
+            if (nextRandom(10) == 0) break;
+        }
+        queue.syncFlash();
+        // 接続中の enqueue はフラッシュに書かない
+        int online = static_cast<int>(nextRandom(3));
+        for (int i = 0; i < online; ++i) queue.push(String(next++), false);
+    }
+
+    // 最後に全部送る
+    while (queue.size() > 0) drainBatch(queue, config, delivered, 0);
+
+    bool inOrder = true;
+    for (size_t i = 1; i < delivered.size(); ++i) {
+        if (delivered[i] != delivered[i - 1] + 1) inOrder = false;
+    }
+    expect(static_cast<int>(delivered.size()) == next, "flap: every payload delivered once");
+    expect(inOrder, "flap: delivered in enqueue order");
+
+    OfflineQueueStats stats = queue.stats();
+    expect(stats.dropped == 0, "flap: nothing dropped");
+    // 1件ごとに追記していた頃は offlineItems 回開いていた
+    uint32_t appendWrites = SPIFFS.hostStats().opensForWrite;
+    std::printf("flap: %d offline items, %u flash writes (%u queue writes)\n", offlineItems,
+                static_cast<unsigned>(appendWrites), static_cast<unsigned>(stats.flashWrites));
+    expect(appendWrites * 3 < static_cast<uint32_t>(offlineItems), "flap: offline items are batched");
+}
+
+// 切断中に再起動（deepSleep() などで未保存分を書いてから）
+void testRestoreAfterForcedSave() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    OfflineQueueConfig config = makeConfig();
+    {
+        OfflineQueue queue;
+        queue.configure(config, &store);
+        for (int i = 0; i < 13; ++i) {
+            hostAdvanceMillis(1000);
+            queue.push(String(i), true);
+        }
+        expect(queue.stats().unsaved == 5, "restore: 8 saved, 5 waiting");
+        queue.persistPending(millis(), true);
+        expect(queue.stats().unsaved == 0, "restore: forced save");
+    }
+    ConfigStore rebootedStore;
+    OfflineQueue restored;
+    restored.configure(config, &rebootedStore);
+    restored.loadFlash();
+    expect(restored.size() == 13, "restore: all items back");
+    String payload;
+    bool inOrder = true;
+    for (int i = 0; i < 13; ++i) {
+        if (!restored.peek(payload) || payload.toInt() != i) inOrder = false;
+        restored.pop();
+    }
+    expect(inOrder, "restore: order kept");
+}
+
+// 書く前に電源が落ちた場合、失われるのはまとめ書き待ちの分だけ
+void testPowerLossLosesOnlyUnsaved() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    OfflineQueueConfig config = makeConfig();
+    {
+        OfflineQueue queue;
+        queue.configure(config, &store);
+        for (int i = 0; i < 19; ++i) {
+            hostAdvanceMillis(1000);
+            queue.push(String(i), true);
+        }
+    }
+    ConfigStore rebootedStore;
+    OfflineQueue restored;
+    restored.configure(config, &rebootedStore);
+    restored.loadFlash();
+    expect(restored.size() == 16, "power loss: batches of 8 kept, 3 lost");
+    String payload;
+    expect(restored.peek(payload) && payload == "0", "power loss: oldest kept");
+}
+
+// 件数に満たなくても時間が経てば書く
+void testIntervalFlush() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    OfflineQueueConfig config = makeConfig();
+    OfflineQueue queue;
+    queue.configure(config, &store);
+    queue.push("a", true);
+    queue.push("b", true);
+    expect(!SPIFFS.exists("/offline_queue.txt"), "interval: not yet written");
+    hostAdvanceMillis(config.persistIntervalMs);
+    queue.persistPending(millis(), false);
+    expect(SPIFFS.hostRead("/offline_queue.txt") == "1:a\n1:b\n", "interval: written after interval");
+}
+
+// フラッシュに書けなかった分は保存済みにしない
+void testFailedAppendKeepsUnsaved() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    OfflineQueueConfig config = makeConfig();
+    OfflineQueue queue;
+    queue.configure(config, &store);
+    queue.push("a", true);
+    SPIFFS.hostFailWrites(true);
+    queue.persistPending(millis(), true);
+    SPIFFS.hostFailWrites(false);
+    OfflineQueueStats stats = queue.stats();
+    expect(stats.unsaved == 1 && stats.flashWrites == 0, "failed append: still unsaved");
+    queue.push("b", true);
+    queue.persistPending(millis(), true);
+    stats = queue.stats();
+    expect(stats.unsaved == 0 && stats.flashWrites == 1, "failed append: saved on retry");
+    expect(SPIFFS.hostRead("/offline_queue.txt") == "1:a\n1:b\n", "failed append: nothing lost");
+    expect(store.stats().writes == 1, "failed append: written through the store");
+}
+
+} // namespace
+
+int main() {
+    testLinkFlap();
+    testRestoreAfterForcedSave();
+    testPowerLossLosesOnlyUnsaved();
+    testIntervalFlush();
+    testFailedAppendKeepsUnsaved();
+    std::printf("%s\n", failures == 0 ? "queue_flap_test: all passed" : "queue_flap_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# ホスト（PC）上で動くテストをまとめてビルドして実行する
+# 使い方（リポジトリのルートで）: sh extras/host_tests/run_tests.sh
+#
+# ESP32 や Arduino コアは不要。g++ だけで動くように、ライブラリのうちハードウェアに
+# 依存しない部分（状態機械、記録の形式など）を直接ビルドする。
+# Arduino コアの String や SPIFFS などは stubs/ の最小限の代わりを使う。
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+OUT=${OUT:-"$ROOT/extras/host_tests/build"}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-std=c++11 -O2 -Wall"}
+
+mkdir -p "$OUT"
+cd "$ROOT"
+
+run() {
+    name=$1
+    shift
+    echo "== $name"
+    $CXX $CXXFLAGS -Iextras/host_tests/stubs -I. "$@" -o "$OUT/$name"
+    "$OUT/$name"
+}
+
+run boot_profile_test extras/host_tests/boot_profile_test.cpp
+run store_test extras/host_tests/store_test.cpp SukenWiFiStore.cpp
+run queue_flap_test extras/host_tests/queue_flap_test.cpp SukenWiFiQueue.cpp SukenWiFiStore.cpp
+run provisioning_test extras/host_tests/provisioning_test.cpp SukenWiFiProvisioning.cpp
+run pmk_vectors_test extras/host_tests/pmk_vectors_test.cpp SukenWiFiPmk.cpp
+run config_parse_bench extras/host_tests/config_parse_bench.cpp SukenWiFiConfigFields.cpp
+run config_diff_test extras/host_tests/config_diff_test.cpp SukenWiFiConfigFields.cpp
+
+echo "all host tests passed"
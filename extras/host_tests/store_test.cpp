@@ -0,0 +1,117 @@
+// ConfigStore（SPIFFS への書き込みを減らす永続化レイヤ）のテスト
+//
+// 同じ内容の書き込みの省略、トランザクションでのまとめ書き、追記型ログの圧縮と、
+// 圧縮の途中で電源が落ちた場合に次の起動で最新の値が残ることを確認する。
+// ロックはトランザクションの間だけ持ち続け、それ以外の操作では必ず返すことも確かめる。
+// SPIFFS はメモリ上のもの（stubs/FS.h）を使う。
+//
+// ビルド（リポジトリのルートで）:
+//   g++ -std=c++11 -Wall -Iextras/host_tests/stubs -I. extras/host_tests/store_test.cpp SukenWiFiStore.cpp -o store_test
+
+#include "SukenWiFiStore.h"
+
+#include <cstdio>
+
+using namespace SukenWiFiLib;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* name) {
+    if (!condition) {
+        failures++;
+        std::printf("FAIL %s\n", name);
+    }
+}
+
+const char* LOG_PATH = "/lease_log.txt";
+
+void testSkipUnchanged() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    expect(store.write("/a.txt", "one"), "skip: first write");
+    expect(store.write("/a.txt", "one"), "skip: same content");
+    StoreStats stats = store.stats();
+    expect(stats.writes == 1 && stats.skippedWrites == 1, "skip: counted once");
+}
+
+void testTransaction() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    store.beginTransaction();
+    expect(store.inTransaction(), "transaction: in transaction");
+    store.write("/a.txt", "first");
+    store.write("/a.txt", "second");
+    store.write("/b.txt", "other");
+    expect(!SPIFFS.exists("/a.txt"), "transaction: nothing written before commit");
+    expect(hostRecursiveLockDepth() == 1, "transaction: lock held until commit");
+    store.beginTransaction();
+    expect(store.commit() && store.inTransaction(), "transaction: nested commit keeps it open");
+    expect(hostRecursiveLockDepth() == 1, "transaction: nested commit returns its lock");
+    expect(store.commit(), "transaction: commit");
+    expect(hostRecursiveLockDepth() == 0, "transaction: lock released");
+    expect(store.commit() && hostRecursiveLockDepth() == 0, "transaction: extra commit is harmless");
+    expect(!store.inTransaction(), "transaction: closed");
+    expect(SPIFFS.hostRead("/a.txt") == "second", "transaction: last content wins");
+    expect(store.stats().writes == 2, "transaction: one write per file");
+}
+
+// ログを圧縮の閾値まで伸ばす
+void fillLog(ConfigStore& store, int rounds) {
+    for (int i = 0; i < rounds; ++i) {
+        store.append(LOG_PATH, "ip", String("192.168.1.") + String(i % 200));
+        store.append(LOG_PATH, "expires", String(100000 + i));
+    }
+}
+
+void testCompaction() {
+    SPIFFS.hostFormat();
+    ConfigStore store;
+    fillLog(store, 120);
+    expect(store.stats().compactions > 0, "compaction: ran");
+    expect(!SPIFFS.exists("/lease_log.txt.tmp"), "compaction: no temp file left");
+
+    ConfigStore reopened;
+    String value;
+    expect(reopened.readLog(LOG_PATH, "ip", value) && value == "192.168.1.119", "compaction: latest ip kept");
+    expect(reopened.readLog(LOG_PATH, "expires", value) && value == "100119", "compaction: latest expiry kept");
+}
+
+// 元のログを消した直後（rename の前）に電源が落ちた
+void testPowerLossAfterRemove() {
+    SPIFFS.hostFormat();
+    SPIFFS.hostWrite("/lease_log.txt.tmp", "ip=10.0.0.7\nexpires=555\n");
+
+    ConfigStore store;
+    String value;
+    expect(store.readLog(LOG_PATH, "ip", value) && value == "10.0.0.7", "power loss after remove: value recovered");
+    expect(SPIFFS.exists(LOG_PATH), "power loss after remove: log restored");
+    expect(!SPIFFS.exists("/lease_log.txt.tmp"), "power loss after remove: temp file consumed");
+}
+
+// 一時ファイルを書いている途中で電源が落ちた
+void testPowerLossDuringTempWrite() {
+    SPIFFS.hostFormat();
+    SPIFFS.hostWrite(LOG_PATH, "ip=10.0.0.1\nip=10.0.0.2\nexpires=777\n");
+    SPIFFS.hostWrite("/lease_log.txt.tmp", "ip=10.0.0.2\nexp");
+
+    ConfigStore store;
+    String value;
+    expect(store.readLog(LOG_PATH, "ip", value) && value == "10.0.0.2", "power loss during temp: old log used");
+    expect(store.readLog(LOG_PATH, "expires", value) && value == "777", "power loss during temp: nothing lost");
+    expect(!SPIFFS.exists("/lease_log.txt.tmp"), "power loss during temp: partial temp removed");
+}
+
+} // namespace
+
+int main() {
+    testSkipUnchanged();
+    testTransaction();
+    testCompaction();
+    testPowerLossAfterRemove();
+    testPowerLossDuringTempWrite();
+    expect(hostRecursiveLockDepth() == 0, "lock: released after every operation");
+    std::printf("%s\n", failures == 0 ? "store_test: all passed" : "store_test: FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+// ホスト上のテスト用の Arduino コアの代わり（テストで使う部分だけ）
+// String は std::string で、millis() は仮想時計（hostAdvanceMillis() で進める）で動く。
+// FreeRTOS の mutex は何もしない（テストは1スレッドで動かす）
+#ifndef SUKEN_WIFI_HOST_ARDUINO_H
+#define SUKEN_WIFI_HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* text) : s_(text ? text : "") {}
+    String(const std::string& text) : s_(text) {}
+    explicit String(char c) : s_(1, c) {}
+    String(int value) : s_(std::to_string(value)) {}
+    String(unsigned int value) : s_(std::to_string(value)) {}
+    String(long value) : s_(std::to_string(value)) {}
+    String(unsigned long value) : s_(std::to_string(value)) {}
+    String(long long value) : s_(std::to_string(value)) {}
+    String(unsigned long long value) : s_(std::to_string(value)) {}
+    String(double value, unsigned char decimals = 2) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        s_ = buffer;
+    }
+
+    unsigned int length() const { return static_cast<unsigned int>(s_.size()); }
+    bool isEmpty() const { return s_.empty(); }
+    const char* c_str() const { return s_.c_str(); }
+    bool reserve(unsigned int size) { s_.reserve(size); return true; }
+
+    String& operator+=(const String& other) { s_ += other.s_; return *this; }
+    String& operator+=(const char* other) { s_ += other; return *this; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    bool concat(const String& other) { s_ += other.s_; return true; }
+    bool concat(const char* text, unsigned int length) { s_.append(text, length); return true; }
+    bool concat(char c) { s_ += c; return true; }
+
+    bool operator==(const String& other) const { return s_ == other.s_; }
+    bool operator!=(const String& other) const { return s_ != other.s_; }
+    bool operator==(const char* other) const { return s_ == (other ? other : ""); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s_ < other.s_; }
+    bool equals(const String& other) const { return s_ == other.s_; }
+    bool equalsIgnoreCase(const String& other) const {
+        if (s_.size() != other.s_.size()) return false;
+        for (size_t i = 0; i < s_.size(); ++i) {
+            if (tolower(static_cast<unsigned char>(s_[i])) != tolower(static_cast<unsigned char>(other.s_[i]))) return false;
+        }
+        return true;
+    }
+
+    char charAt(unsigned int index) const { return index < s_.size() ? s_[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return s_[index]; }
+    void setCharAt(unsigned int index, char c) { if (index < s_.size()) s_[index] = c; }
+
+    int indexOf(char c, unsigned int from = 0) const { return position(s_.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return position(s_.find(text.s_, from)); }
+    int lastIndexOf(char c) const { return position(s_.rfind(c)); }
+    bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s_.size() >= suffix.s_.size() && s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+    }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= s_.size()) return String();
+        return String(s_.substr(from, to - from));
+    }
+
+    void trim() {
+        size_t begin = 0;
+        while (begin < s_.size() && isspace(static_cast<unsigned char>(s_[begin]))) begin++;
+        size_t end = s_.size();
+        while (end > begin && isspace(static_cast<unsigned char>(s_[end - 1]))) end--;
+        s_ = s_.substr(begin, end - begin);
+    }
+    void toLowerCase() { for (auto& c : s_) c = static_cast<char>(tolower(static_cast<unsigned char>(c))); }
+    void toUpperCase() { for (auto& c : s_) c = static_cast<char>(toupper(static_cast<unsigned char>(c))); }
+    void replace(const String& from, const String& to) {
+        if (from.s_.empty()) return;
+        size_t pos = 0;
+        while ((pos = s_.find(from.s_, pos)) != std::string::npos) {
+            s_.replace(pos, from.s_.size(), to.s_);
+            pos += to.s_.size();
+        }
+    }
+    void remove(unsigned int index) { if (index < s_.size()) s_.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s_.size()) s_.erase(index, count); }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+    const std::string& str() const { return s_; }
+
+private:
+    static int position(size_t pos) { return pos == std::string::npos ? -1 : static_cast<int>(pos); }
+
+    std::string s_;
+};
+
+inline String operator+(const String& a, const String& b) { return String(a.str() + b.str()); }
+inline String operator+(const String& a, const char* b) { return String(a.str() + b); }
+inline String operator+(const char* a, const String& b) { return String(a + b.str()); }
+inline String operator+(const String& a, char b) { return String(a.str() + b); }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* data, size_t size) = 0;
+    size_t print(const String& text) { return write(reinterpret_cast<const uint8_t*>(text.c_str()), text.length()); }
+    size_t print(const char* text) { return print(String(text)); }
+    size_t print(char c) { return print(String(c)); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t println(const String& text) { return print(text) + print("\n"); }
+    size_t println(const char* text) { return println(String(text)); }
+    size_t println(int value) { return println(String(value)); }
+    size_t println(unsigned int value) { return println(String(value)); }
+    size_t println(long value) { return println(String(value)); }
+    size_t println(unsigned long value) { return println(String(value)); }
+    size_t println() { return print("\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (n < 0) return 0;
+        return write(reinterpret_cast<const uint8_t*>(buffer), strlen(buffer));
+    }
+};
+
+// ライブラリのログ。HOST_SERIAL_VERBOSE=1 の環境変数で表示する（既定は捨てる）
+class HostSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(const uint8_t* data, size_t size) override {
+        static const bool verbose = getenv("HOST_SERIAL_VERBOSE") != nullptr;
+        if (verbose) fwrite(data, 1, size, stdout);
+        return size;
+    }
+};
+
+static HostSerial Serial;
+
+// 仮想時計
+inline uint32_t& hostMillis() {
+    static uint32_t now = 0;
+    return now;
+}
+inline void hostAdvanceMillis(uint32_t ms) { hostMillis() += ms; }
+inline unsigned long millis() { return hostMillis(); }
+inline void delay(unsigned long ms) { hostAdvanceMillis(static_cast<uint32_t>(ms)); }
+inline int64_t esp_timer_get_time() { return static_cast<int64_t>(hostMillis()) * 1000; }
+
+// FreeRTOS（1スレッドで動かすので何もしない）
+typedef void* SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+#define portMAX_DELAY 0xffffffffUL
+#define pdTRUE 1
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return reinterpret_cast<SemaphoreHandle_t>(1); }
+inline int xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline int xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+inline void vSemaphoreDelete(SemaphoreHandle_t) {}
+// 再帰ミューテックスは取得の深さだけ数える（取り忘れ・返し忘れの確認用）
+inline int& hostRecursiveLockDepth() {
+    static int depth = 0;
+    return depth;
+}
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return reinterpret_cast<SemaphoreHandle_t>(2); }
+inline int xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) { hostRecursiveLockDepth()++; return pdTRUE; }
+inline int xSemaphoreGiveRecursive(SemaphoreHandle_t) { hostRecursiveLockDepth()--; return pdTRUE; }
+
+#endif // SUKEN_WIFI_HOST_ARDUINO_H
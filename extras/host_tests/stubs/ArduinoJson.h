@@ -0,0 +1,418 @@
+#ifndef SUKEN_WIFI_HOST_ARDUINOJSON_H
+#define SUKEN_WIFI_HOST_ARDUINOJSON_H
+
+// ArduinoJson（v7 の書き方）のうち、設定の項目表（SukenWiFiConfigFields.cpp）が使う部分の代わり
+// 値は木構造で持ち、deserializeJson() / serializeJson() は JSON の文字列と相互に変換する
+#include <Arduino.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct HostJsonNode {
+    enum Type { Null, Bool, Number, Text, Array, Object };
+    Type type = Null;
+    bool flag = false;
+    double number = 0;
+    std::string text;
+    std::vector<std::shared_ptr<HostJsonNode>> items;
+    std::vector<std::pair<std::string, std::shared_ptr<HostJsonNode>>> members;
+
+    const HostJsonNode* find(const char* key) const {
+        if (type != Object) return nullptr;
+        for (const auto& member : members) {
+            if (member.first == key) return member.second.get();
+        }
+        return nullptr;
+    }
+
+    // 無ければ追加する（オブジェクトでなければオブジェクトにする）
+    HostJsonNode* member(const char* key) {
+        if (type != Object) {
+            *this = HostJsonNode();
+            type = Object;
+        }
+        for (auto& entry : members) {
+            if (entry.first == key) return entry.second.get();
+        }
+        members.push_back(std::make_pair(std::string(key), std::make_shared<HostJsonNode>()));
+        return members.back().second.get();
+    }
+
+    HostJsonNode* append() {
+        if (type != Array) {
+            *this = HostJsonNode();
+            type = Array;
+        }
+        items.push_back(std::make_shared<HostJsonNode>());
+        return items.back().get();
+    }
+
+    void setText(const std::string& value) {
+        *this = HostJsonNode();
+        type = Text;
+        text = value;
+    }
+    void setBool(bool value) {
+        *this = HostJsonNode();
+        type = Bool;
+        flag = value;
+    }
+    void setNumber(double value) {
+        *this = HostJsonNode();
+        type = Number;
+        number = value;
+    }
+};
+
+class JsonObject;
+class JsonArray;
+
+class JsonVariantConst {
+public:
+    JsonVariantConst(const HostJsonNode* node = nullptr) : node_(node) {}
+
+    bool isNull() const { return !node_ || node_->type == HostJsonNode::Null; }
+    JsonVariantConst operator[](const char* key) const { return JsonVariantConst(node_ ? node_->find(key) : nullptr); }
+    JsonVariantConst operator[](size_t index) const {
+        return JsonVariantConst(node_ && index < node_->items.size() ? node_->items[index].get() : nullptr);
+    }
+    size_t size() const {
+        if (!node_) return 0;
+        return node_->type == HostJsonNode::Array ? node_->items.size() : node_->members.size();
+    }
+    bool containsKey(const char* key) const { return node_ && node_->find(key); }
+
+    template <typename T>
+    T as() const;
+
+    bool operator|(bool fallback) const { return node_ && node_->type == HostJsonNode::Bool ? node_->flag : fallback; }
+    int operator|(int fallback) const {
+        return node_ && node_->type == HostJsonNode::Number ? static_cast<int>(node_->number) : fallback;
+    }
+    const char* operator|(const char* fallback) const {
+        return node_ && node_->type == HostJsonNode::Text ? node_->text.c_str() : fallback;
+    }
+
+    const HostJsonNode* node() const { return node_; }
+
+private:
+    const HostJsonNode* node_;
+};
+
+template <>
+inline String JsonVariantConst::as<String>() const {
+    if (isNull()) return String("null");
+    if (node_->type == HostJsonNode::Text) return String(node_->text);
+    if (node_->type == HostJsonNode::Bool) return String(node_->flag ? "true" : "false");
+    if (node_->type == HostJsonNode::Number) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", node_->number);
+        return String(buffer);
+    }
+    return String();
+}
+template <>
+inline bool JsonVariantConst::as<bool>() const { return *this | false; }
+template <>
+inline int JsonVariantConst::as<int>() const { return *this | 0; }
+template <>
+inline const char* JsonVariantConst::as<const char*>() const { return *this | static_cast<const char*>(nullptr); }
+
+class JsonVariant {
+public:
+    explicit JsonVariant(HostJsonNode* node = nullptr) : node_(node) {}
+
+    JsonVariant& operator=(bool value) { node_->setBool(value); return *this; }
+    JsonVariant& operator=(int value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(unsigned int value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(long value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(unsigned long value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(uint8_t value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(double value) { node_->setNumber(value); return *this; }
+    JsonVariant& operator=(const char* value) { node_->setText(value ? value : ""); return *this; }
+    JsonVariant& operator=(const String& value) { node_->setText(value.str()); return *this; }
+
+    JsonVariant operator[](const char* key) { return JsonVariant(node_->member(key)); }
+    operator JsonVariantConst() const { return JsonVariantConst(node_); }
+
+    bool isNull() const { return JsonVariantConst(node_).isNull(); }
+    template <typename T>
+    T as() const { return JsonVariantConst(node_).as<T>(); }
+    bool operator|(bool fallback) const { return JsonVariantConst(node_) | fallback; }
+    int operator|(int fallback) const { return JsonVariantConst(node_) | fallback; }
+    const char* operator|(const char* fallback) const { return JsonVariantConst(node_) | fallback; }
+
+private:
+    HostJsonNode* node_;
+};
+
+class JsonObject {
+public:
+    explicit JsonObject(HostJsonNode* node = nullptr) : node_(node) {
+        if (node_ && node_->type != HostJsonNode::Object) {
+            *node_ = HostJsonNode();
+            node_->type = HostJsonNode::Object;
+        }
+    }
+    JsonVariant operator[](const char* key) const { return JsonVariant(node_->member(key)); }
+    bool isNull() const { return !node_; }
+    size_t size() const { return node_ ? node_->members.size() : 0; }
+
+private:
+    HostJsonNode* node_;
+};
+
+class JsonArray {
+public:
+    explicit JsonArray(HostJsonNode* node = nullptr) : node_(node) {
+        if (node_ && node_->type != HostJsonNode::Array) {
+            *node_ = HostJsonNode();
+            node_->type = HostJsonNode::Array;
+        }
+    }
+    JsonObject createNestedObject() const { return JsonObject(node_->append()); }
+    bool add(const char* value) const { node_->append()->setText(value ? value : ""); return true; }
+    bool add(const String& value) const { node_->append()->setText(value.str()); return true; }
+    bool add(int value) const { node_->append()->setNumber(value); return true; }
+    JsonVariantConst operator[](size_t index) const {
+        return JsonVariantConst(node_ && index < node_->items.size() ? node_->items[index].get() : nullptr);
+    }
+    bool isNull() const { return !node_; }
+    size_t size() const { return node_ ? node_->items.size() : 0; }
+
+private:
+    HostJsonNode* node_;
+};
+
+class JsonDocument {
+public:
+    JsonDocument() : root_(std::make_shared<HostJsonNode>()) {}
+    JsonDocument(const JsonDocument& other) : root_(std::make_shared<HostJsonNode>(*other.root_)) {}
+    JsonDocument& operator=(const JsonDocument& other) {
+        root_ = std::make_shared<HostJsonNode>(*other.root_);
+        return *this;
+    }
+
+    JsonVariant operator[](const char* key) { return JsonVariant(root_->member(key)); }
+    JsonVariantConst operator[](const char* key) const { return JsonVariantConst(root_->find(key)); }
+    bool containsKey(const char* key) const { return root_->find(key) != nullptr; }
+    bool isNull() const { return root_->type == HostJsonNode::Null; }
+    void clear() { *root_ = HostJsonNode(); }
+
+    JsonArray createNestedArray(const char* key) { return JsonArray(root_->member(key)); }
+    JsonObject createNestedObject(const char* key) { return JsonObject(root_->member(key)); }
+
+    HostJsonNode& root() { return *root_; }
+    const HostJsonNode& root() const { return *root_; }
+
+private:
+    std::shared_ptr<HostJsonNode> root_;
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, InvalidInput, EmptyInput };
+    DeserializationError(Code code = Ok) : code_(code) {}
+    explicit operator bool() const { return code_ != Ok; }
+    const char* c_str() const {
+        switch (code_) {
+            case Ok: return "Ok";
+            case EmptyInput: return "EmptyInput";
+            default: return "InvalidInput";
+        }
+    }
+
+private:
+    Code code_;
+};
+
+namespace HostJson {
+
+class Parser {
+public:
+    explicit Parser(const char* text) : p_(text) {}
+
+    bool parseDocument(HostJsonNode& out) {
+        if (!parseValue(out)) return false;
+        skipSpace();
+        return *p_ == '\0';
+    }
+
+private:
+    void skipSpace() {
+        while (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n') ++p_;
+    }
+
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if (strncmp(p_, word, n) != 0) return false;
+        p_ += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (*p_ != '"') return false;
+        ++p_;
+        out.clear();
+        while (*p_ != '"') {
+            if (*p_ == '\0') return false;
+            if (*p_ == '\\') {
+                ++p_;
+                switch (*p_) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    default: return false;   // \u は設定の値に出てこないので扱わない
+                }
+                ++p_;
+            } else {
+                out += *p_++;
+            }
+        }
+        ++p_;
+        return true;
+    }
+
+    bool parseValue(HostJsonNode& out) {
+        skipSpace();
+        if (*p_ == '{') {
+            ++p_;
+            out = HostJsonNode();
+            out.type = HostJsonNode::Object;
+            skipSpace();
+            if (*p_ == '}') { ++p_; return true; }
+            for (;;) {
+                skipSpace();
+                std::string key;
+                if (!parseString(key)) return false;
+                skipSpace();
+                if (*p_++ != ':') return false;
+                if (!parseValue(*out.member(key.c_str()))) return false;
+                skipSpace();
+                if (*p_ == ',') { ++p_; continue; }
+                if (*p_ == '}') { ++p_; return true; }
+                return false;
+            }
+        }
+        if (*p_ == '[') {
+            ++p_;
+            out = HostJsonNode();
+            out.type = HostJsonNode::Array;
+            skipSpace();
+            if (*p_ == ']') { ++p_; return true; }
+            for (;;) {
+                if (!parseValue(*out.append())) return false;
+                skipSpace();
+                if (*p_ == ',') { ++p_; continue; }
+                if (*p_ == ']') { ++p_; return true; }
+                return false;
+            }
+        }
+        if (*p_ == '"') {
+            std::string text;
+            if (!parseString(text)) return false;
+            out.setText(text);
+            return true;
+        }
+        if (literal("true")) { out.setBool(true); return true; }
+        if (literal("false")) { out.setBool(false); return true; }
+        if (literal("null")) { out = HostJsonNode(); return true; }
+        char* end = nullptr;
+        double value = strtod(p_, &end);
+        if (end == p_) return false;
+        p_ = end;
+        out.setNumber(value);
+        return true;
+    }
+
+    const char* p_;
+};
+
+inline void writeString(const std::string& text, std::string& out) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c;
+        }
+    }
+    out += '"';
+}
+
+inline void write(const HostJsonNode& node, std::string& out) {
+    switch (node.type) {
+        case HostJsonNode::Null: out += "null"; break;
+        case HostJsonNode::Bool: out += node.flag ? "true" : "false"; break;
+        case HostJsonNode::Number: {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.15g", node.number);
+            out += buffer;
+            break;
+        }
+        case HostJsonNode::Text: writeString(node.text, out); break;
+        case HostJsonNode::Array:
+            out += '[';
+            for (size_t i = 0; i < node.items.size(); ++i) {
+                if (i > 0) out += ',';
+                write(*node.items[i], out);
+            }
+            out += ']';
+            break;
+        case HostJsonNode::Object:
+            out += '{';
+            for (size_t i = 0; i < node.members.size(); ++i) {
+                if (i > 0) out += ',';
+                writeString(node.members[i].first, out);
+                out += ':';
+                write(*node.members[i].second, out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+} // namespace HostJson
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* json) {
+    doc.clear();
+    if (!json || *json == '\0') return DeserializationError::EmptyInput;
+    HostJson::Parser parser(json);
+    if (!parser.parseDocument(doc.root())) {
+        doc.clear();
+        return DeserializationError::InvalidInput;
+    }
+    return DeserializationError::Ok;
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& json) {
+    return deserializeJson(doc, json.c_str());
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& out) {
+    std::string text;
+    HostJson::write(doc.root(), text);
+    out = String(text);
+    return text.size();
+}
+
+inline size_t serializeJson(const JsonDocument& doc, char* buffer, size_t size) {
+    std::string text;
+    HostJson::write(doc.root(), text);
+    if (size == 0) return 0;
+    size_t n = text.size() < size - 1 ? text.size() : size - 1;
+    memcpy(buffer, text.data(), n);
+    buffer[n] = '\0';
+    return n;
+}
+
+#endif // SUKEN_WIFI_HOST_ARDUINOJSON_H
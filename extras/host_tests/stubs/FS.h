@@ -0,0 +1,119 @@
+// ホスト上のテスト用のファイルシステム（メモリ上）
+// SPIFFS と同じく、rename() は既存のファイルを上書きしない。
+// 書き込み回数と書き込んだバイト数を数え、フラッシュの消耗を比べられるようにする。
+// hostFailWrites(true) の間は書き込み用に開けない（フラッシュが一杯の場合など）
+#ifndef SUKEN_WIFI_HOST_FS_H
+#define SUKEN_WIFI_HOST_FS_H
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+struct HostFsStats {
+    uint32_t opensForWrite = 0;    // "w" / "a" で開いた回数
+    uint32_t bytesWritten = 0;
+};
+
+class HostFileData {
+public:
+    std::string content;
+};
+
+class File : public Print {
+public:
+    File() {}
+    File(std::shared_ptr<HostFileData> data, bool writable, HostFsStats* stats)
+        : data_(data), writable_(writable), stats_(stats) {}
+
+    explicit operator bool() const { return static_cast<bool>(data_); }
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!data_ || !writable_) return 0;
+        data_->content.append(reinterpret_cast<const char*>(data), size);
+        stats_->bytesWritten += size;
+        return size;
+    }
+    int available() const { return data_ ? static_cast<int>(data_->content.size() - pos_) : 0; }
+    size_t size() const { return data_ ? data_->content.size() : 0; }
+    String readString() {
+        if (!data_) return String();
+        String rest(data_->content.substr(pos_));
+        pos_ = data_->content.size();
+        return rest;
+    }
+    String readStringUntil(char terminator) {
+        if (!data_) return String();
+        size_t end = data_->content.find(terminator, pos_);
+        if (end == std::string::npos) return readString();
+        String line(data_->content.substr(pos_, end - pos_));
+        pos_ = end + 1;
+        return line;
+    }
+    void close() { data_.reset(); }
+
+private:
+    std::shared_ptr<HostFileData> data_;
+    bool writable_ = false;
+    HostFsStats* stats_ = nullptr;
+    size_t pos_ = 0;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = "r") {
+        std::string key(path);
+        auto it = files_.find(key);
+        if (mode[0] == 'r') {
+            if (it == files_.end()) return File();
+            return File(it->second, false, &stats_);
+        }
+        if (failWrites_) return File();
+        stats_.opensForWrite++;
+        if (it == files_.end() || mode[0] == 'w') {
+            // 開いているハンドルの内容は変えない（SPIFFS と同じく新しいファイルになる）
+            files_[key] = std::make_shared<HostFileData>();
+        }
+        return File(files_[key], true, &stats_);
+    }
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char* path) const { return files_.count(path) > 0; }
+    bool exists(const String& path) const { return exists(path.c_str()); }
+    bool remove(const char* path) { return files_.erase(path) > 0; }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to) {
+        auto it = files_.find(from);
+        if (it == files_.end() || files_.count(to)) return false;
+        files_[to] = it->second;
+        files_.erase(from);
+        return true;
+    }
+    bool begin(bool = false) { return true; }
+
+    // テスト用
+    void hostFormat() { files_.clear(); }
+    std::string hostRead(const char* path) const {
+        auto it = files_.find(path);
+        return it == files_.end() ? std::string() : it->second->content;
+    }
+    void hostWrite(const char* path, const std::string& content) {
+        files_[path] = std::make_shared<HostFileData>();
+        files_[path]->content = content;
+    }
+    HostFsStats& hostStats() { return stats_; }
+    void hostFailWrites(bool fail) { failWrites_ = fail; }
+
+private:
+    std::map<std::string, std::shared_ptr<HostFileData>> files_;
+    HostFsStats stats_;
+    bool failWrites_ = false;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // SUKEN_WIFI_HOST_FS_H
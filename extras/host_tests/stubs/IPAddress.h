@@ -0,0 +1,55 @@
+#ifndef SUKEN_WIFI_HOST_IPADDRESS_H
+#define SUKEN_WIFI_HOST_IPADDRESS_H
+
+#include <Arduino.h>
+
+// Arduino コアの IPAddress（IPv4 のみ）の代わり
+class IPAddress {
+public:
+    IPAddress() { memset(bytes_, 0, sizeof(bytes_)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        bytes_[0] = a;
+        bytes_[1] = b;
+        bytes_[2] = c;
+        bytes_[3] = d;
+    }
+
+    // コアと同じく、4つの 0〜255 の数をドットで区切った形だけを受け付ける
+    bool fromString(const char* text) {
+        uint8_t parsed[4];
+        int part = 0;
+        int value = -1;
+        for (const char* p = text; ; ++p) {
+            if (*p >= '0' && *p <= '9') {
+                value = (value < 0 ? 0 : value) * 10 + (*p - '0');
+                if (value > 255) return false;
+            } else if (*p == '.' || *p == '\0') {
+                if (value < 0 || part > 3) return false;
+                parsed[part++] = static_cast<uint8_t>(value);
+                value = -1;
+                if (*p == '\0') break;
+            } else {
+                return false;
+            }
+        }
+        if (part != 4) return false;
+        memcpy(bytes_, parsed, sizeof(bytes_));
+        return true;
+    }
+    bool fromString(const String& text) { return fromString(text.c_str()); }
+
+    String toString() const {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+        return String(buffer);
+    }
+
+    uint8_t operator[](int index) const { return bytes_[index]; }
+    bool operator==(const IPAddress& other) const { return memcmp(bytes_, other.bytes_, sizeof(bytes_)) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+private:
+    uint8_t bytes_[4];
+};
+
+#endif // SUKEN_WIFI_HOST_IPADDRESS_H
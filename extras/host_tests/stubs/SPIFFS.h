@@ -0,0 +1,12 @@
+#ifndef SUKEN_WIFI_HOST_SPIFFS_H
+#define SUKEN_WIFI_HOST_SPIFFS_H
+
+#include <FS.h>
+
+inline fs::FS& hostSpiffs() {
+    static fs::FS spiffs;
+    return spiffs;
+}
+#define SPIFFS hostSpiffs()
+
+#endif // SUKEN_WIFI_HOST_SPIFFS_H
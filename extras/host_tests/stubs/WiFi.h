@@ -0,0 +1,59 @@
+#ifndef SUKEN_WIFI_HOST_WIFI_H
+#define SUKEN_WIFI_HOST_WIFI_H
+
+// WiFi イベントの登録部分だけの代わり。テストは hostEmit() でイベントを送る
+#include <Arduino.h>
+#include <esp_smartconfig.h>
+#include <esp_wifi.h>
+
+#include <functional>
+#include <map>
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 0,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WPS_ER_SUCCESS,
+    ARDUINO_EVENT_WPS_ER_FAILED,
+    ARDUINO_EVENT_WPS_ER_TIMEOUT,
+    ARDUINO_EVENT_SC_GOT_SSID_PSWD,
+    ARDUINO_EVENT_PROV_CRED_RECV,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef union {
+    smartconfig_event_got_ssid_pswd_t sc_got_ssid_pswd;
+    wifi_sta_config_t prov_cred_recv;
+} arduino_event_info_t;
+
+typedef size_t wifi_event_id_t;
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+class HostWiFi {
+public:
+    wifi_event_id_t onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+        (void)event;
+        handlers_[++lastId_] = cb;
+        return lastId_;
+    }
+    void removeEvent(wifi_event_id_t id) { handlers_.erase(id); }
+    size_t handlerCount() const { return handlers_.size(); }
+
+    // イベントタスクからの通知の代わり
+    void hostEmit(arduino_event_id_t event, const arduino_event_info_t& info) {
+        std::map<wifi_event_id_t, WiFiEventFuncCb> handlers = handlers_;
+        for (auto& entry : handlers) entry.second(event, info);
+    }
+
+private:
+    std::map<wifi_event_id_t, WiFiEventFuncCb> handlers_;
+    wifi_event_id_t lastId_ = 0;
+};
+
+// 翻訳単位をまたいで同じものを使う
+inline HostWiFi& hostWiFi() {
+    static HostWiFi wifi;
+    return wifi;
+}
+#define WiFi hostWiFi()
+
+#endif // SUKEN_WIFI_HOST_WIFI_H
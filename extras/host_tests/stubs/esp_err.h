@@ -0,0 +1,9 @@
+#ifndef SUKEN_WIFI_HOST_ESP_ERR_H
+#define SUKEN_WIFI_HOST_ESP_ERR_H
+
+// ESP-IDF のエラーコードのうちテストで使うもの
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#endif // SUKEN_WIFI_HOST_ESP_ERR_H
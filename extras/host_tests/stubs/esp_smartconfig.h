@@ -0,0 +1,43 @@
+#ifndef SUKEN_WIFI_HOST_ESP_SMARTCONFIG_H
+#define SUKEN_WIFI_HOST_ESP_SMARTCONFIG_H
+
+#include <esp_err.h>
+#include <stdint.h>
+
+typedef enum { SC_TYPE_ESPTOUCH = 0, SC_TYPE_AIRKISS, SC_TYPE_ESPTOUCH_AIRKISS } smartconfig_type_t;
+
+typedef struct {
+    bool enable_log;
+} smartconfig_start_config_t;
+#define SMARTCONFIG_START_CONFIG_DEFAULT() { false }
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    bool bssid_set;
+    uint8_t bssid[6];
+    smartconfig_type_t type;
+} smartconfig_event_got_ssid_pswd_t;
+
+// 呼び出しの記録と失敗の注入
+struct HostSmartConfigState {
+    bool running = false;
+    esp_err_t startResult = ESP_OK;
+};
+inline HostSmartConfigState& hostSmartConfig() {
+    static HostSmartConfigState state;
+    return state;
+}
+
+inline esp_err_t esp_smartconfig_set_type(smartconfig_type_t) { return ESP_OK; }
+inline esp_err_t esp_smartconfig_start(const smartconfig_start_config_t*) {
+    if (hostSmartConfig().startResult != ESP_OK) return hostSmartConfig().startResult;
+    hostSmartConfig().running = true;
+    return ESP_OK;
+}
+inline esp_err_t esp_smartconfig_stop() {
+    hostSmartConfig().running = false;
+    return ESP_OK;
+}
+
+#endif // SUKEN_WIFI_HOST_ESP_SMARTCONFIG_H
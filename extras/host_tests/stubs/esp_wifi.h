@@ -0,0 +1,30 @@
+#ifndef SUKEN_WIFI_HOST_ESP_WIFI_H
+#define SUKEN_WIFI_HOST_ESP_WIFI_H
+
+#include <esp_err.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP } wifi_interface_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+// テストが設定する STA の設定（WPS で受け取った認証情報の代わり）
+inline wifi_config_t& hostStaConfig() {
+    static wifi_config_t config;
+    return config;
+}
+
+inline esp_err_t esp_wifi_get_config(wifi_interface_t, wifi_config_t* conf) {
+    *conf = hostStaConfig();
+    return ESP_OK;
+}
+
+#endif // SUKEN_WIFI_HOST_ESP_WIFI_H
@@ -0,0 +1,34 @@
+#ifndef SUKEN_WIFI_HOST_ESP_WPS_H
+#define SUKEN_WIFI_HOST_ESP_WPS_H
+
+#include <esp_err.h>
+
+typedef enum { WPS_TYPE_DISABLE = 0, WPS_TYPE_PBC, WPS_TYPE_PIN } wps_type_t;
+
+typedef struct {
+    wps_type_t wps_type;
+} esp_wps_config_t;
+#define WPS_CONFIG_INIT_DEFAULT(type) { type }
+
+// 呼び出しの記録（enable の回数で受付の再開を確認する）
+struct HostWpsState {
+    bool enabled = false;
+    int enables = 0;
+};
+inline HostWpsState& hostWps() {
+    static HostWpsState state;
+    return state;
+}
+
+inline esp_err_t esp_wifi_wps_enable(const esp_wps_config_t*) {
+    hostWps().enabled = true;
+    hostWps().enables++;
+    return ESP_OK;
+}
+inline esp_err_t esp_wifi_wps_start(int) { return ESP_OK; }
+inline esp_err_t esp_wifi_wps_disable() {
+    hostWps().enabled = false;
+    return ESP_OK;
+}
+
+#endif // SUKEN_WIFI_HOST_ESP_WPS_H
@@ -0,0 +1,129 @@
+#ifndef SUKEN_WIFI_HOST_MBEDTLS_MD_H
+#define SUKEN_WIFI_HOST_MBEDTLS_MD_H
+
+// mbedtls の md API のうち PMK 計算で使う部分（SHA-1 の HMAC のみ）の代わり
+// ホストに mbedtls がなくても SukenWiFiPmk.cpp をそのままビルドできるようにする
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA1 = 4 } mbedtls_md_type_t;
+
+struct mbedtls_md_info_t {
+    mbedtls_md_type_t type;
+};
+
+struct HostSha1 {
+    uint32_t h[5];
+    uint64_t length;
+    uint8_t block[64];
+    size_t used;
+};
+
+typedef struct {
+    const mbedtls_md_info_t* md_info;
+    int hmac;
+} mbedtls_md_context_t;
+
+inline uint32_t hostSha1Rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+inline void hostSha1Block(HostSha1& s, const uint8_t* p) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (uint32_t(p[i * 4]) << 24) | (uint32_t(p[i * 4 + 1]) << 16) | (uint32_t(p[i * 4 + 2]) << 8) | p[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; ++i) w[i] = hostSha1Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = s.h[0], b = s.h[1], c = s.h[2], d = s.h[3], e = s.h[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+        uint32_t t = hostSha1Rotl(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = hostSha1Rotl(b, 30); b = a; a = t;
+    }
+    s.h[0] += a; s.h[1] += b; s.h[2] += c; s.h[3] += d; s.h[4] += e;
+}
+
+inline void hostSha1Init(HostSha1& s) {
+    static const uint32_t init[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    memcpy(s.h, init, sizeof(init));
+    s.length = 0;
+    s.used = 0;
+}
+
+inline void hostSha1Update(HostSha1& s, const uint8_t* data, size_t len) {
+    s.length += len;
+    while (len > 0) {
+        size_t n = 64 - s.used < len ? 64 - s.used : len;
+        memcpy(s.block + s.used, data, n);
+        s.used += n;
+        data += n;
+        len -= n;
+        if (s.used == 64) {
+            hostSha1Block(s, s.block);
+            s.used = 0;
+        }
+    }
+}
+
+inline void hostSha1Final(HostSha1& s, uint8_t out[20]) {
+    uint64_t bits = s.length * 8;
+    uint8_t pad = 0x80;
+    hostSha1Update(s, &pad, 1);
+    pad = 0;
+    while (s.used != 56) hostSha1Update(s, &pad, 1);
+    uint8_t len[8];
+    for (int i = 0; i < 8; ++i) len[i] = uint8_t(bits >> (56 - i * 8));
+    hostSha1Update(s, len, 8);
+    for (int i = 0; i < 20; ++i) out[i] = uint8_t(s.h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+inline void hostHmacSha1(const uint8_t* key, size_t keyLen, const uint8_t* data, size_t dataLen, uint8_t out[20]) {
+    uint8_t k[64] = {0};
+    if (keyLen > 64) {
+        HostSha1 s;
+        hostSha1Init(s);
+        hostSha1Update(s, key, keyLen);
+        hostSha1Final(s, k);
+    } else {
+        memcpy(k, key, keyLen);
+    }
+    uint8_t ipad[64], opad[64];
+    for (int i = 0; i < 64; ++i) {
+        ipad[i] = k[i] ^ 0x36;
+        opad[i] = k[i] ^ 0x5c;
+    }
+    uint8_t inner[20];
+    HostSha1 s;
+    hostSha1Init(s);
+    hostSha1Update(s, ipad, 64);
+    hostSha1Update(s, data, dataLen);
+    hostSha1Final(s, inner);
+    hostSha1Init(s);
+    hostSha1Update(s, opad, 64);
+    hostSha1Update(s, inner, 20);
+    hostSha1Final(s, out);
+}
+
+inline void mbedtls_md_init(mbedtls_md_context_t* ctx) {
+    ctx->md_info = nullptr;
+    ctx->hmac = 0;
+}
+
+inline void mbedtls_md_free(mbedtls_md_context_t* ctx) { ctx->md_info = nullptr; }
+
+inline const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    static const mbedtls_md_info_t sha1 = {MBEDTLS_MD_SHA1};
+    return type == MBEDTLS_MD_SHA1 ? &sha1 : nullptr;
+}
+
+inline int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac) {
+    if (!info) return -1;
+    ctx->md_info = info;
+    ctx->hmac = hmac;
+    return 0;
+}
+
+#endif // SUKEN_WIFI_HOST_MBEDTLS_MD_H
@@ -0,0 +1,35 @@
+#ifndef SUKEN_WIFI_HOST_MBEDTLS_PKCS5_H
+#define SUKEN_WIFI_HOST_MBEDTLS_PKCS5_H
+
+// mbedtls_pkcs5_pbkdf2_hmac() の代わり（PBKDF2-HMAC-SHA1、RFC 2898）
+#include "mbedtls/md.h"
+
+inline int mbedtls_pkcs5_pbkdf2_hmac(mbedtls_md_context_t* ctx, const unsigned char* password, size_t plen,
+                                     const unsigned char* salt, size_t slen, unsigned int iterations,
+                                     uint32_t keyLength, unsigned char* output) {
+    if (!ctx->md_info || !ctx->hmac || ctx->md_info->type != MBEDTLS_MD_SHA1 || slen > 64) return -1;
+    uint32_t counter = 1;
+    while (keyLength > 0) {
+        uint8_t message[68];
+        memcpy(message, salt, slen);
+        message[slen] = uint8_t(counter >> 24);
+        message[slen + 1] = uint8_t(counter >> 16);
+        message[slen + 2] = uint8_t(counter >> 8);
+        message[slen + 3] = uint8_t(counter);
+        uint8_t u[20], t[20];
+        hostHmacSha1(password, plen, message, slen + 4, u);
+        memcpy(t, u, 20);
+        for (unsigned int i = 1; i < iterations; ++i) {
+            hostHmacSha1(password, plen, u, 20, u);
+            for (int j = 0; j < 20; ++j) t[j] ^= u[j];
+        }
+        uint32_t n = keyLength < 20 ? keyLength : 20;
+        memcpy(output, t, n);
+        output += n;
+        keyLength -= n;
+        counter++;
+    }
+    return 0;
+}
+
+#endif // SUKEN_WIFI_HOST_MBEDTLS_PKCS5_H
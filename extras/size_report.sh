@@ -0,0 +1,50 @@
+#!/bin/sh
+# ビルドプロファイルごとのサイズ比較
+# SukenWiFiConfig.h の機能フラグを変えてスケッチをビルドし、フラッシュと静的RAMの使用量を表にする。
+#
+# 使い方: extras/size_report.sh [スケッチのディレクトリ] [FQBN]
+#   既定は examples/WiFi と esp32:esp32:esp32。arduino-cli と esp32 コアが必要。
+#   結果は標準出力と size_report.md に書く。
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SKETCH=${1:-$ROOT/examples/WiFi}
+FQBN=${2:-esp32:esp32:esp32}
+OUT=${SIZE_REPORT_OUT:-size_report.md}
+BUILD_ROOT=$(mktemp -d)
+trap 'rm -rf "$BUILD_ROOT"' EXIT
+
+# 名前|フラグ
+PROFILES="full|
+no-http|-DSUKEN_WIFI_HTTP_CLIENT=0
+no-mdns|-DSUKEN_WIFI_MDNS=0
+minimal|-DSUKEN_WIFI_HTTP_CLIENT=0 -DSUKEN_WIFI_MDNS=0"
+
+{
+    echo "# SukenESPWiFi size report"
+    echo
+    echo "sketch: $(basename "$SKETCH"), board: $FQBN"
+    echo
+    echo "| profile | flags | flash (bytes) | static RAM (bytes) |"
+    echo "|---|---|---:|---:|"
+} > "$OUT"
+
+echo "$PROFILES" | while IFS='|' read -r NAME FLAGS; do
+    LOG="$BUILD_ROOT/$NAME.log"
+    # ライブラリの .cpp にも同じ値が見えるよう、スケッチではなくビルドプロパティで渡す
+    if ! arduino-cli compile --fqbn "$FQBN" --library "$ROOT" \
+            --build-path "$BUILD_ROOT/$NAME" \
+            --build-property "compiler.cpp.extra_flags=$FLAGS" \
+            --build-property "compiler.c.extra_flags=$FLAGS" \
+            "$SKETCH" > "$LOG" 2>&1; then
+        echo "build failed: $NAME (see below)" >&2
+        cat "$LOG" >&2
+        exit 1
+    fi
+    FLASH=$(sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p' "$LOG")
+    RAM=$(sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p' "$LOG")
+    echo "| $NAME | ${FLAGS:--} | $FLASH | $RAM |" >> "$OUT"
+done
+
+cat "$OUT"